@@ -0,0 +1,317 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "buffer_mgr.h"
+
+// Offline replay of a buffer pool trace written by startPoolTrace.
+// Usage: bm_sim <traceFile> [poolSize ...]
+// Without pool sizes the trace is replayed for 1, 2, 4, ... frames up to the number of distinct pages.
+// For every strategy and pool size the miss ratio is printed, one row per pool size.
+
+// Structure representing a frame of the simulated buffer pool.
+typedef struct SimFrame {
+    PageNumber pageNum; // Page held by the frame, NO_PAGE if the frame is empty.
+    int fixCount; // Number of pins not yet unpinned.
+    long loadTime; // Time the page was loaded (FIFO).
+    long lastUse; // Time of the most recent pin (LRU, LRU-K, LFU).
+    long prevUse; // Time of the pin before the most recent one, -1 if there was none (LRU-K with K = 2).
+    long refCount; // Number of pins since the page was loaded (LFU).
+    int refBit; // Reference bit (CLOCK).
+} SimFrame;
+
+// Structure representing a simulated buffer pool.
+typedef struct SimPool {
+    SimFrame *frames;
+    int numFrames;
+    int *pageToFrame; // Frame of every page, -1 if the page is not resident.
+    int clockHand; // Next frame inspected by CLOCK.
+    long time; // Logical time, advanced on every pin.
+    long pins;
+    long misses;
+} SimPool;
+
+// A replacement strategy returns the frame to evict among the unpinned frames, or -1 if all are pinned.
+typedef int (*ChooseVictim)(SimPool *pool);
+
+typedef struct SimStrategy {
+    char *name;
+    ChooseVictim chooseVictim;
+} SimStrategy;
+
+// This function evicts the page that was loaded first.
+int chooseFIFO(SimPool *pool)
+{
+    int victim = -1;
+    for (int i = 0; i < pool->numFrames; i++)
+    {
+        if (pool->frames[i].fixCount == 0 && (victim == -1 || pool->frames[i].loadTime < pool->frames[victim].loadTime))
+            victim = i;
+    }
+    return victim;
+}
+
+// This function evicts the page that was used least recently.
+int chooseLRU(SimPool *pool)
+{
+    int victim = -1;
+    for (int i = 0; i < pool->numFrames; i++)
+    {
+        if (pool->frames[i].fixCount == 0 && (victim == -1 || pool->frames[i].lastUse < pool->frames[victim].lastUse))
+            victim = i;
+    }
+    return victim;
+}
+
+// This function gives every referenced page a second chance before evicting it.
+int chooseCLOCK(SimPool *pool)
+{
+    // Two sweeps clear every reference bit, so an unpinned frame is found if there is one
+    for (int steps = 0; steps < 2 * pool->numFrames; steps++)
+    {
+        SimFrame *frame = &pool->frames[pool->clockHand];
+        int index = pool->clockHand;
+        pool->clockHand = (pool->clockHand + 1) % pool->numFrames;
+
+        if (frame->fixCount != 0)
+            continue;
+        if (frame->refBit == 0)
+            return index;
+        frame->refBit = 0;
+    }
+    return -1;
+}
+
+// This function evicts the page whose second most recent use is the oldest (LRU-K with K = 2).
+// Pages used only once since they were loaded go first, among them the least recently used one.
+int chooseLRUK(SimPool *pool)
+{
+    int victim = -1;
+    for (int i = 0; i < pool->numFrames; i++)
+    {
+        SimFrame *frame = &pool->frames[i];
+        if (frame->fixCount != 0)
+            continue;
+        if (victim == -1 || frame->prevUse < pool->frames[victim].prevUse ||
+            (frame->prevUse == pool->frames[victim].prevUse && frame->lastUse < pool->frames[victim].lastUse))
+            victim = i;
+    }
+    return victim;
+}
+
+// This function evicts the page with the fewest uses, the least recently used one on ties.
+int chooseLFU(SimPool *pool)
+{
+    int victim = -1;
+    for (int i = 0; i < pool->numFrames; i++)
+    {
+        SimFrame *frame = &pool->frames[i];
+        if (frame->fixCount != 0)
+            continue;
+        if (victim == -1 || frame->refCount < pool->frames[victim].refCount ||
+            (frame->refCount == pool->frames[victim].refCount && frame->lastUse < pool->frames[victim].lastUse))
+            victim = i;
+    }
+    return victim;
+}
+
+// Strategies that are replayed, new strategies only need an entry here.
+SimStrategy strategies[] = {
+    { "FIFO", chooseFIFO },
+    { "LRU", chooseLRU },
+    { "CLOCK", chooseCLOCK },
+    { "LRU-K", chooseLRUK },
+    { "LFU", chooseLFU },
+};
+
+#define NUM_STRATEGIES ((int) (sizeof(strategies) / sizeof(strategies[0])))
+
+// This function handles a pin of the trace.
+void simulatePin(SimPool *pool, SimStrategy *strategy, PageNumber pageNum)
+{
+    pool->time++;
+    pool->pins++;
+
+    int index = pool->pageToFrame[pageNum];
+    if (index == -1)
+    {
+        pool->misses++;
+
+        // Use an empty frame if there is one, otherwise ask the strategy for a victim
+        for (int i = 0; i < pool->numFrames && index == -1; i++)
+        {
+            if (pool->frames[i].pageNum == NO_PAGE)
+                index = i;
+        }
+        if (index == -1)
+            index = strategy->chooseVictim(pool);
+
+        // Every frame is pinned, the page is read without being cached
+        if (index == -1)
+            return;
+
+        SimFrame *frame = &pool->frames[index];
+        if (frame->pageNum != NO_PAGE)
+            pool->pageToFrame[frame->pageNum] = -1;
+
+        memset(frame, 0, sizeof(SimFrame));
+        frame->pageNum = pageNum;
+        frame->loadTime = pool->time;
+        frame->prevUse = -1;
+        frame->lastUse = -1;
+        pool->pageToFrame[pageNum] = index;
+    }
+
+    SimFrame *frame = &pool->frames[index];
+    frame->fixCount++;
+    frame->prevUse = frame->lastUse;
+    frame->lastUse = pool->time;
+    frame->refCount++;
+    frame->refBit = 1;
+}
+
+// This function replays the whole trace against one strategy and pool size and returns the miss ratio.
+double simulate(unsigned int *events, long numEvents, PageNumber maxPage, SimStrategy *strategy, int numFrames)
+{
+    SimPool pool;
+    memset(&pool, 0, sizeof(SimPool));
+    pool.numFrames = numFrames;
+    pool.frames = (SimFrame *)calloc(numFrames, sizeof(SimFrame));
+    pool.pageToFrame = (int *)malloc((maxPage + 1) * sizeof(int));
+
+    for (int i = 0; i < numFrames; i++)
+        pool.frames[i].pageNum = NO_PAGE;
+    for (PageNumber p = 0; p <= maxPage; p++)
+        pool.pageToFrame[p] = -1;
+
+    for (long e = 0; e < numEvents; e++)
+    {
+        PageNumber pageNum = BM_TRACE_PAGE(events[e]);
+        int index = pool.pageToFrame[pageNum];
+
+        switch (BM_TRACE_OP(events[e]))
+        {
+        case TRACE_PIN:
+            simulatePin(&pool, strategy, pageNum);
+            break;
+        case TRACE_UNPIN:
+            if (index != -1 && pool.frames[index].fixCount > 0)
+                pool.frames[index].fixCount--;
+            break;
+        default:
+            // Dirty pages do not change which page is evicted
+            break;
+        }
+    }
+
+    double missRatio = (pool.pins > 0) ? (double)pool.misses / pool.pins : 0.0;
+
+    free(pool.frames);
+    free(pool.pageToFrame);
+    return missRatio;
+}
+
+// This function reads all events of a trace file, returns NULL if the file is not a trace.
+unsigned int *readTrace(char *fileName, long *numEvents)
+{
+    FILE *file = fopen(fileName, "rb");
+    if (file == NULL)
+        return NULL;
+
+    unsigned int magic = 0;
+    if (fread(&magic, sizeof(unsigned int), 1, file) != 1 || magic != BM_TRACE_MAGIC)
+    {
+        fclose(file);
+        return NULL;
+    }
+
+    // The number of events follows from the file size
+    fseek(file, 0L, SEEK_END);
+    long size = ftell(file);
+    fseek(file, sizeof(unsigned int), SEEK_SET);
+
+    *numEvents = (size - (long)sizeof(unsigned int)) / (long)sizeof(unsigned int);
+    unsigned int *events = (unsigned int *)malloc((*numEvents > 0 ? *numEvents : 1) * sizeof(unsigned int));
+    *numEvents = fread(events, sizeof(unsigned int), *numEvents, file);
+
+    fclose(file);
+    return events;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        printf("usage: %s <traceFile> [poolSize ...]\n", argv[0]);
+        return 1;
+    }
+
+    long numEvents = 0;
+    unsigned int *events = readTrace(argv[1], &numEvents);
+    if (events == NULL)
+    {
+        printf("%s is not a buffer pool trace\n", argv[1]);
+        return 1;
+    }
+
+    // Find the largest page number and count the distinct pages and the pins
+    PageNumber maxPage = 0;
+    long numPins = 0;
+    for (long e = 0; e < numEvents; e++)
+    {
+        if (BM_TRACE_PAGE(events[e]) > maxPage)
+            maxPage = BM_TRACE_PAGE(events[e]);
+    }
+    bool *seen = (bool *)calloc(maxPage + 1, sizeof(bool));
+    int distinctPages = 0;
+    for (long e = 0; e < numEvents; e++)
+    {
+        if (BM_TRACE_OP(events[e]) != TRACE_PIN)
+            continue;
+        numPins++;
+        if (!seen[BM_TRACE_PAGE(events[e])])
+        {
+            seen[BM_TRACE_PAGE(events[e])] = true;
+            distinctPages++;
+        }
+    }
+    free(seen);
+
+    // Pool sizes from the command line, or powers of two up to the number of distinct pages
+    int numSizes = argc - 2;
+    int *sizes;
+    if (numSizes > 0)
+    {
+        sizes = (int *)malloc(numSizes * sizeof(int));
+        for (int i = 0; i < numSizes; i++)
+            sizes[i] = atoi(argv[i + 2]) > 0 ? atoi(argv[i + 2]) : 1;
+    }
+    else
+    {
+        sizes = (int *)malloc(32 * sizeof(int));
+        for (int size = 1; numSizes < 31; size *= 2)
+        {
+            sizes[numSizes++] = (size < distinctPages) ? size : (distinctPages > 0 ? distinctPages : 1);
+            if (size >= distinctPages)
+                break;
+        }
+    }
+
+    printf("%ld events, %ld pins, %i distinct pages\n", numEvents, numPins, distinctPages);
+    printf("%8s", "frames");
+    for (int s = 0; s < NUM_STRATEGIES; s++)
+        printf(" %8s", strategies[s].name);
+    printf("\n");
+
+    // One row of miss ratios per pool size
+    for (int i = 0; i < numSizes; i++)
+    {
+        printf("%8i", sizes[i]);
+        for (int s = 0; s < NUM_STRATEGIES; s++)
+            printf(" %8.4f", simulate(events, numEvents, maxPage, &strategies[s], sizes[i]));
+        printf("\n");
+    }
+
+    free(sizes);
+    free(events);
+    return 0;
+}
@@ -2,8 +2,14 @@
 #include <stdlib.h>
 #include "buffer_mgr.h"
 #include "storage_mgr.h"
+#include "lz_codec.h"
+#include "buffer_mgr_shm.h"
 #include <math.h>
 #include <limits.h>
+#include <string.h>
+#include <time.h>
+#include <stdint.h>
+#include <sys/mman.h>
 
 // Structure representing a page frame within the buffer pool.
 typedef struct Page {
@@ -13,25 +19,85 @@ typedef struct Page {
     int fixCount; // Number of clients currently using this page.
     int hitNum; // Number of times the page has been referenced (for LRU and Clock replacement strategies).
     int refNum; // Number of times the page has been referenced (for LFU replacement strategy).
+    int accessTime; // Logical time of the last pin, used to record the recency order of resident pages.
+    EvictionHint hint; // Hint given by the last client that unpinned the page.
+    bool prefetched; // Whether the page was loaded ahead of its first pin and has not been pinned yet.
 } PageFrame;
 
-// Pointer for the least frequently used page replacement strategy.
-int lfuPointer;
+// Number of candidate strategies of an RS_ADAPTIVE pool (FIFO, LRU and CLOCK).
+#define ADAPTIVE_CANDIDATES 3
 
-// Size of the buffer pool.
-int bufferSize;
+// An RS_ADAPTIVE pool compares the candidates every ADAPTIVE_WINDOW_FACTOR * numPages pins.
+#define ADAPTIVE_WINDOW_FACTOR 16
 
-// Index of the last page in the buffer pool.
-int rearIndex;
+// A candidate must miss at least this many percent less than the active strategy to replace it.
+#define ADAPTIVE_MARGIN 10
 
-// Pointer for the clock page replacement strategy.
-int clockPointer;
+// Shadow directory of a candidate strategy: the pages the pool would hold under that strategy, without their data.
+typedef struct ShadowDirectory {
+    ReplacementStrategy strategy; // Strategy simulated by the directory.
+    PageNumber *pages; // Page number per shadow frame, NO_PAGE if the frame is empty.
+    int *stamps; // Time of the last use per shadow frame (LRU).
+    int *refBits; // Reference bit per shadow frame (CLOCK).
+    int hand; // Next shadow frame replaced by FIFO or inspected by CLOCK.
+    long misses; // Misses of the recent windows, halved at the end of every window.
+} ShadowDirectory;
 
-// Number of pages written back to disk.
-int writeCount;
-
-// Number of page hits in the buffer pool.
-int hit;
+// A clean page kept compressed in the victim cache after it was evicted from the pool.
+typedef struct VictimEntry {
+    PageNumber pageNum; // Page number in the file.
+    char *data; // Content of the page compressed with lzCompress.
+    int length; // Number of compressed bytes.
+} VictimEntry;
+
+// State of a pin request whose page is still being read.
+typedef struct PinRequestInfo {
+    SM_FileHandle fh; // Page file, kept open until the read has completed.
+    SM_AsyncRead read; // Asynchronous read issued through the storage manager.
+    SM_PageHandle data; // Buffer the page is read into.
+    RC status; // Result of the read once it has completed.
+    long long startNanos; // Time the read was issued.
+    PageNumber pageNum; // Page being read.
+    bool stale; // Whether the pool wrote the page back after the read was issued, data is then outdated.
+    long sharedWrites; // Pages written back by a shared pool when the read was issued.
+    struct PinRequestInfo *next; // Next pending request of the same private pool.
+} PinRequestInfo;
+
+// Bookkeeping kept for every buffer pool, stored in the pool's mgmtData.
+typedef struct PoolInfo {
+    PageFrame *pageFrames; // Array of page frames of the pool.
+    int clock; // Logical clock, advanced on every pin.
+    bool warmupEnabled; // Whether shutdown dumps the resident pages to the warm-up sidecar file.
+    int *coldFrames; // Ring of frames unpinned with EH_EVICT_SOON, oldest first.
+    int coldHead; // Position of the oldest entry in coldFrames.
+    int coldCount; // Number of entries in coldFrames.
+    BM_Stats stats; // Counters reported by getPoolStats.
+    FILE *traceFile; // Trace of pins, unpins and markDirty calls, NULL if tracing is off.
+    bool adaptive; // Whether the pool was created with RS_ADAPTIVE, bm->strategy then holds the active strategy.
+    ShadowDirectory shadows[ADAPTIVE_CANDIDATES]; // Shadow directories of the candidates of an adaptive pool.
+    int shadowClock; // Logical clock of the shadow directories, advanced on every pin.
+    int windowPins; // Pins since the candidates were last compared.
+    VictimEntry *victims; // Victim cache of compressed evicted pages, oldest first.
+    int numVictims; // Number of entries in victims.
+    int victimSlots; // Number of entries allocated for victims.
+    long victimBytes; // Compressed bytes held by the victim cache.
+    long victimBudget; // Largest number of compressed bytes the victim cache may hold, 0 if it is disabled.
+    char *arena; // Page data of all frames, frame i owns the bm->pageSize bytes at arena + i * bm->pageSize.
+    size_t arenaSize; // Number of bytes mapped for the arena.
+    BM_PageMemory pageMemory; // Kind of pages backing the arena.
+    BM_SharedPool *shared; // Shared memory segment holding the frames of a shared pool, NULL for a private pool.
+    int sharedPins; // Pins this process holds on a shared pool.
+    int rearIndex; // Index of the last page in the buffer pool (FIFO).
+    int clockPointer; // Pointer for the clock page replacement strategy.
+    int hit; // Hit number given to the last pinned page (LRU).
+    PinRequestInfo *pendingReads; // Pin requests of a private pool whose page has not been placed into a frame yet.
+} PoolInfo;
+
+// Size of a huge page. Frame arenas of at least this size are backed by huge pages if possible.
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// Suffix of the sidecar file that stores the resident pages of a pool between restarts.
+#define WARMUP_FILE_SUFFIX ".warm"
 
 // Function that writes a page frame back to disk.
 void writeToDisk(BM_BufferPool *const bm, PageFrame *pageFrame);
@@ -39,20 +105,20 @@ void writeToDisk(BM_BufferPool *const bm, PageFrame *pageFrame);
 // Function that replaces the data in a page frame with the data from another page.
 void replacePageFrameData(PageFrame *pageFrame, PageFrame *page);
 
+// Function that checks if a page frame is unpinned and may be evicted given its eviction hint.
+bool isEvictable(PageFrame *pageFrame, bool allowHot);
+
 // Function that checks if a page frame can be replaced (not currently used by any client and not dirty).
 bool isReplaceable(PageFrame *pageFrame);
 
 // Function that gets the index of the next frame to be used in the buffer pool.
-int getNextFrameIndex();
+int getNextFrameIndex(BM_BufferPool *const bm);
 
 // Function that initializes an array of page frames.
-PageFrame *initializePageFrames(const int numPages);
-
-// Function that initializes auxiliary variables used in buffer pool management.
-void initializeAuxiliaryVariables();
+PageFrame *initializePageFrames(const int numPages, char *arena, const int pageSize);
 
 // Function that checks if there are any pinned (currently in use) pages in the buffer pool.
-bool hasPinnedPages(PageFrame *pageFrames);
+bool hasPinnedPages(BM_BufferPool *const bm);
 
 // Function that deallocates memory for an array of page frames.
 void deallocatePageFrames(PageFrame **pageFrames);
@@ -61,22 +127,178 @@ void deallocatePageFrames(PageFrame **pageFrames);
 bool isPageDirtyAndUnfixed(PageFrame *pageFrame);
 
 // Function that writes a page frame back to disk.
-void writePageToDisk(SM_FileHandle *fh, PageFrame *pageFrame);
+void writePageToDisk(BM_BufferPool *const bm, SM_FileHandle *fh, PageFrame *pageFrame);
+
+// Function that returns the shared memory segment of a shared pool, or NULL for a private pool.
+BM_SharedPool *getSharedPool(BM_BufferPool *const bm);
+
+// Function that marks the pending pin requests of a page as stale after the page was written back.
+void notePageWritten(BM_BufferPool *const bm, PageNumber pageNum);
+
+// Function that returns the page frames of a buffer pool.
+PageFrame *getPageFrames(BM_BufferPool *const bm);
+
+// Function that returns the statistics counters of a buffer pool.
+BM_Stats *getStats(BM_BufferPool *const bm);
+
+// Function that counts pages read from disk and the latency of the read.
+void recordRead(BM_BufferPool *const bm, int numPages, long long startNanos);
+
+// Function that counts a page written to disk and the latency of the write.
+void recordWrite(BM_BufferPool *const bm, long long startNanos);
+
+// Function that returns the current time of a monotonic clock in nanoseconds.
+long long currentNanos();
+
+// Function that appends an event to the trace of the buffer pool.
+void traceEvent(BM_BufferPool *const bm, BM_TraceOp op, PageNumber pageNum);
+
+// Function that advances the logical clock of a buffer pool and returns the new time.
+int nextAccessTime(BM_BufferPool *const bm);
+
+// Function that prefetches the pages listed in the warm-up file of the page file into the buffer pool.
+void loadWarmupFile(BM_BufferPool *const bm);
+
+// Function that writes the resident pages of the buffer pool to the warm-up file in recency order.
+RC saveWarmupFile(BM_BufferPool *const bm);
+
+// Function that sets up the shadow directories of an adaptive pool.
+void initShadowDirectories(PoolInfo *poolInfo, int numPages);
 
-// This is a function to replace the data in one page frame with the data from another page frame.
+// Function that frees the shadow directories of an adaptive pool.
+void freeShadowDirectories(PoolInfo *poolInfo);
+
+// Function that feeds a pin to the shadow directories of an adaptive pool and switches to a better strategy.
+void adaptStrategy(BM_BufferPool *const bm, PageNumber pageNum);
+
+// Function that keeps a compressed copy of the page of a frame that is evicted in the victim cache.
+void stashVictimPage(BM_BufferPool *const bm, PageFrame *pageFrame);
+
+// Function that places a new page into a frame, the frame keeps its page buffer.
+void installPage(PageFrame *pageFrame, PageFrame *page);
+
+// Function that maps the page buffers of all frames, with huge pages if possible.
+char *allocateFrameArena(size_t size, size_t *arenaSize, BM_PageMemory *pageMemory);
+
+// Function that reads the content of a page into the page buffer of a frame.
+void readPageData(BM_BufferPool *const bm, const PageNumber pageNum, SM_PageHandle preloaded, SM_PageHandle data);
+
+// Function that removes a page from the victim cache and returns whether it was there.
+bool dropVictimPage(BM_BufferPool *const bm, PageNumber pageNum);
+
+// Function that restores a page from the victim cache into data and returns whether it was there.
+bool takeVictimPage(BM_BufferPool *const bm, PageNumber pageNum, SM_PageHandle data);
+
+// This function returns the shared memory segment of a shared pool, or NULL for a private pool.
+BM_SharedPool *getSharedPool(BM_BufferPool *const bm)
+{
+    return ((PoolInfo *)bm->mgmtData)->shared;
+}
+
+// This function returns the page frames of a buffer pool.
+PageFrame *getPageFrames(BM_BufferPool *const bm)
+{
+    return ((PoolInfo *)bm->mgmtData)->pageFrames;
+}
+
+// This function advances the logical clock of a buffer pool and returns the new time.
+int nextAccessTime(BM_BufferPool *const bm)
+{
+    return ++((PoolInfo *)bm->mgmtData)->clock;
+}
+
+// This function returns the statistics counters of a buffer pool.
+BM_Stats *getStats(BM_BufferPool *const bm)
+{
+    return &((PoolInfo *)bm->mgmtData)->stats;
+}
+
+// This function returns the current time of a monotonic clock in nanoseconds.
+long long currentNanos()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+// This function adds an I/O that started at startNanos to a latency histogram.
+void recordLatency(long *histogram, long long startNanos)
+{
+    long long micros = (currentNanos() - startNanos) / 1000;
+    int bucket = 0;
+
+    // The bucket is the number of significant bits of the latency in microseconds
+    while (micros > 0 && bucket < BM_LATENCY_BUCKETS - 1)
+    {
+        micros >>= 1;
+        bucket++;
+    }
+
+    histogram[bucket]++;
+}
+
+// This function counts numPages pages read with one request that started at startNanos.
+void recordRead(BM_BufferPool *const bm, int numPages, long long startNanos)
+{
+    BM_Stats *stats = getStats(bm);
+    stats->numReadIO += numPages;
+    recordLatency(stats->readLatency, startNanos);
+}
+
+// This function counts a page written with a request that started at startNanos.
+void recordWrite(BM_BufferPool *const bm, long long startNanos)
+{
+    BM_Stats *stats = getStats(bm);
+    stats->numWriteIO++;
+    recordLatency(stats->writeLatency, startNanos);
+}
+
+// This function appends an event to the trace of the buffer pool if tracing is on.
+void traceEvent(BM_BufferPool *const bm, BM_TraceOp op, PageNumber pageNum)
+{
+    FILE *traceFile = ((PoolInfo *)bm->mgmtData)->traceFile;
+    if (traceFile != NULL)
+    {
+        unsigned int word = BM_TRACE_ENCODE(op, pageNum);
+        fwrite(&word, sizeof(unsigned int), 1, traceFile);
+    }
+}
+
+// This is a function to replace the page in one page frame with the page described by another page frame.
 void replacePageFrameData(PageFrame *pageFrame, PageFrame *page)
 {
     // Assign page number from the input page to the existing page frame.
     pageFrame->pageNum = page->pageNum;
 
-    // Assign data from the input page to the existing page frame.
-    pageFrame->data = page->data;
-
     // Assign dirty bit from the input page to the existing page frame.
     pageFrame->dirtyBit = page->dirtyBit;
 
     // Assign fix count from the input page to the existing page frame.
     pageFrame->fixCount = page->fixCount;
+
+    // Assign the access time from the input page to the existing page frame.
+    pageFrame->accessTime = page->accessTime;
+
+    // Assign the eviction hint from the input page to the existing page frame.
+    pageFrame->hint = page->hint;
+
+    // Assign the prefetch flag from the input page to the existing page frame.
+    pageFrame->prefetched = page->prefetched;
+}
+
+// This function places a new page into a frame. Page buffers belong to the frames, so the frame keeps its buffer
+// and the caller reads the new page into it.
+void installPage(PageFrame *pageFrame, PageFrame *page)
+{
+    SM_PageHandle data = pageFrame->data;
+    *pageFrame = *page;
+    pageFrame->data = data;
+}
+
+// This function checks if a page frame is unpinned and may be evicted, frames hinted as hot only if allowHot is set.
+bool isEvictable(PageFrame *pageFrame, bool allowHot)
+{
+    return pageFrame->fixCount == 0 && (allowHot || pageFrame->hint != EH_KEEP_HOT);
 }
 
 // This function checks if a page frame can be replaced based on its hit number.
@@ -97,16 +319,16 @@ bool isReplaceable(PageFrame *pageFrame)
 }
 
 // This function calculates and returns the index of the next frame in a circular buffer.
-int getNextFrameIndex()
+int getNextFrameIndex(BM_BufferPool *const bm)
 {
-    // The next frame index is calculated as the current position of the clock pointer (clockPointer)
-    // incremented by one and then taken modulo the size of the buffer (bufferSize).
+    // The next frame index is calculated as the current position of the clock pointer of the pool
+    // incremented by one and then taken modulo the number of frames of the pool.
     // This ensures that the index wraps around to the start of the buffer once it reaches the end.
-    return (clockPointer + 1) % bufferSize;
+    return (((PoolInfo *)bm->mgmtData)->clockPointer + 1) % bm->numPages;
 }
 
 // This function initializes an array of PageFrames.
-PageFrame *initializePageFrames(const int numPages)
+PageFrame *initializePageFrames(const int numPages, char *arena, const int pageSize)
 {
     // Allocate memory for the page frames
     PageFrame *pageFrames = (PageFrame *)calloc(numPages, sizeof(PageFrame));
@@ -115,32 +337,18 @@ PageFrame *initializePageFrames(const int numPages)
     for (int i = 0; i < numPages; i++)
     {
         pageFrames[i].pageNum = -1; // Use -1 to represent an invalid page number
+        pageFrames[i].data = arena + (size_t)i * pageSize; // Every frame owns a fixed slice of the arena
     }
 
     return pageFrames;
 }
 
-// This function initializes the auxiliary variables used in the program.
-void initializeAuxiliaryVariables()
-{
-    // Reset writeCount to 0. This variable might be used to count the number of write operations
-    // performed in your program, or to track a similar metric.
-    writeCount = 0;
-
-    // Reset clockPointer to 0. This variable is typically used in a clock replacement algorithm (a page
-    // replacement algorithm), where it points to the next candidate frame for replacement.
-    clockPointer = 0;
-
-    // Reset lfuPointer to 0. This variable might be used in a Least Frequently Used (LFU) cache
-    // algorithm, where it points to the next candidate frame for eviction based on the frequency of
-    // access.
-    lfuPointer = 0;
-}
-
 // This function checks if there are any pinned pages in the buffer pool.
-bool hasPinnedPages(PageFrame *pageFrames)
+bool hasPinnedPages(BM_BufferPool *const bm)
 {
-    for (int i = 0; i < bufferSize; i++)
+    PageFrame *pageFrames = getPageFrames(bm);
+
+    for (int i = 0; i < bm->numPages; i++)
     {
         // Return true if a page frame is still pinned
         if (pageFrames[i].fixCount != 0)
@@ -168,59 +376,85 @@ bool isPageDirtyAndUnfixed(PageFrame *pageFrame)
 }
 
 // This function writes the data from a PageFrame to disk using the writeBlock function.
-void writePageToDisk(SM_FileHandle *fh, PageFrame *pageFrame)
+void writePageToDisk(BM_BufferPool *const bm, SM_FileHandle *fh, PageFrame *pageFrame)
 {
     // Write the data block to the page file on disk
+    long long startNanos = currentNanos();
     writeBlock(pageFrame->pageNum, fh, pageFrame->data);
 
     // Mark the page as not dirty
     pageFrame->dirtyBit = 0;
 
-    // Increment the writeCount to record the disk write
-    writeCount++;
+    // Record the disk write
+    recordWrite(bm, startNanos);
+    notePageWritten(bm, pageFrame->pageNum);
+}
+
+// This function marks the pending pin requests of a page as stale, their reads may have returned the old content.
+void notePageWritten(BM_BufferPool *const bm, PageNumber pageNum)
+{
+    for (PinRequestInfo *info = ((PoolInfo *)bm->mgmtData)->pendingReads; info != NULL; info = info->next)
+    {
+        if (info->pageNum == pageNum)
+        {
+            info->stale = true;
+        }
+    }
 }
 
-// This function writes the data from a PageFrame to disk using the openPageFile and writeBlock functions.
+// This function writes back the dirty page of a frame that is about to be evicted.
 void writeToDisk(BM_BufferPool *const bm, PageFrame *pageFrame)
 {
     SM_FileHandle fh;
-    openPageFile(bm->pageFile, &fh);
+    if (openPageFile(bm->pageFile, &fh) != RC_OK)
+    {
+        return;
+    }
+
+    long long startNanos = currentNanos();
     writeBlock(pageFrame->pageNum, &fh, pageFrame->data);
+    closePageFile(&fh);
 
-    // Increment the writeCount to record the disk write
-    writeCount++;
+    // Record the disk write and the dirty eviction
+    recordWrite(bm, startNanos);
+    getStats(bm)->dirtyEvictions++;
+    notePageWritten(bm, pageFrame->pageNum);
 }
 
 // This function implements a First In First Out (FIFO) page replacement algorithm for a buffer pool.
 extern void FIFO(BM_BufferPool *const bm, PageFrame *page)
 {
-    // Cast the buffer pool's management data to a PageFrame pointer
-    PageFrame *pageFrame = (PageFrame *)bm->mgmtData;
+    // Get the page frames of the buffer pool
+    PageFrame *pageFrame = getPageFrames(bm);
+    int bufferSize = bm->numPages;
 
-    // Calculate the index of the front of the queue (the next frame to be replaced)
-    int frontIndex = rearIndex % bufferSize;
+    // Calculate the index of the front of the queue (the next frame to be replaced), the one after the last page
+    int frontIndex = (((PoolInfo *)bm->mgmtData)->rearIndex + 1) % bufferSize;
 
-    // Main loop to find a frame for replacement
-    while (true)
+    // Frames marked as hot are only taken in the second pass, when no other frame is available
+    for (int pass = 0; pass < 2; pass++)
     {
-        // Frame is not currently being used
-        if (pageFrame[frontIndex].fixCount == 0)
+        for (int n = 0; n < bufferSize; n++)
         {
-            // Check if the frame has been modified and write it back to disk if necessary
-            if (pageFrame[frontIndex].dirtyBit == 1)
+            int index = (frontIndex + n) % bufferSize;
+
+            // Frame is not currently being used
+            if (isEvictable(&pageFrame[index], pass == 1))
             {
-                writeToDisk(bm, &pageFrame[frontIndex]);
+                // Check if the frame has been modified and write it back to disk if necessary
+                if (pageFrame[index].dirtyBit == 1)
+                {
+                    writeToDisk(bm, &pageFrame[index]);
+                }
+
+                // Replace the content of the page frame with the new page's content
+                stashVictimPage(bm, &pageFrame[index]);
+                replacePageFrameData(&pageFrame[index], page);
+
+                // We have replaced the frame, so we can stop searching
+                return;
             }
-
-            // Replace the content of the page frame with the new page's content
-            replacePageFrameData(&pageFrame[frontIndex], page);
-
-            // We have replaced the frame, so we can exit the loop now
-            break;
         }
-
-        // Move to the next frame if the current frame is being used
-        frontIndex = (frontIndex + 1) % bufferSize;
     }
 }
 
@@ -229,26 +463,29 @@ extern void LRU(BM_BufferPool *const bm, PageFrame *page)
 {
     // Get the size of the buffer
     int bufferSize = bm->numPages;
-    // loading the pageFrame point with buffer pool's management data
-    PageFrame *pageFrame = (PageFrame *)bm->mgmtData;
+    // loading the pageFrame point with the buffer pool's page frames
+    PageFrame *pageFrame = getPageFrames(bm);
 
     // Initializing variables to hold the index and hit number of LRU
     int leastRecentIndex = -1;
     int leastRecentNum = INT_MAX;
     int highestRecentNum = INT_MIN;
 
-    // Find the least recently used page frame and highest hitNum
-    for (int i = 0; i < bufferSize; i++)
+    // Find the least recently used page frame and highest hitNum, hot frames are only considered if nothing else is left
+    for (int pass = 0; pass < 2 && leastRecentIndex == -1; pass++)
     {
-        // If the current frame is not fixed and has a lower hit number than the current least recent page frame
-        if (pageFrame[i].fixCount == 0 && pageFrame[i].hitNum <= leastRecentNum)
-        {
-            leastRecentNum = pageFrame[i].hitNum;
-            leastRecentIndex = i;
-        }
-        if (pageFrame[i].hitNum > highestRecentNum)
+        for (int i = 0; i < bufferSize; i++)
         {
-            highestRecentNum = pageFrame[i].hitNum;
+            // If the current frame is not fixed and has a lower hit number than the current least recent page frame
+            if (isEvictable(&pageFrame[i], pass == 1) && pageFrame[i].hitNum <= leastRecentNum)
+            {
+                leastRecentNum = pageFrame[i].hitNum;
+                leastRecentIndex = i;
+            }
+            if (pageFrame[i].hitNum > highestRecentNum)
+            {
+                highestRecentNum = pageFrame[i].hitNum;
+            }
         }
     }
 
@@ -265,7 +502,8 @@ extern void LRU(BM_BufferPool *const bm, PageFrame *page)
     }
 
     // Replace the least recently used page frame with the new page
-    pageFrame[leastRecentIndex] = *page;
+    stashVictimPage(bm, &pageFrame[leastRecentIndex]);
+    installPage(&pageFrame[leastRecentIndex], page);
 
     // Update the hitNum of the new page frame to be the highest + 1
     pageFrame[leastRecentIndex].hitNum = highestRecentNum + 1;
@@ -274,49 +512,740 @@ extern void LRU(BM_BufferPool *const bm, PageFrame *page)
 // Defining CLOCK function
 extern void CLOCK(BM_BufferPool *const bm, PageFrame *page)
 {
-    // Cast the buffer pool's management data to a PageFrame pointer
-    PageFrame *pageFrames = (PageFrame *)bm->mgmtData;
-
-    // Continue until we find a replaceable frame
-    while (true)
+    // Get the page frames of the buffer pool
+    PageFrame *pageFrames = getPageFrames(bm);
+    PoolInfo *poolInfo = (PoolInfo *)bm->mgmtData;
+
+    // Pinned frames are never taken, hot frames only in the second pass when no other frame is left. Within a pass
+    // the hand goes around at most twice, the first round may clear every reference bit and the second finds a victim.
+    int victim = -1;
+    for (int pass = 0; pass < 2 && victim == -1; pass++)
     {
-        // If the current frame can be replaced, break the loop
-        if (isReplaceable(&pageFrames[clockPointer]))
+        for (int steps = 0; steps < 2 * bm->numPages; steps++)
         {
-            break;
+            // If the current frame can be replaced, stop here
+            if (isEvictable(&pageFrames[poolInfo->clockPointer], pass == 1) && isReplaceable(&pageFrames[poolInfo->clockPointer]))
+            {
+                victim = poolInfo->clockPointer;
+                break;
+            }
+
+            // Move the clock pointer to the next frame
+            poolInfo->clockPointer = getNextFrameIndex(bm);
         }
+    }
 
-        // Move the clock pointer to the next frame
-        clockPointer = getNextFrameIndex();
+    // Every frame is pinned, the caller reports RC_PINNED_PAGES_IN_BUFFER
+    if (victim == -1)
+    {
+        return;
     }
 
     // If the frame is dirty, write it back to disk
-    if (pageFrames[clockPointer].dirtyBit == 1)
+    if (pageFrames[victim].dirtyBit == 1)
     {
-        writeToDisk(bm, &pageFrames[clockPointer]);
+        writeToDisk(bm, &pageFrames[victim]);
     }
 
     // Replace the current frame with the new page
-    pageFrames[clockPointer] = *page;
+    stashVictimPage(bm, &pageFrames[victim]);
+    installPage(&pageFrames[victim], page);
 
     // Advance the clock pointer to the next frame
-    clockPointer = getNextFrameIndex();
+    poolInfo->clockPointer = getNextFrameIndex(bm);
+}
+
+// This function sets up one empty shadow directory per candidate strategy.
+void initShadowDirectories(PoolInfo *poolInfo, int numPages)
+{
+    ReplacementStrategy candidates[ADAPTIVE_CANDIDATES] = {RS_FIFO, RS_LRU, RS_CLOCK};
+
+    for (int c = 0; c < ADAPTIVE_CANDIDATES; c++)
+    {
+        ShadowDirectory *shadow = &poolInfo->shadows[c];
+        shadow->strategy = candidates[c];
+        shadow->pages = (PageNumber *)malloc(numPages * sizeof(PageNumber));
+        shadow->stamps = (int *)calloc(numPages, sizeof(int));
+        shadow->refBits = (int *)calloc(numPages, sizeof(int));
+
+        for (int i = 0; i < numPages; i++)
+        {
+            shadow->pages[i] = NO_PAGE;
+        }
+    }
+}
+
+// This function frees the shadow directories, it does nothing for a pool that is not adaptive.
+void freeShadowDirectories(PoolInfo *poolInfo)
+{
+    for (int c = 0; c < ADAPTIVE_CANDIDATES; c++)
+    {
+        free(poolInfo->shadows[c].pages);
+        free(poolInfo->shadows[c].stamps);
+        free(poolInfo->shadows[c].refBits);
+    }
+}
+
+// This function replays a pin on a shadow directory and counts a miss if the page is not in it.
+// Shadow directories only hold page numbers, they ignore fix counts and eviction hints.
+void shadowAccess(ShadowDirectory *shadow, int numPages, PageNumber pageNum, int time)
+{
+    int victim = -1;
+
+    for (int i = 0; i < numPages; i++)
+    {
+        // The page would be a hit under this strategy
+        if (shadow->pages[i] == pageNum)
+        {
+            shadow->stamps[i] = time;
+            shadow->refBits[i] = 1;
+            return;
+        }
+        if (victim == -1 && shadow->pages[i] == NO_PAGE)
+        {
+            victim = i;
+        }
+    }
+
+    shadow->misses++;
+
+    // The shadow directory is full, pick the frame the strategy would replace
+    if (victim == -1)
+    {
+        switch (shadow->strategy)
+        {
+        case RS_LRU:
+            victim = 0;
+            for (int i = 1; i < numPages; i++)
+            {
+                if (shadow->stamps[i] < shadow->stamps[victim])
+                {
+                    victim = i;
+                }
+            }
+            break;
+        case RS_CLOCK:
+            while (shadow->refBits[shadow->hand] == 1)
+            {
+                shadow->refBits[shadow->hand] = 0;
+                shadow->hand = (shadow->hand + 1) % numPages;
+            }
+            victim = shadow->hand;
+            shadow->hand = (shadow->hand + 1) % numPages;
+            break;
+        default:
+            // Frames are filled in order, so the hand always points at the oldest page
+            victim = shadow->hand;
+            shadow->hand = (shadow->hand + 1) % numPages;
+            break;
+        }
+    }
+
+    shadow->pages[victim] = pageNum;
+    shadow->stamps[victim] = time;
+    shadow->refBits[victim] = 1;
+}
+
+// This function makes another strategy the active one and rebuilds the hit numbers of the resident pages for it.
+void switchStrategy(BM_BufferPool *const bm, ReplacementStrategy strategy)
+{
+    PoolInfo *poolInfo = (PoolInfo *)bm->mgmtData;
+    PageFrame *pageFrames = poolInfo->pageFrames;
+
+    for (int i = 0; i < bm->numPages; i++)
+    {
+        if (pageFrames[i].pageNum == NO_PAGE)
+        {
+            continue;
+        }
+
+        // LRU orders the pages by their last pin, CLOCK gives every page a second chance, FIFO keeps its queue
+        switch (strategy)
+        {
+        case RS_LRU:
+            pageFrames[i].hitNum = pageFrames[i].accessTime;
+            break;
+        case RS_CLOCK:
+            pageFrames[i].hitNum = 1;
+            break;
+        default:
+            pageFrames[i].hitNum = 0;
+            break;
+        }
+    }
+
+    // Hit numbers given from now on must be larger than the access times used above
+    if (strategy == RS_LRU && poolInfo->hit < poolInfo->clock)
+    {
+        poolInfo->hit = poolInfo->clock;
+    }
+
+    bm->strategy = strategy;
+    poolInfo->stats.strategySwitches++;
+}
+
+// This function replays a pin on every shadow directory and, at the end of a window, switches the pool
+// to the candidate with the fewest misses if it beats the active strategy by ADAPTIVE_MARGIN percent.
+void adaptStrategy(BM_BufferPool *const bm, PageNumber pageNum)
+{
+    PoolInfo *poolInfo = (PoolInfo *)bm->mgmtData;
+
+    poolInfo->shadowClock++;
+    for (int c = 0; c < ADAPTIVE_CANDIDATES; c++)
+    {
+        shadowAccess(&poolInfo->shadows[c], bm->numPages, pageNum, poolInfo->shadowClock);
+    }
+
+    if (++poolInfo->windowPins < ADAPTIVE_WINDOW_FACTOR * bm->numPages)
+    {
+        return;
+    }
+    poolInfo->windowPins = 0;
+
+    // Find the shadow directory of the active strategy and the one with the fewest misses
+    ShadowDirectory *active = NULL;
+    ShadowDirectory *best = NULL;
+    for (int c = 0; c < ADAPTIVE_CANDIDATES; c++)
+    {
+        ShadowDirectory *shadow = &poolInfo->shadows[c];
+        if (shadow->strategy == bm->strategy)
+        {
+            active = shadow;
+        }
+        if (best == NULL || shadow->misses < best->misses)
+        {
+            best = shadow;
+        }
+    }
+
+    if (active != NULL && best != active && best->misses * 100 < active->misses * (100 - ADAPTIVE_MARGIN))
+    {
+        switchStrategy(bm, best->strategy);
+    }
+
+    // Halve the counters so that recent windows weigh more than old ones
+    for (int c = 0; c < ADAPTIVE_CANDIDATES; c++)
+    {
+        poolInfo->shadows[c].misses /= 2;
+    }
+}
+
+// This function removes the entry at index from the victim cache.
+void dropVictimEntry(PoolInfo *poolInfo, int index)
+{
+    free(poolInfo->victims[index].data);
+    poolInfo->victimBytes -= poolInfo->victims[index].length;
+    poolInfo->numVictims--;
+    memmove(&poolInfo->victims[index], &poolInfo->victims[index + 1], (poolInfo->numVictims - index) * sizeof(VictimEntry));
+}
+
+// This function returns the index of a page in the victim cache, or -1.
+int findVictimPage(PoolInfo *poolInfo, PageNumber pageNum)
+{
+    for (int i = 0; i < poolInfo->numVictims; i++)
+    {
+        if (poolInfo->victims[i].pageNum == pageNum)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+// This function removes a page from the victim cache and returns whether it was there.
+bool dropVictimPage(BM_BufferPool *const bm, PageNumber pageNum)
+{
+    PoolInfo *poolInfo = (PoolInfo *)bm->mgmtData;
+    int index = findVictimPage(poolInfo, pageNum);
+
+    if (index == -1)
+    {
+        return false;
+    }
+
+    dropVictimEntry(poolInfo, index);
+    return true;
+}
+
+// This function restores a page from the victim cache into data and removes it from the cache.
+bool takeVictimPage(BM_BufferPool *const bm, PageNumber pageNum, SM_PageHandle data)
+{
+    PoolInfo *poolInfo = (PoolInfo *)bm->mgmtData;
+    int index = findVictimPage(poolInfo, pageNum);
+
+    if (index == -1)
+    {
+        return false;
+    }
+
+    // A page that does not decompress is dropped and read from the page file instead
+    VictimEntry *entry = &poolInfo->victims[index];
+    bool restored = lzDecompress(entry->data, entry->length, data, bm->pageSize) == bm->pageSize;
+    dropVictimEntry(poolInfo, index);
+
+    if (restored)
+    {
+        poolInfo->stats.victimHits++;
+    }
+    return restored;
+}
+
+// This function is called for a frame whose page is evicted, the page must be clean by now. If the victim cache
+// is enabled a compressed copy is kept, dropping the oldest copies to stay within the budget.
+void stashVictimPage(BM_BufferPool *const bm, PageFrame *pageFrame)
+{
+    PoolInfo *poolInfo = (PoolInfo *)bm->mgmtData;
+
+    if (poolInfo->victimBudget > 0 && pageFrame->pageNum != NO_PAGE)
+    {
+        char *compressed = (char *)malloc(LZ_MAX_COMPRESSED_SIZE(bm->pageSize));
+        int length = lzCompress(pageFrame->data, bm->pageSize, compressed, LZ_MAX_COMPRESSED_SIZE(bm->pageSize));
+
+        // An older copy of the page is outdated now
+        dropVictimPage(bm, pageFrame->pageNum);
+
+        // Pages that do not shrink are not worth keeping
+        if (length > 0 && length < bm->pageSize && length <= poolInfo->victimBudget)
+        {
+            while (poolInfo->victimBytes + length > poolInfo->victimBudget)
+            {
+                dropVictimEntry(poolInfo, 0);
+            }
+
+            if (poolInfo->numVictims == poolInfo->victimSlots)
+            {
+                poolInfo->victimSlots = (poolInfo->victimSlots == 0) ? bm->numPages : 2 * poolInfo->victimSlots;
+                poolInfo->victims = (VictimEntry *)realloc(poolInfo->victims, poolInfo->victimSlots * sizeof(VictimEntry));
+            }
+
+            VictimEntry *entry = &poolInfo->victims[poolInfo->numVictims++];
+            entry->pageNum = pageFrame->pageNum;
+            entry->length = length;
+            entry->data = (char *)realloc(compressed, length); // The entry keeps the compressed buffer
+            compressed = NULL;
+
+            poolInfo->victimBytes += length;
+            poolInfo->stats.victimStores++;
+        }
+
+        free(compressed);
+    }
+}
+
+// A page listed in the warm-up file together with its recency rank (0 is the most recently used page).
+typedef struct WarmupEntry {
+    PageNumber pageNum;
+    int rank;
+} WarmupEntry;
+
+// This function returns the name of the warm-up file that belongs to a page file.
+char *getWarmupFileName(const char *pageFile)
+{
+    char *fileName = (char *)malloc(strlen(pageFile) + strlen(WARMUP_FILE_SUFFIX) + 1);
+    strcpy(fileName, pageFile);
+    strcat(fileName, WARMUP_FILE_SUFFIX);
+    return fileName;
+}
+
+// This function orders page frames by descending access time, i.e. most recently used first.
+int compareByRecency(const void *left, const void *right)
+{
+    const PageFrame *l = *(const PageFrame **)left;
+    const PageFrame *r = *(const PageFrame **)right;
+    return (l->accessTime < r->accessTime) - (l->accessTime > r->accessTime);
+}
+
+// This function orders warm-up entries by ascending page number.
+int compareByPageNum(const void *left, const void *right)
+{
+    const WarmupEntry *l = (const WarmupEntry *)left;
+    const WarmupEntry *r = (const WarmupEntry *)right;
+    return (l->pageNum > r->pageNum) - (l->pageNum < r->pageNum);
+}
+
+// This function writes the page numbers of the resident pages to the warm-up file, most recently used first.
+RC saveWarmupFile(BM_BufferPool *const bm)
+{
+    PageFrame *pageFrames = getPageFrames(bm);
+    PageFrame **resident = (PageFrame **)malloc(bm->numPages * sizeof(PageFrame *));
+    int count = 0;
+
+    // Collect the frames that hold a page
+    for (int i = 0; i < bm->numPages; i++)
+    {
+        if (pageFrames[i].pageNum != NO_PAGE)
+        {
+            resident[count++] = &pageFrames[i];
+        }
+    }
+
+    // Sort them by recency
+    qsort(resident, count, sizeof(PageFrame *), compareByRecency);
+
+    char *fileName = getWarmupFileName(bm->pageFile);
+    FILE *file = fopen(fileName, "wb");
+    free(fileName);
+    if (file == NULL)
+    {
+        free(resident);
+        return RC_WRITE_FAILED;
+    }
+
+    // The file holds the number of pages followed by the page numbers in recency order
+    fwrite(&count, sizeof(int), 1, file);
+    for (int i = 0; i < count; i++)
+    {
+        fwrite(&resident[i]->pageNum, sizeof(PageNumber), 1, file);
+    }
+
+    fclose(file);
+    free(resident);
+    return RC_OK;
+}
+
+// This function prefetches the pages listed in the warm-up file, reading runs of neighbouring pages with one request.
+void loadWarmupFile(BM_BufferPool *const bm)
+{
+    char *fileName = getWarmupFileName(bm->pageFile);
+    FILE *file = fopen(fileName, "rb");
+    if (file == NULL)
+    {
+        free(fileName);
+        return;
+    }
+
+    // Read the page list, keeping only as many of the most recent pages as the pool can hold
+    int count = 0;
+    if (fread(&count, sizeof(int), 1, file) != 1 || count < 0)
+    {
+        count = 0;
+    }
+    if (count > bm->numPages)
+    {
+        count = bm->numPages;
+    }
+
+    PageNumber *pageNums = (PageNumber *)malloc((count > 0 ? count : 1) * sizeof(PageNumber));
+    count = fread(pageNums, sizeof(PageNumber), count, file);
+
+    // The file is consumed, a later shutdown writes a fresh one
+    fclose(file);
+    remove(fileName);
+    free(fileName);
+
+    SM_FileHandle fh;
+    if (count == 0 || openPageFile(bm->pageFile, &fh) != RC_OK)
+    {
+        free(pageNums);
+        return;
+    }
+
+    // Remember the recency rank of every page, then sort by page number so that neighbouring pages form runs
+    WarmupEntry *entries = (WarmupEntry *)malloc(count * sizeof(WarmupEntry));
+    for (int i = 0; i < count; i++)
+    {
+        entries[i].pageNum = pageNums[i];
+        entries[i].rank = i;
+    }
+    qsort(entries, count, sizeof(WarmupEntry), compareByPageNum);
+
+    // Drop duplicates and pages that no longer exist in the file
+    int numEntries = 0;
+    for (int i = 0; i < count; i++)
+    {
+        if (entries[i].pageNum < 0 || entries[i].pageNum >= fh.totalNumPages)
+            continue;
+        if (numEntries > 0 && entries[numEntries - 1].pageNum == entries[i].pageNum)
+            continue;
+        entries[numEntries++] = entries[i];
+    }
+
+    PageFrame *pageFrames = getPageFrames(bm);
+    SM_PageHandle runBuffer = (SM_PageHandle)malloc((size_t)(numEntries > 0 ? numEntries : 1) * bm->pageSize);
+    int *byRank = (int *)malloc(count * sizeof(int));
+    for (int i = 0; i < count; i++)
+    {
+        byRank[i] = -1;
+    }
+
+    for (int start = 0; start < numEntries;)
+    {
+        // Extend the run as long as the page numbers are consecutive
+        int end = start + 1;
+        while (end < numEntries && entries[end].pageNum == entries[end - 1].pageNum + 1)
+        {
+            end++;
+        }
+
+        // Read the whole run at once, its pages are placed into frames by rank below
+        long long startNanos = currentNanos();
+        if (readBlocks(entries[start].pageNum, end - start, &fh, runBuffer + (size_t)start * bm->pageSize) == RC_OK)
+        {
+            recordRead(bm, end - start, startNanos);
+            getStats(bm)->prefetchedPages += end - start;
+
+            for (int k = start; k < end; k++)
+            {
+                byRank[entries[k].rank] = k;
+            }
+        }
+
+        start = end;
+    }
+
+    // Fill the frames from the least recently used page on, so the FIFO queue starts with the oldest page
+    int loaded = 0;
+    for (int rank = count - 1; rank >= 0; rank--)
+    {
+        int k = byRank[rank];
+        if (k == -1)
+            continue;
+
+        PageFrame *frame = &pageFrames[loaded++];
+        memcpy(frame->data, runBuffer + (size_t)k * bm->pageSize, bm->pageSize);
+        frame->pageNum = entries[k].pageNum;
+        frame->dirtyBit = 0;
+        frame->fixCount = 0;
+        frame->refNum = 0;
+        frame->hint = EH_NONE;
+        frame->prefetched = true;
+
+        // More recently used pages get a later access time so the recency order survives the restart
+        frame->accessTime = count - rank;
+        frame->hitNum = (bm->strategy == RS_LRU) ? frame->accessTime : 0;
+    }
+
+    // Continue the counters after the prefetched pages, the next FIFO victim after the last frame is the oldest page
+    if (loaded > 0)
+    {
+        PoolInfo *poolInfo = (PoolInfo *)bm->mgmtData;
+        poolInfo->clock = count;
+        poolInfo->hit = count;
+        poolInfo->rearIndex = loaded - 1;
+    }
+
+    closePageFile(&fh);
+    free(runBuffer);
+    free(byRank);
+    free(entries);
+    free(pageNums);
+}
+
+// This function maps size bytes for the page buffers of a pool. Arenas of at least one huge page first try
+// explicit huge pages (MAP_HUGETLB, only available if huge pages were reserved), then a huge page aligned
+// mapping with madvise(MADV_HUGEPAGE), which lets the kernel back it with transparent huge pages.
+// pageMemory reports which of them was obtained, arenaSize the number of bytes to unmap.
+char *allocateFrameArena(size_t size, size_t *arenaSize, BM_PageMemory *pageMemory)
+{
+    char *arena;
+
+    *pageMemory = PM_REGULAR;
+    *arenaSize = size;
+
+    if (size >= HUGE_PAGE_SIZE)
+    {
+        size_t hugeSize = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+#ifdef MAP_HUGETLB
+        arena = (char *)mmap(NULL, hugeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (arena != MAP_FAILED)
+        {
+            *arenaSize = hugeSize;
+            *pageMemory = PM_HUGETLB;
+            return arena;
+        }
+#endif
+
+#ifdef MADV_HUGEPAGE
+        // Map one huge page more than needed and trim the range to a huge page boundary
+        char *mapping = (char *)mmap(NULL, hugeSize + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mapping != MAP_FAILED)
+        {
+            arena = (char *)(((uintptr_t)mapping + HUGE_PAGE_SIZE - 1) & ~(uintptr_t)(HUGE_PAGE_SIZE - 1));
+            size_t head = arena - mapping;
+            if (head > 0)
+            {
+                munmap(mapping, head);
+            }
+            munmap(arena + hugeSize, HUGE_PAGE_SIZE - head);
+
+            *arenaSize = hugeSize;
+            if (madvise(arena, hugeSize, MADV_HUGEPAGE) == 0)
+            {
+                *pageMemory = PM_TRANSPARENT_HUGE;
+            }
+            return arena;
+        }
+#endif
+    }
+
+    arena = (char *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return (arena == MAP_FAILED) ? NULL : arena;
+}
+
+// This function returns the page size of a page file, PAGE_SIZE if the file cannot be opened yet.
+int getPageFileSize(const char *const pageFileName)
+{
+    SM_FileHandle fh;
+    int pageSize = PAGE_SIZE;
+
+    if (openPageFile((char *)pageFileName, &fh) == RC_OK)
+    {
+        pageSize = fh.pageSize;
+        closePageFile(&fh);
+    }
+    return pageSize;
+}
+
+// This function returns the kind of memory backing the frames of a buffer pool.
+extern BM_PageMemory getPoolPageMemory(BM_BufferPool *const bm)
+{
+    return ((PoolInfo *)bm->mgmtData)->pageMemory;
 }
 
 // This function initializes a buffer pool data structure and related state.
 extern RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName, const int numPages, ReplacementStrategy strategy, void *stratData)
 {
-    // Initialize auxiliary variables
-    initializeAuxiliaryVariables();
+    // Initialize the bookkeeping of the pool, the replacement state of every pool starts at zero
+    PoolInfo *poolInfo = (PoolInfo *)calloc(1, sizeof(PoolInfo));
 
-    // Set the buffer size
-    bufferSize = numPages;
+    // Frames hold pages of the size stored in the page file
+    int pageSize = getPageFileSize(pageFileName);
+
+    // Map the page buffers of all frames as one arena
+    poolInfo->arena = allocateFrameArena((size_t)numPages * pageSize, &poolInfo->arenaSize, &poolInfo->pageMemory);
+    if (poolInfo->arena == NULL)
+    {
+        free(poolInfo);
+        return RC_MEMORY_ALLOCATION_ERROR;
+    }
+
+    poolInfo->pageFrames = initializePageFrames(numPages, poolInfo->arena, pageSize);
+    poolInfo->coldFrames = (int *)malloc(numPages * sizeof(int));
+
+    // An adaptive pool starts with LRU and follows the candidate that misses least
+    if (strategy == RS_ADAPTIVE)
+    {
+        poolInfo->adaptive = true;
+        initShadowDirectories(poolInfo, numPages);
+        strategy = RS_LRU;
+    }
 
     // Initialize buffer management properties
-    bm->mgmtData = initializePageFrames(numPages);
+    bm->mgmtData = poolInfo;
     bm->pageFile = (char *)pageFileName;
     bm->strategy = strategy;
     bm->numPages = numPages;
+    bm->pageSize = pageSize;
+
+    // Prefetch the pages that were resident when the pool was last shut down
+    loadWarmupFile(bm);
+
+    return RC_OK;
+}
+
+// This function initializes a buffer pool whose frames live in the POSIX shared memory segment shmName.
+// Processes that pass the same segment name share the frames, the page table and the replacement metadata.
+extern RC initSharedBufferPool(BM_BufferPool *const bm, const char *const pageFileName, const int numPages,
+                               ReplacementStrategy strategy, const char *const shmName)
+{
+    // The segment keeps replacement metadata for FIFO, LRU and CLOCK only
+    if (strategy != RS_FIFO && strategy != RS_LRU && strategy != RS_CLOCK)
+    {
+        return RC_INVALID_PARAMETER;
+    }
+
+    BM_SharedPool *shared = NULL;
+    int pageSize = getPageFileSize(pageFileName);
+    RC status = attachSharedPool(shmName, pageFileName, numPages, pageSize, strategy, &shared);
+    if (status != RC_OK)
+    {
+        return status;
+    }
+
+    PoolInfo *poolInfo = (PoolInfo *)calloc(1, sizeof(PoolInfo));
+    poolInfo->shared = shared;
+
+    bm->mgmtData = poolInfo;
+    bm->pageFile = (char *)pageFileName;
+    bm->strategy = strategy;
+    bm->numPages = numPages;
+    bm->pageSize = pageSize;
+
+    return RC_OK;
+}
+
+// This function starts recording pins, unpins and markDirty calls of the pool to a trace file.
+extern RC startPoolTrace(BM_BufferPool *const bm, const char *const traceFileName)
+{
+    if (bm == NULL || bm->mgmtData == NULL || traceFileName == NULL)
+    {
+        return RC_INVALID_PARAMETER;
+    }
+
+    // A running trace is finished first
+    stopPoolTrace(bm);
+
+    FILE *traceFile = fopen(traceFileName, "wb");
+    if (traceFile == NULL)
+    {
+        return RC_FILE_NOT_FOUND;
+    }
+
+    unsigned int magic = BM_TRACE_MAGIC;
+    fwrite(&magic, sizeof(unsigned int), 1, traceFile);
+
+    ((PoolInfo *)bm->mgmtData)->traceFile = traceFile;
+    return RC_OK;
+}
+
+// This function stops recording the trace of the pool and closes the trace file.
+extern RC stopPoolTrace(BM_BufferPool *const bm)
+{
+    if (bm == NULL || bm->mgmtData == NULL)
+    {
+        return RC_INVALID_PARAMETER;
+    }
+
+    PoolInfo *poolInfo = (PoolInfo *)bm->mgmtData;
+    if (poolInfo->traceFile != NULL)
+    {
+        fclose(poolInfo->traceFile);
+        poolInfo->traceFile = NULL;
+    }
+
+    return RC_OK;
+}
+
+// This function enables or disables dumping the resident pages to the warm-up file on shutdown.
+extern RC setBufferPoolWarmup(BM_BufferPool *const bm, bool enabled)
+{
+    if (bm == NULL || bm->mgmtData == NULL)
+    {
+        return RC_ERROR;
+    }
+
+    ((PoolInfo *)bm->mgmtData)->warmupEnabled = enabled;
+    return RC_OK;
+}
+
+// This function sets the memory budget of the compressed victim cache, 0 disables the cache and frees its pages.
+extern RC setBufferPoolVictimCache(BM_BufferPool *const bm, long maxBytes)
+{
+    if (bm == NULL || bm->mgmtData == NULL || maxBytes < 0)
+    {
+        return RC_INVALID_PARAMETER;
+    }
+
+    PoolInfo *poolInfo = (PoolInfo *)bm->mgmtData;
+    poolInfo->victimBudget = maxBytes;
+
+    // Drop the oldest pages until the cache fits into the new budget
+    while (poolInfo->victimBytes > maxBytes)
+    {
+        dropVictimEntry(poolInfo, 0);
+    }
 
     return RC_OK;
 }
@@ -324,95 +1253,252 @@ extern RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName
 // It forces any dirty pages to flush back to disk before shutdown.
 extern RC shutdownBufferPool(BM_BufferPool *const bm)
 {
-    PageFrame *pageFrames = (PageFrame *)bm->mgmtData;
+    PageFrame *pageFrames = getPageFrames(bm);
+
+    // A shared pool is only left by this process, the last process writes back and removes the segment
+    if (getSharedPool(bm) != NULL)
+    {
+        forceFlushPool(bm);
+        if (((PoolInfo *)bm->mgmtData)->sharedPins > 0)
+        {
+            return RC_PINNED_PAGES_IN_BUFFER;
+        }
+
+        stopPoolTrace(bm);
+        detachSharedPool(bm, getSharedPool(bm));
+        free(bm->mgmtData);
+        bm->mgmtData = NULL;
+        return RC_OK;
+    }
 
     // Flush all dirty pages back to disk
     forceFlushPool(bm);
 
     // Return an error if there are any pinned pages in the buffer pool
-    if (hasPinnedPages(pageFrames))
+    if (hasPinnedPages(bm))
     {
         return RC_PINNED_PAGES_IN_BUFFER;
     }
 
+    // Remember the resident pages so that the next initBufferPool can prefetch them
+    if (((PoolInfo *)bm->mgmtData)->warmupEnabled)
+    {
+        saveWarmupFile(bm);
+    }
+
+    // Finish a running trace
+    stopPoolTrace(bm);
+
     // Deallocate the memory for the page frames
     deallocatePageFrames(&pageFrames);
 
-    // Reset the buffer pool's management data
-    bm->mgmtData = NULL;
+    // Reset the buffer pool's management data
+    free(((PoolInfo *)bm->mgmtData)->coldFrames);
+    freeShadowDirectories((PoolInfo *)bm->mgmtData);
+    setBufferPoolVictimCache(bm, 0);
+    free(((PoolInfo *)bm->mgmtData)->victims);
+    munmap(((PoolInfo *)bm->mgmtData)->arena, ((PoolInfo *)bm->mgmtData)->arenaSize);
+    free(bm->mgmtData);
+    bm->mgmtData = NULL;
+
+    return RC_OK;
+}
+
+// It forces any dirty pages still in memory to flush back to disk before shutdown.
+extern RC forceFlushPool(BM_BufferPool *const bm)
+{
+    PageFrame *pageFrames = getPageFrames(bm);
+
+    if (getSharedPool(bm) != NULL)
+    {
+        return flushSharedPool(bm, getSharedPool(bm));
+    }
+
+    // Open the page file on disk
+    SM_FileHandle fh;
+    openPageFile(bm->pageFile, &fh);
+
+    for (int i = 0; i < bm->numPages; i++)
+    {
+        // If the page is dirty and not fixed, write it back to disk
+        if (isPageDirtyAndUnfixed(&pageFrames[i]))
+        {
+            writePageToDisk(bm, &fh, &pageFrames[i]);
+        }
+    }
+
+    // Close the file
+    closePageFile(&fh);
+
+    return RC_OK;
+}
+
+int findPageInBuffer(BM_BufferPool *const bm, PageNumber pageNum);
+int popColdFrame(BM_BufferPool *const bm);
+void replaceColdFrame(BM_BufferPool *const bm, PageFrame *pageFrame, PageFrame *page);
+//
+extern RC markDirty(BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+    PageFrame *pageFrames = getPageFrames(bm);
+
+    if (getSharedPool(bm) != NULL)
+    {
+        traceEvent(bm, TRACE_MARK_DIRTY, page->pageNum);
+        return markSharedPageDirty(getSharedPool(bm), page->pageNum);
+    }
+
+    int pageIndex = findPageInBuffer(bm, page->pageNum);
+
+    if (pageIndex != -1)
+    {
+        pageFrames[pageIndex].dirtyBit = 1;
+        traceEvent(bm, TRACE_MARK_DIRTY, page->pageNum);
+        return RC_OK;
+    }
+
+    return RC_ERROR;
+}
+
+int findPageInBuffer(BM_BufferPool *const bm, PageNumber pageNum)
+{
+    PageFrame *pageFrames = getPageFrames(bm);
+
+    for (int i = 0; i < bm->numPages; i++)
+    {
+        if (pageFrames[i].pageNum == pageNum)
+        {
+            return i;
+        }
+    }
+
+    return -1; // If page not found in buffer
+}
+
+void unpinPageIfPinned(PageFrame *pageFrame);
+// This function unpins a page in the buffer pool if it's pinnned.
+extern RC unpinPage(BM_BufferPool *const bm, BM_PageHandle *const page)
+{
+    PageFrame *pageFrames = getPageFrames(bm); // Get the page frames of the buffer pool.
+
+    if (getSharedPool(bm) != NULL) // Release the pin in the shared segment.
+    {
+        RC status = unpinSharedPage(getSharedPool(bm), page->pageNum);
+        if (status == RC_OK)
+        {
+            ((PoolInfo *)bm->mgmtData)->sharedPins--;
+            traceEvent(bm, TRACE_UNPIN, page->pageNum);
+        }
+        return status;
+    }
+
+    int pageIndex = findPageInBuffer(bm, page->pageNum); // Find the index of the page in the buffer pool.
+
+    if (pageIndex != -1) // If the page is found in the buffer pool.
+    {
+        unpinPageIfPinned(&pageFrames[pageIndex]); // Unpin the page if it's pinned.
+        traceEvent(bm, TRACE_UNPIN, page->pageNum); // Record the unpin in the trace.
+        return RC_OK;                              // Return success status.
+    }
+
+    return RC_ERROR; // Return error status if the page is not found in the buffer pool.
+}
+
+// This function remembers a frame whose page was hinted to be evicted soon.
+void pushColdFrame(BM_BufferPool *const bm, int frameIndex)
+{
+    PoolInfo *poolInfo = (PoolInfo *)bm->mgmtData;
+
+    // When the ring is full the oldest entry is dropped
+    if (poolInfo->coldCount == bm->numPages)
+    {
+        poolInfo->coldHead = (poolInfo->coldHead + 1) % bm->numPages;
+        poolInfo->coldCount--;
+    }
 
-    return RC_OK;
+    poolInfo->coldFrames[(poolInfo->coldHead + poolInfo->coldCount) % bm->numPages] = frameIndex;
+    poolInfo->coldCount++;
 }
 
-// It forces any dirty pages still in memory to flush back to disk before shutdown.
-extern RC forceFlushPool(BM_BufferPool *const bm)
+// This function returns the oldest frame that is still hinted to be evicted soon and unpinned, or -1.
+// Entries of frames that were pinned again or replaced in the meantime are dropped.
+int popColdFrame(BM_BufferPool *const bm)
 {
-    PageFrame *pageFrames = (PageFrame *)bm->mgmtData;
+    PoolInfo *poolInfo = (PoolInfo *)bm->mgmtData;
+    PageFrame *pageFrames = poolInfo->pageFrames;
 
-    // Open the page file on disk
-    SM_FileHandle fh;
-    openPageFile(bm->pageFile, &fh);
-
-    for (int i = 0; i < bufferSize; i++)
+    while (poolInfo->coldCount > 0)
     {
-        // If the page is dirty and not fixed, write it back to disk
-        if (isPageDirtyAndUnfixed(&pageFrames[i]))
+        int frameIndex = poolInfo->coldFrames[poolInfo->coldHead];
+        poolInfo->coldHead = (poolInfo->coldHead + 1) % bm->numPages;
+        poolInfo->coldCount--;
+
+        if (pageFrames[frameIndex].hint == EH_EVICT_SOON && pageFrames[frameIndex].fixCount == 0)
         {
-            writePageToDisk(&fh, &pageFrames[i]);
+            return frameIndex;
         }
     }
 
-    // Close the file
-    closePageFile(&fh);
-
-    return RC_OK;
+    return -1;
 }
 
-int findPageInBuffer(PageFrame *pageFrames, PageNumber pageNum);
-//
-extern RC markDirty(BM_BufferPool *const bm, BM_PageHandle *const page)
+// This function tells the kernel that a page will not be read again soon, so the page cache does not keep
+// a second copy of a page the pool has given up.
+void dropCachedPage(BM_BufferPool *const bm, PageNumber pageNum)
 {
-    PageFrame *pageFrames = (PageFrame *)bm->mgmtData;
-
-    int pageIndex = findPageInBuffer(pageFrames, page->pageNum);
+    SM_FileHandle fh;
 
-    if (pageIndex != -1)
+    if (pageNum != NO_PAGE && openPageFile(bm->pageFile, &fh) == RC_OK)
     {
-        pageFrames[pageIndex].dirtyBit = 1;
-        return RC_OK;
+        adviseBlocks(pageNum, 1, &fh, SM_ADVICE_DONTNEED);
+        closePageFile(&fh);
     }
-
-    return RC_ERROR;
 }
 
-int findPageInBuffer(PageFrame *pageFrames, PageNumber pageNum)
+// This function replaces the page of a frame that was hinted to be evicted soon.
+void replaceColdFrame(BM_BufferPool *const bm, PageFrame *pageFrame, PageFrame *page)
 {
-    for (int i = 0; i < bufferSize; i++)
+    // Write the old page back if it has been modified
+    if (pageFrame->dirtyBit == 1)
     {
-        if (pageFrames[i].pageNum == pageNum)
-        {
-            return i;
-        }
+        writeToDisk(bm, pageFrame);
     }
 
-    return -1; // If page not found in buffer
+    // The page is cold, the page cache need not keep it either
+    dropCachedPage(bm, pageFrame->pageNum);
+
+    // The new page already carries the hit number of its strategy
+    stashVictimPage(bm, pageFrame);
+    installPage(pageFrame, page);
 }
 
-void unpinPageIfPinned(PageFrame *pageFrame);
-// This function unpins a page in the buffer pool if it's pinnned.
-extern RC unpinPage(BM_BufferPool *const bm, BM_PageHandle *const page)
+// This function unpins a page and records a hint for the replacement strategy.
+extern RC unpinPageWithHint(BM_BufferPool *const bm, BM_PageHandle *const page, EvictionHint hint)
 {
-    PageFrame *pageFrames = (PageFrame *)bm->mgmtData; // Cast the management data of the buffer pool to an array of PageFrames.
+    PageFrame *pageFrames = getPageFrames(bm);
 
-    int pageIndex = findPageInBuffer(pageFrames, page->pageNum); // Find the index of the page in the buffer pool.
+    // The frames of a shared pool carry no hints
+    if (getSharedPool(bm) != NULL)
+    {
+        return unpinPage(bm, page);
+    }
 
-    if (pageIndex != -1) // If the page is found in the buffer pool.
+    int pageIndex = findPageInBuffer(bm, page->pageNum);
+    if (pageIndex == -1)
     {
-        unpinPageIfPinned(&pageFrames[pageIndex]); // Unpin the page if it's pinned.
-        return RC_OK;                              // Return success status.
+        return RC_ERROR;
     }
 
-    return RC_ERROR; // Return error status if the page is not found in the buffer pool.
+    unpinPageIfPinned(&pageFrames[pageIndex]);
+    traceEvent(bm, TRACE_UNPIN, page->pageNum);
+
+    // Cold frames are queued so that they can be reclaimed without scanning the pool
+    if (hint == EH_EVICT_SOON && pageFrames[pageIndex].hint != EH_EVICT_SOON)
+    {
+        pushColdFrame(bm, pageIndex);
+    }
+    pageFrames[pageIndex].hint = hint;
+
+    return RC_OK;
 }
 
 // This function decrements the fix count of a page frame if it's pinned.
@@ -427,8 +1513,13 @@ void unpinPageIfPinned(PageFrame *pageFrame)
 // This function writes the contents of the modified pages back to the page file on disk
 extern RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page)
 {
-    PageFrame *pageFrames = (PageFrame *)bm->mgmtData;
-    int pageIndex = findPageInBuffer(pageFrames, page->pageNum);
+    PageFrame *pageFrames = getPageFrames(bm);
+
+    if (getSharedPool(bm) != NULL)
+    {
+        return forceSharedPage(bm, getSharedPool(bm), page->pageNum);
+    }
+    int pageIndex = findPageInBuffer(bm, page->pageNum);
 
     if (pageIndex == -1)
     {
@@ -445,15 +1536,17 @@ extern RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page)
     }
 
     // Force the page to disk
+    long long startNanos = currentNanos();
     if (writeBlock(pageFrames[pageIndex].pageNum, &fh, pageFrames[pageIndex].data) != RC_OK)
     {
         // Failed to write page to disk
         return RC_WRITE_FAILED;
     }
 
-    // Mark the page as clean and increment the write count
+    // Mark the page as clean and record the write
     pageFrames[pageIndex].dirtyBit = 0;
-    writeCount++;
+    recordWrite(bm, startNanos);
+    notePageWritten(bm, pageFrames[pageIndex].pageNum);
 
     // Close the page file
     closePageFile(&fh);
@@ -461,32 +1554,61 @@ extern RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page)
     return RC_OK;
 }
 
+// This function fills the page buffer of a frame with the content of a page.
+// The content is copied from preloaded if the caller already read the page, otherwise it is read from the page file.
+void readPageData(BM_BufferPool *const bm, const PageNumber pageNum, SM_PageHandle preloaded, SM_PageHandle data)
+{
+    if (preloaded != NULL)
+    {
+        memcpy(data, preloaded, bm->pageSize);
+        dropVictimPage(bm, pageNum);
+        return;
+    }
+
+    // A page that was evicted recently may still be kept in the victim cache
+    if (takeVictimPage(bm, pageNum, data))
+    {
+        return;
+    }
+
+    // Pages that cannot be read are handed out empty
+    memset(data, 0, bm->pageSize);
+
+    // Open the file, make sure the page exists and read it
+    SM_FileHandle fh;
+    if (openPageFile(bm->pageFile, &fh) == RC_OK)
+    {
+        ensureCapacity(pageNum + 1, &fh);
+        long long startNanos = currentNanos();
+        if (readBlock(pageNum, &fh, data) == RC_OK)
+        {
+            recordRead(bm, 1, startNanos);
+        }
+        closePageFile(&fh);
+    }
+}
+
 // This function handles the scenario of reading the first page into the buffer pool.
 extern RC handleFirstPage(BM_BufferPool *const bm, BM_PageHandle *const page,
-                          const PageNumber pageNum, PageFrame *pageFrame)
+                          const PageNumber pageNum, PageFrame *pageFrame, SM_PageHandle preloaded)
 {
     // Create a pointer to the first page frame
     PageFrame *firstPageFrame = &pageFrame[0];
 
-    // Open the file
-    SM_FileHandle fh;
-    openPageFile(bm->pageFile, &fh);
-
-    // Allocate memory for the first page frame's data
-    firstPageFrame->data = (SM_PageHandle)malloc(PAGE_SIZE);
-
-    // Ensure the file has enough pages
-    ensureCapacity(pageNum, &fh);
-
     // Read the specified block into the first page frame's data
-    readBlock(pageNum, &fh, firstPageFrame->data);
+    readPageData(bm, pageNum, preloaded, firstPageFrame->data);
 
     // Set the properties of the first page frame
     firstPageFrame->pageNum = pageNum;
     firstPageFrame->fixCount++;
-    rearIndex = hit = 0;
-    firstPageFrame->hitNum = hit;
+    PoolInfo *poolInfo = (PoolInfo *)bm->mgmtData;
+    poolInfo->rearIndex = poolInfo->hit = 0;
+    firstPageFrame->hitNum = poolInfo->hit;
     firstPageFrame->refNum = 0;
+    firstPageFrame->accessTime = nextAccessTime(bm);
+    firstPageFrame->hint = EH_NONE;
+    firstPageFrame->prefetched = false;
+    getStats(bm)->misses++;
 
     // Set the properties of the page handle
     page->pageNum = pageNum;
@@ -502,14 +1624,33 @@ extern RC handlePageInMemory(BM_BufferPool *const bm, BM_PageHandle *const page,
 
     // Increment fix count and move clock pointer
     pageFrame[frameIndex].fixCount++;
-    clockPointer++;
+    pageFrame[frameIndex].accessTime = nextAccessTime(bm);
+    PoolInfo *poolInfo = (PoolInfo *)bm->mgmtData;
+    poolInfo->clockPointer = getNextFrameIndex(bm);
+
+    // A page that is used again is no longer cold
+    if (pageFrame[frameIndex].hint == EH_EVICT_SOON)
+    {
+        pageFrame[frameIndex].hint = EH_NONE;
+    }
+
+    // Count the hit, and whether prefetching the page paid off
+    getStats(bm)->hits++;
+    if (pageFrame[frameIndex].prefetched)
+    {
+        getStats(bm)->prefetchHits++;
+        pageFrame[frameIndex].prefetched = false;
+    }
 
     // Update hit number or reference number based on replacement strategy
     switch (bm->strategy)
     {
+    case RS_FIFO:
+        // The queue order does not change on a hit
+        break;
     case RS_LRU:
-        hit++;
-        pageFrame[frameIndex].hitNum = hit;
+        poolInfo->hit++;
+        pageFrame[frameIndex].hitNum = poolInfo->hit;
         break;
     case RS_CLOCK:
         pageFrame[frameIndex].hitNum = 1;
@@ -529,29 +1670,30 @@ extern RC handlePageInMemory(BM_BufferPool *const bm, BM_PageHandle *const page,
 }
 
 // This function is called when the buffer pool is full and a new page needs to be loaded into memory.
-extern RC handleBufferFull(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum, PageFrame *pageFrame, int i)
+extern RC handleBufferFull(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum, PageFrame *pageFrame, int i, SM_PageHandle preloaded)
 {
     // Initialize a new page frame object
     PageFrame *newPageFrame = &pageFrame[i];
 
-    // Open the file and read the page into the new page frame's data
-    SM_FileHandle fh;
-
-    newPageFrame->data = (SM_PageHandle)malloc(PAGE_SIZE);
-    openPageFile(bm->pageFile, &fh);
-    readBlock(pageNum, &fh, newPageFrame->data);
+    // Read the page into the new page frame's data
+    readPageData(bm, pageNum, preloaded, newPageFrame->data);
 
     // Set the other properties of the new page frame
     newPageFrame->fixCount = 1;
     newPageFrame->refNum = 0;
     newPageFrame->pageNum = pageNum;
+    newPageFrame->accessTime = nextAccessTime(bm);
+    newPageFrame->hint = EH_NONE;
+    newPageFrame->prefetched = false;
+    getStats(bm)->misses++;
 
     // Increase index and hit
-    hit++;
-    rearIndex++;
+    PoolInfo *poolInfo = (PoolInfo *)bm->mgmtData;
+    poolInfo->hit++;
+    poolInfo->rearIndex++;
 
     // Set the hit number based on the replacement strategy
-    newPageFrame->hitNum = (bm->strategy == RS_LRU) ? hit : ((bm->strategy == RS_CLOCK) ? 1 : 0);
+    newPageFrame->hitNum = (bm->strategy == RS_LRU) ? poolInfo->hit : ((bm->strategy == RS_CLOCK) ? 1 : 0);
 
     // Set the properties of the page handle
     page->pageNum = pageNum;
@@ -559,24 +1701,57 @@ extern RC handleBufferFull(BM_BufferPool *const bm, BM_PageHandle *const page, c
     return RC_OK;
 }
 
+RC pinPageWithData(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum, SM_PageHandle preloaded,
+                    long preloadedWrites);
 // It checks if the requested page is already in the buffer pool and handles it if present.
 extern RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum)
+{
+    long long startNanos = currentNanos();
+    RC result = pinPageWithData(bm, page, pageNum, NULL, 0);
+    getStats(bm)->pinWaitNanos += currentNanos() - startNanos;
+    return result;
+}
+
+// It pins a page like pinPage, but takes the page content from preloaded on a miss if it is not NULL.
+// A shared pool only uses preloaded if no page was written back since its counter read preloadedWrites.
+extern RC pinPageWithData(BM_BufferPool *const bm, BM_PageHandle *const page, const PageNumber pageNum, SM_PageHandle preloaded,
+                           long preloadedWrites)
 {
 
     int x;
     // loading pageFrame with bufferpool data
-    PageFrame *pageFrame = (PageFrame *)bm->mgmtData;
+    PageFrame *pageFrame = getPageFrames(bm);
+    getStats(bm)->numPins++;
+    traceEvent(bm, TRACE_PIN, pageNum);
+
+    // The frames of a shared pool live in the shared memory segment
+    if (getSharedPool(bm) != NULL)
+    {
+        RC status = pinSharedPage(bm, getSharedPool(bm), pageNum, preloaded, preloadedWrites, page);
+        if (status == RC_OK)
+        {
+            ((PoolInfo *)bm->mgmtData)->sharedPins++;
+        }
+        return status;
+    }
+
     x = pageFrame[0].pageNum;
 
+    // An adaptive pool replays the pin on its shadow directories first
+    if (((PoolInfo *)bm->mgmtData)->adaptive)
+    {
+        adaptStrategy(bm, pageNum);
+    }
+
     // pinning the first page only if the buffer pool is empty
     if (x == -1)
     {
-        handleFirstPage(bm, page, pageNum, pageFrame);
+        handleFirstPage(bm, page, pageNum, pageFrame, preloaded);
         return RC_OK;
     }
 
     bool isBufferFull = true;
-    for (int i = 0; i < bufferSize; i++)
+    for (int i = 0; i < bm->numPages; i++)
     {
         // If page is in memory
         if (pageFrame[i].pageNum == pageNum)
@@ -588,7 +1763,7 @@ extern RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page, const Page
         // If the buffer has an empty slot
         else if (pageFrame[i].pageNum == -1)
         {
-            handleBufferFull(bm, page, pageNum, pageFrame, i);
+            handleBufferFull(bm, page, pageNum, pageFrame, i, preloaded);
             isBufferFull = false;
             break;
         }
@@ -596,72 +1771,382 @@ extern RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page, const Page
 
     if (isBufferFull)
     {
-        // Allocate and initialize a new page frame
+        // Describe the new page, it is read once the replacement strategy has chosen its frame
         PageFrame *newPage = calloc(1, sizeof(PageFrame));
 
-        // Open the page file
-        SM_FileHandle fh;
-        openPageFile(bm->pageFile, &fh);
-
-        // Allocate and read data into the new page frame
-        newPage->data = calloc(PAGE_SIZE, sizeof(char));
-        readBlock(pageNum, &fh, newPage->data);
-
         // Initialize the new page frame properties
         newPage->dirtyBit = 0;
         newPage->pageNum = pageNum;
         newPage->refNum = 0;
         newPage->fixCount = 1;
 
-        // Update index and hit count
-        rearIndex++;
-        hit++;
+        // Set hit number based on buffer strategy, the counters only advance once a frame has been found
+        PoolInfo *poolInfo = (PoolInfo *)bm->mgmtData;
+        newPage->hitNum = (bm->strategy == RS_LRU) ? poolInfo->hit + 1 : ((bm->strategy == RS_CLOCK) ? 1 : 0);
+
+        // Frames hinted as cold are reclaimed first, without asking the replacement strategy
+        int coldIndex = popColdFrame(bm);
+        if (coldIndex != -1)
+        {
+            replaceColdFrame(bm, &pageFrame[coldIndex], newPage);
+        }
+        else
+        {
+
+            void (*strategyFunction)(BM_BufferPool *const, PageFrame *const) = NULL;
+            switch (bm->strategy)
+            {
+            case RS_FIFO:
+                strategyFunction = FIFO;
+                break;
+            case RS_LRU:
+                strategyFunction = LRU;
+                break;
+            case RS_CLOCK:
+                strategyFunction = CLOCK;
+                break;
+            // case RS_LFU: strategyFunction = LFU; break;
+            default:
+                printf("\nAlgorithm Not Implemented\n");
+                break;
+            }
+            if (strategyFunction)
+                strategyFunction(bm, newPage);
+        }
+        free(newPage);
+
+        // Every frame is pinned if the strategy found no victim
+        int frameIndex = findPageInBuffer(bm, pageNum);
+        if (frameIndex == -1)
+        {
+            return RC_PINNED_PAGES_IN_BUFFER;
+        }
 
-        // Set hit number based on buffer strategy
-        newPage->hitNum = (bm->strategy == RS_LRU) ? hit : ((bm->strategy == RS_CLOCK) ? 1 : 0);
+        // The pool was full, so another page made room. Update index, hit count and access time.
+        poolInfo->rearIndex++;
+        poolInfo->hit++;
+        pageFrame[frameIndex].accessTime = nextAccessTime(bm);
+        getStats(bm)->misses++;
+        getStats(bm)->evictions++;
 
-        // Update the page properties
+        // Read the page into the buffer of its frame
+        readPageData(bm, pageNum, preloaded, pageFrame[frameIndex].data);
         page->pageNum = pageNum;
-        page->data = newPage->data;
+        page->data = pageFrame[frameIndex].data;
+    }
+    return RC_OK;
+}
+
+// This function orders page numbers ascending.
+int comparePageNums(const void *left, const void *right)
+{
+    PageNumber l = *(const PageNumber *)left;
+    PageNumber r = *(const PageNumber *)right;
+    return (l > r) - (l < r);
+}
+
+// It unpins the pages a failed pinPages call has pinned, so the call leaves no pins behind.
+void unpinPinnedPages(BM_BufferPool *const bm, BM_PageHandle *const pages, const bool *isPinned, const int numPages)
+{
+    for (int i = 0; i < numPages; i++)
+    {
+        if (isPinned[i])
+            unpinPage(bm, &pages[i]);
+    }
+}
+
+// It pins several pages at once. Pages already in the buffer pool are pinned first, the missing pages
+// are sorted and runs of consecutive page numbers are read from the page file with one request each.
+// Either all pages are pinned or none: after the first failure the pages pinned so far are unpinned again.
+extern RC pinPages(BM_BufferPool *const bm, BM_PageHandle *const pages, const PageNumber *const pageNums, const int numPages)
+{
+    // All pages stay pinned, so they have to fit into the buffer pool together
+    if (pages == NULL || pageNums == NULL || numPages <= 0 || numPages > bm->numPages)
+    {
+        return RC_INVALID_PARAMETER;
+    }
+
+    bool *isPinned = (bool *)calloc(numPages, sizeof(bool));
+    RC result = RC_OK;
+
+    // A shared pool pins page by page, the segment reads its misses under its latch
+    if (getSharedPool(bm) != NULL)
+    {
+        for (int i = 0; i < numPages && result == RC_OK; i++)
+        {
+            result = pinPageWithData(bm, &pages[i], pageNums[i], NULL, 0);
+            isPinned[i] = result == RC_OK;
+        }
+        if (result != RC_OK)
+            unpinPinnedPages(bm, pages, isPinned, numPages);
+        free(isPinned);
+        return result;
+    }
 
-        void (*strategyFunction)(BM_BufferPool *const, PageFrame *const) = NULL;
-        switch (bm->strategy)
+    long long startNanos = currentNanos();
+    PageNumber *missPages = (PageNumber *)malloc(numPages * sizeof(PageNumber));
+    bool *isMiss = (bool *)calloc(numPages, sizeof(bool));
+    int numMisses = 0;
+
+    // Resolve the hits first so that they cannot be chosen as victims for the misses
+    for (int i = 0; i < numPages && result == RC_OK; i++)
+    {
+        if (findPageInBuffer(bm, pageNums[i]) != -1)
         {
-        case RS_FIFO:
-            strategyFunction = FIFO;
-            break;
-        case RS_LRU:
-            strategyFunction = LRU;
-            break;
-        case RS_CLOCK:
-            strategyFunction = CLOCK;
-            break;
-        // case RS_LFU: strategyFunction = LFU; break;
-        default:
-            printf("\nAlgorithm Not Implemented\n");
-            break;
+            result = pinPageWithData(bm, &pages[i], pageNums[i], NULL, 0);
+            isPinned[i] = result == RC_OK;
+        }
+        else
+        {
+            isMiss[i] = true;
+            missPages[numMisses++] = pageNums[i];
+        }
+    }
+
+    // Sort the missing pages and drop duplicates, nothing is read once a hit could not be pinned
+    if (result != RC_OK)
+        numMisses = 0;
+    qsort(missPages, numMisses, sizeof(PageNumber), comparePageNums);
+    int numUnique = 0;
+    for (int i = 0; i < numMisses; i++)
+    {
+        if (numUnique == 0 || missPages[numUnique - 1] != missPages[i])
+            missPages[numUnique++] = missPages[i];
+    }
+
+    // Read every run of consecutive pages with a single request
+    SM_PageHandle missData = NULL;
+    bool *isRead = (bool *)calloc(numUnique > 0 ? numUnique : 1, sizeof(bool));
+    SM_FileHandle fh;
+    if (numUnique > 0 && openPageFile(bm->pageFile, &fh) == RC_OK)
+    {
+        missData = (SM_PageHandle)malloc((size_t)numUnique * bm->pageSize);
+        ensureCapacity(missPages[numUnique - 1] + 1, &fh);
+
+        for (int start = 0; start < numUnique;)
+        {
+            int end = start + 1;
+            while (end < numUnique && missPages[end] == missPages[end - 1] + 1)
+            {
+                end++;
+            }
+
+            long long readNanos = currentNanos();
+            if (readBlocks(missPages[start], end - start, &fh, missData + (size_t)start * bm->pageSize) == RC_OK)
+            {
+                recordRead(bm, end - start, readNanos);
+                for (int k = start; k < end; k++)
+                    isRead[k] = true;
+            }
+
+            start = end;
+        }
+
+        closePageFile(&fh);
+    }
+
+    // Place the missing pages into frames, pages whose run could not be read fall back to pinPage
+    for (int i = 0; i < numPages && result == RC_OK; i++)
+    {
+        if (!isMiss[i])
+            continue;
+
+        PageNumber *found = (PageNumber *)bsearch(&pageNums[i], missPages, numUnique, sizeof(PageNumber), comparePageNums);
+        int index = (int)(found - missPages);
+        SM_PageHandle preloaded = isRead[index] ? missData + (size_t)index * bm->pageSize : NULL;
+
+        result = pinPageWithData(bm, &pages[i], pageNums[i], preloaded, 0);
+        isPinned[i] = result == RC_OK;
+    }
+    if (result != RC_OK)
+        unpinPinnedPages(bm, pages, isPinned, numPages);
+
+    free(missData);
+    free(isRead);
+    free(isMiss);
+    free(isPinned);
+    free(missPages);
+
+    getStats(bm)->pinWaitNanos += currentNanos() - startNanos;
+    return result;
+}
+
+// It starts pinning a page without waiting for the read. A page that is already in the buffer pool is pinned
+// right away, otherwise the read is issued asynchronously and the page is placed into a frame when the request
+// is awaited.
+extern RC pinPageAsync(BM_BufferPool *const bm, BM_PinRequest *const request, const PageNumber pageNum)
+{
+    if (request == NULL || pageNum < 0)
+    {
+        return RC_INVALID_PARAMETER;
+    }
+
+    request->pageNum = pageNum;
+    request->done = false;
+    request->mgmtData = NULL;
+
+    // A hit needs no I/O, so the request is complete immediately. The page table of a shared pool
+    // may change before the request is awaited, so its pins always go through the read.
+    if (getSharedPool(bm) == NULL && findPageInBuffer(bm, pageNum) != -1)
+    {
+        BM_PageHandle page;
+        request->done = true;
+        return pinPage(bm, &page, pageNum);
+    }
+
+    PinRequestInfo *info = (PinRequestInfo *)calloc(1, sizeof(PinRequestInfo));
+    info->data = (SM_PageHandle)calloc(bm->pageSize, sizeof(char));
+
+    RC status = openPageFile(bm->pageFile, &info->fh);
+    if (status == RC_OK)
+    {
+        // Pages beyond the end of the file are created and read as empty pages
+        ensureCapacity(pageNum + 1, &info->fh);
+        if (getSharedPool(bm) != NULL)
+        {
+            info->sharedWrites = getSharedPoolWrites(getSharedPool(bm));
+        }
+        info->startNanos = currentNanos();
+        status = readBlockAsync(pageNum, &info->fh, info->data, &info->read);
+        if (status != RC_OK)
+        {
+            closePageFile(&info->fh);
         }
-        if (strategyFunction)
-            strategyFunction(bm, newPage);
     }
+
+    if (status != RC_OK)
+    {
+        free(info->data);
+        free(info);
+        return status;
+    }
+
+    // Remember the request so that a write back of its page while the read is in flight marks it stale
+    info->pageNum = pageNum;
+    if (getSharedPool(bm) == NULL)
+    {
+        PoolInfo *poolInfo = (PoolInfo *)bm->mgmtData;
+        info->next = poolInfo->pendingReads;
+        poolInfo->pendingReads = info;
+    }
+
+    request->mgmtData = info;
     return RC_OK;
 }
 
+// This function releases the state of a pin request whose read has completed.
+void finishPinRequest(BM_BufferPool *const bm, BM_PinRequest *const request, PinRequestInfo *info, RC status)
+{
+    if (status == RC_OK)
+    {
+        recordRead(bm, 1, info->startNanos);
+    }
+
+    closePageFile(&info->fh);
+    info->status = status;
+    request->done = true;
+}
+
+// It returns true if the read of a pin request has completed, without blocking.
+extern bool pollPinRequest(BM_BufferPool *const bm, BM_PinRequest *const request)
+{
+    if (request == NULL)
+    {
+        return false;
+    }
+
+    if (!request->done)
+    {
+        PinRequestInfo *info = (PinRequestInfo *)request->mgmtData;
+        RC status = pollBlockAsync(&info->read);
+        if (status != RC_IO_IN_PROGRESS)
+        {
+            finishPinRequest(bm, request, info, status);
+        }
+    }
+
+    return request->done;
+}
+
+// It waits for a pin request to complete, places the page into a frame and fills the page handle.
+extern RC awaitPinRequest(BM_BufferPool *const bm, BM_PinRequest *const request, BM_PageHandle *const page)
+{
+    if (request == NULL || page == NULL)
+    {
+        return RC_INVALID_PARAMETER;
+    }
+
+    PinRequestInfo *info = (PinRequestInfo *)request->mgmtData;
+
+    // Hits were pinned when the request was issued
+    if (info == NULL)
+    {
+        PageFrame *pageFrames = getPageFrames(bm);
+        int frameIndex = findPageInBuffer(bm, request->pageNum);
+        if (frameIndex == -1)
+        {
+            return RC_ERROR;
+        }
+
+        page->pageNum = request->pageNum;
+        page->data = pageFrames[frameIndex].data;
+        return RC_OK;
+    }
+
+    long long startNanos = currentNanos();
+    if (!request->done)
+    {
+        finishPinRequest(bm, request, info, waitBlockAsync(&info->read));
+    }
+
+    // The request is no longer pending once its page is placed into a frame
+    PinRequestInfo **link = &((PoolInfo *)bm->mgmtData)->pendingReads;
+    while (*link != NULL && *link != info)
+    {
+        link = &(*link)->next;
+    }
+    if (*link != NULL)
+    {
+        *link = info->next;
+    }
+
+    // The page may have been pinned by someone else in the meantime, pinPageWithData then uses the frame's copy.
+    // A page written back while the read was in flight is read again, the buffer may hold the old content.
+    RC status = info->status;
+    if (status == RC_OK)
+    {
+        status = pinPageWithData(bm, page, request->pageNum, info->stale ? NULL : info->data, info->sharedWrites);
+    }
+    getStats(bm)->pinWaitNanos += currentNanos() - startNanos;
+
+    free(info->data);
+    free(info);
+    request->mgmtData = NULL;
+    return status;
+}
+
 // This function returns an array of page numbers.
 extern PageNumber *getFrameContents(BM_BufferPool *const bm)
 {
     // Allocate memory for frameContents and initialize with NO_PAGE
-    PageNumber *frameContents = (PageNumber *)calloc(bufferSize, sizeof(PageNumber));
+    PageNumber *frameContents = (PageNumber *)calloc(bm->numPages, sizeof(PageNumber));
 
     // Assign NO_PAGE for all elements
-    for (int i = 0; i < bufferSize; i++)
+    for (int i = 0; i < bm->numPages; i++)
         frameContents[i] = NO_PAGE;
 
-    // Get the management data from buffer pool
-    PageFrame *pageFrame = (PageFrame *)bm->mgmtData;
+    // The frames of a shared pool are read under the latch of the segment
+    if (getSharedPool(bm) != NULL)
+    {
+        getSharedPoolContents(getSharedPool(bm), frameContents, NULL, NULL);
+        return frameContents;
+    }
+
+    // Get the page frames of the buffer pool
+    PageFrame *pageFrame = getPageFrames(bm);
 
     // Update frameContents with the page numbers of the pages in the buffer pool
-    for (int i = 0; i < bufferSize; i++)
+    for (int i = 0; i < bm->numPages; i++)
     {
         // If the page number is not -1, then the page is in the buffer pool
         if (pageFrame[i].pageNum != -1)
@@ -677,13 +2162,19 @@ extern PageNumber *getFrameContents(BM_BufferPool *const bm)
 extern bool *getDirtyFlags(BM_BufferPool *const bm)
 {
     // Allocate memory for dirtyFlags
-    bool *dirtyFlags = (bool *)malloc(bufferSize * sizeof(bool));
+    bool *dirtyFlags = (bool *)malloc(bm->numPages * sizeof(bool));
 
-    // Get the management data from buffer pool
-    PageFrame *pageFrame = (PageFrame *)bm->mgmtData;
+    if (getSharedPool(bm) != NULL)
+    {
+        getSharedPoolContents(getSharedPool(bm), NULL, dirtyFlags, NULL);
+        return dirtyFlags;
+    }
+
+    // Get the page frames of the buffer pool
+    PageFrame *pageFrame = getPageFrames(bm);
 
     // Set dirtyFlags based on the dirtyBit of the pages in the buffer pool
-    for (int i = 0; i < bufferSize; i++)
+    for (int i = 0; i < bm->numPages; i++)
     {
         dirtyFlags[i] = pageFrame[i].dirtyBit == 1;
     }
@@ -695,13 +2186,19 @@ extern bool *getDirtyFlags(BM_BufferPool *const bm)
 extern int *getFixCounts(BM_BufferPool *const bm)
 {
     // Allocate memory for fixCounts
-    int *fixCounts = (int *)malloc(bufferSize * sizeof(int));
+    int *fixCounts = (int *)malloc(bm->numPages * sizeof(int));
+
+    if (getSharedPool(bm) != NULL)
+    {
+        getSharedPoolContents(getSharedPool(bm), NULL, NULL, fixCounts);
+        return fixCounts;
+    }
 
-    // Get the management data from buffer pool
-    PageFrame *pageFrame = (PageFrame *)bm->mgmtData;
+    // Get the page frames of the buffer pool
+    PageFrame *pageFrame = getPageFrames(bm);
 
     // Initialize fixCounts based on the fixCount of the pages in the buffer pool
-    for (int i = 0; i < bufferSize; i++)
+    for (int i = 0; i < bm->numPages; i++)
     {
         // Assign 0 if fixCount is -1, otherwise assign fixCount
         fixCounts[i] = pageFrame[i].fixCount == -1 ? 0 : pageFrame[i].fixCount;
@@ -710,16 +2207,38 @@ extern int *getFixCounts(BM_BufferPool *const bm)
     return fixCounts;
 }
 
-// Directly returns the number of read IOs based on the rearIndex
+// Returns the number of pages read from disk since the pool was initialized
 extern int getNumReadIO(BM_BufferPool *const bm)
 {
-    // Calculate the number of read IOs directly
-    return rearIndex >= 0 ? rearIndex + 1 : 0;
+    return (int)getStats(bm)->numReadIO;
 }
 
-// Directly returns the global writeCount variable
+// Returns the number of pages written to disk since the pool was initialized
 extern int getNumWriteIO(BM_BufferPool *const bm)
 {
-    // Return the number of write IOs directly
-    return writeCount > 0 ? writeCount : 0;
+    return (int)getStats(bm)->numWriteIO;
+}
+
+// This function copies the counters of the buffer pool into stats.
+extern RC getPoolStats(BM_BufferPool *const bm, BM_Stats *stats)
+{
+    if (bm == NULL || bm->mgmtData == NULL || stats == NULL)
+    {
+        return RC_INVALID_PARAMETER;
+    }
+
+    *stats = *getStats(bm);
+    return RC_OK;
+}
+
+// This function sets all counters of the buffer pool back to zero.
+extern RC resetPoolStats(BM_BufferPool *const bm)
+{
+    if (bm == NULL || bm->mgmtData == NULL)
+    {
+        return RC_INVALID_PARAMETER;
+    }
+
+    memset(getStats(bm), 0, sizeof(BM_Stats));
+    return RC_OK;
 }
@@ -13,9 +13,24 @@ typedef enum ReplacementStrategy {
 	RS_LRU = 1,
 	RS_CLOCK = 2,
 	RS_LFU = 3,
-	RS_LRU_K = 4
+	RS_LRU_K = 4,
+	RS_ADAPTIVE = 5 // runs FIFO, LRU or CLOCK, whichever misses least in the shadow directories
 } ReplacementStrategy;
 
+// Hints a client can give when unpinning a page
+typedef enum EvictionHint {
+	EH_NONE = 0,
+	EH_EVICT_SOON = 1, // the page will not be needed again, reclaim its frame first
+	EH_KEEP_HOT = 2 // the page will be needed again soon, evict it only if nothing else is left
+} EvictionHint;
+
+// Memory backing the frames of a buffer pool
+typedef enum BM_PageMemory {
+	PM_REGULAR = 0, // regular pages
+	PM_TRANSPARENT_HUGE = 1, // aligned mapping advised with madvise(MADV_HUGEPAGE), the kernel may use transparent huge pages
+	PM_HUGETLB = 2 // explicit huge pages (MAP_HUGETLB)
+} BM_PageMemory;
+
 // Data Types and Structures
 typedef int PageNumber;
 #define NO_PAGE -1
@@ -23,6 +38,7 @@ typedef int PageNumber;
 typedef struct BM_BufferPool {
 	char *pageFile;
 	int numPages;
+	int pageSize; // size of the pages of pageFile, every frame holds one page of this size
 	ReplacementStrategy strategy;
 	void *mgmtData; // use this one to store the bookkeeping info your buffer
 	// manager needs for a buffer pool
@@ -33,6 +49,50 @@ typedef struct BM_PageHandle {
 	char *data;
 } BM_PageHandle;
 
+// Handle of a pin that was issued with pinPageAsync
+typedef struct BM_PinRequest {
+	PageNumber pageNum;
+	bool done;
+	void *mgmtData; // state of the read while it is in flight
+} BM_PinRequest;
+
+// Number of buckets of the I/O latency histograms. Bucket 0 counts I/Os below 1 microsecond,
+// bucket i counts I/Os between 2^(i-1) and 2^i microseconds, the last bucket everything above.
+#define BM_LATENCY_BUCKETS 20
+
+// Snapshot of the counters of a buffer pool
+typedef struct BM_Stats {
+	long numPins; // pin requests, hits and misses
+	long hits;
+	long misses;
+	long evictions; // pages replaced to make room for another page
+	long dirtyEvictions; // evicted pages that had to be written back first
+	long prefetchedPages; // pages loaded ahead of their first pin
+	long prefetchHits; // prefetched pages that were pinned before being evicted
+	long numReadIO; // pages read from the page file
+	long numWriteIO; // pages written to the page file
+	long long pinWaitNanos; // total time spent inside pin calls
+	long strategySwitches; // changes of the active strategy of an RS_ADAPTIVE pool
+	long victimStores; // evicted pages kept in the compressed victim cache
+	long victimHits; // misses served from the victim cache instead of the page file
+	long readLatency[BM_LATENCY_BUCKETS]; // read requests per latency bucket
+	long writeLatency[BM_LATENCY_BUCKETS]; // write requests per latency bucket
+} BM_Stats;
+
+// Operations recorded in a buffer pool trace
+typedef enum BM_TraceOp {
+	TRACE_PIN = 0,
+	TRACE_UNPIN = 1,
+	TRACE_MARK_DIRTY = 2
+} BM_TraceOp;
+
+// A trace file starts with BM_TRACE_MAGIC followed by one 32 bit word per event,
+// holding the page number in the upper 30 bits and the operation in the lower 2 bits
+#define BM_TRACE_MAGIC 0x52544D42
+#define BM_TRACE_ENCODE(op, pageNum) ((((unsigned int) (pageNum)) << 2) | (unsigned int) (op))
+#define BM_TRACE_OP(word) ((BM_TraceOp) ((word) & 3))
+#define BM_TRACE_PAGE(word) ((PageNumber) ((word) >> 2))
+
 // convenience macros
 #define MAKE_POOL()					\
 		((BM_BufferPool *) malloc (sizeof(BM_BufferPool)))
@@ -46,13 +106,29 @@ RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
 		void *stratData);
 RC shutdownBufferPool(BM_BufferPool *const bm);
 RC forceFlushPool(BM_BufferPool *const bm);
+RC initSharedBufferPool(BM_BufferPool *const bm, const char *const pageFileName, const int numPages,
+		ReplacementStrategy strategy, const char *const shmName);
+RC setBufferPoolWarmup(BM_BufferPool *const bm, bool enabled);
+RC setBufferPoolVictimCache(BM_BufferPool *const bm, long maxBytes);
+BM_PageMemory getPoolPageMemory(BM_BufferPool *const bm);
+RC startPoolTrace(BM_BufferPool *const bm, const char *const traceFileName);
+RC stopPoolTrace(BM_BufferPool *const bm);
 
 // Buffer Manager Interface Access Pages
 RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page);
+RC unpinPageWithHint (BM_BufferPool *const bm, BM_PageHandle *const page,
+		EvictionHint hint);
 RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page, 
 		const PageNumber pageNum);
+RC pinPages (BM_BufferPool *const bm, BM_PageHandle *const pages,
+		const PageNumber *const pageNums, const int numPages);
+RC pinPageAsync (BM_BufferPool *const bm, BM_PinRequest *const request,
+		const PageNumber pageNum);
+bool pollPinRequest (BM_BufferPool *const bm, BM_PinRequest *const request);
+RC awaitPinRequest (BM_BufferPool *const bm, BM_PinRequest *const request,
+		BM_PageHandle *const page);
 
 // Statistics Interface
 PageNumber *getFrameContents (BM_BufferPool *const bm);
@@ -60,5 +136,7 @@ bool *getDirtyFlags (BM_BufferPool *const bm);
 int *getFixCounts (BM_BufferPool *const bm);
 int getNumReadIO (BM_BufferPool *const bm);
 int getNumWriteIO (BM_BufferPool *const bm);
+RC getPoolStats (BM_BufferPool *const bm, BM_Stats *stats);
+RC resetPoolStats (BM_BufferPool *const bm);
 
 #endif
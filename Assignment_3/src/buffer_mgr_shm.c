@@ -0,0 +1,508 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "buffer_mgr_shm.h"
+
+// Marks a segment laid out by this version of the code.
+#define SHM_POOL_MAGIC 0x4D485343
+
+// Longest page file and segment name stored in the header.
+#define SHM_NAME_LENGTH 256
+
+// How long a process waits for the creator of a segment to finish setting it up.
+#define SHM_ATTACH_TIMEOUT_MS 2000
+
+// Descriptor of a frame in the segment: page table entry and replacement metadata.
+typedef struct ShmFrame {
+    PageNumber pageNum; // Page held by the frame, NO_PAGE if the frame is empty.
+    int fixCount; // Pins of all processes together.
+    int dirtyBit; // Whether the page was modified and not yet written back.
+    int refBit; // Reference bit (CLOCK).
+    long loadTime; // Time the page was loaded (FIFO).
+    long accessTime; // Time of the last pin (LRU).
+} ShmFrame;
+
+// Header at the start of the segment. Frame descriptors and page data follow at fixed offsets.
+struct BM_SharedPool {
+    unsigned int magic;
+    int ready; // Set by the creator once the segment is initialized.
+    int numPages;
+    int pageSize; // Size of the page data of every frame.
+    ReplacementStrategy strategy;
+    char pageFile[SHM_NAME_LENGTH];
+    char shmName[SHM_NAME_LENGTH];
+    pthread_mutex_t latch; // Process-shared latch protecting everything below and the frames.
+    int attached; // Number of processes attached to the segment.
+    long clock; // Logical clock, advanced on every pin.
+    int hand; // Next frame inspected by CLOCK.
+    long writes; // Pages written back, tells a process whether a page it read without the latch is still current.
+    size_t size; // Size of the segment.
+    size_t dataOffset; // Offset of the page data from the start of the segment.
+};
+
+// Defined in buffer_mgr.c, used to keep the counters of the attached pool.
+BM_Stats *getStats(BM_BufferPool *const bm);
+void recordRead(BM_BufferPool *const bm, int numPages, long long startNanos);
+void recordWrite(BM_BufferPool *const bm, long long startNanos);
+long long currentNanos();
+
+// This function rounds size up to a multiple of alignment.
+static size_t alignUp(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+// This function returns the frame descriptors of the segment.
+static ShmFrame *getShmFrames(BM_SharedPool *pool)
+{
+    return (ShmFrame *)((char *)pool + alignUp(sizeof(BM_SharedPool), 64));
+}
+
+// This function returns the page data of a frame.
+static char *getShmData(BM_SharedPool *pool, int frameIndex)
+{
+    return (char *)pool + pool->dataOffset + (size_t)frameIndex * pool->pageSize;
+}
+
+// This function acquires the latch. If its previous owner died while holding it, the latch is taken over.
+static void lockSharedPool(BM_SharedPool *pool)
+{
+    if (pthread_mutex_lock(&pool->latch) == EOWNERDEAD)
+    {
+        pthread_mutex_consistent(&pool->latch);
+    }
+}
+
+// This function releases the latch.
+static void unlockSharedPool(BM_SharedPool *pool)
+{
+    pthread_mutex_unlock(&pool->latch);
+}
+
+// This function sleeps for a millisecond while waiting for another process.
+static void waitMillisecond()
+{
+    struct timespec delay = {0, 1000000};
+    nanosleep(&delay, NULL);
+}
+
+// This function returns the frame holding a page, or -1.
+static int findSharedPage(BM_SharedPool *pool, const PageNumber pageNum)
+{
+    ShmFrame *frames = getShmFrames(pool);
+
+    for (int i = 0; i < pool->numPages; i++)
+    {
+        if (frames[i].pageNum == pageNum)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+// This function writes the page of a frame back to the page file. The caller holds the latch.
+static RC writeSharedFrame(BM_BufferPool *const bm, BM_SharedPool *pool, int frameIndex)
+{
+    ShmFrame *frame = &getShmFrames(pool)[frameIndex];
+    SM_FileHandle fh;
+
+    if (openPageFile(pool->pageFile, &fh) != RC_OK)
+    {
+        return RC_FILE_NOT_FOUND;
+    }
+
+    long long startNanos = currentNanos();
+    RC status = writeBlock(frame->pageNum, &fh, getShmData(pool, frameIndex));
+    closePageFile(&fh);
+
+    if (status == RC_OK)
+    {
+        frame->dirtyBit = 0;
+        pool->writes++;
+        recordWrite(bm, startNanos);
+    }
+    return status;
+}
+
+// This function picks the unpinned frame the replacement strategy of the segment evicts, or -1 if all are pinned.
+// The caller holds the latch.
+static int chooseSharedVictim(BM_SharedPool *pool)
+{
+    ShmFrame *frames = getShmFrames(pool);
+    int victim = -1;
+
+    if (pool->strategy == RS_CLOCK)
+    {
+        // Two sweeps clear every reference bit, so an unpinned frame is found if there is one
+        for (int steps = 0; steps < 2 * pool->numPages; steps++)
+        {
+            int index = pool->hand;
+            pool->hand = (pool->hand + 1) % pool->numPages;
+
+            if (frames[index].fixCount != 0)
+                continue;
+            if (frames[index].refBit == 0)
+                return index;
+            frames[index].refBit = 0;
+        }
+        return -1;
+    }
+
+    // FIFO evicts the page loaded first, LRU the page pinned least recently
+    for (int i = 0; i < pool->numPages; i++)
+    {
+        if (frames[i].fixCount != 0)
+            continue;
+
+        long stamp = (pool->strategy == RS_FIFO) ? frames[i].loadTime : frames[i].accessTime;
+        long victimStamp = (victim == -1) ? 0 : ((pool->strategy == RS_FIFO) ? frames[victim].loadTime : frames[victim].accessTime);
+        if (victim == -1 || stamp < victimStamp)
+            victim = i;
+    }
+    return victim;
+}
+
+// This function sets up a segment that was just created and sized.
+static void initSharedSegment(BM_SharedPool *pool, const char *const shmName, const char *const pageFile,
+                              const int numPages, const int pageSize, ReplacementStrategy strategy,
+                              size_t size, size_t dataOffset)
+{
+    pthread_mutexattr_t attributes;
+    ShmFrame *frames;
+
+    pool->magic = SHM_POOL_MAGIC;
+    pool->numPages = numPages;
+    pool->pageSize = pageSize;
+    pool->strategy = strategy;
+    strncpy(pool->pageFile, pageFile, SHM_NAME_LENGTH - 1);
+    strncpy(pool->shmName, shmName, SHM_NAME_LENGTH - 1);
+    pool->size = size;
+    pool->dataOffset = dataOffset;
+
+    // The latch works across processes and survives the death of its owner
+    pthread_mutexattr_init(&attributes);
+    pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init(&pool->latch, &attributes);
+    pthread_mutexattr_destroy(&attributes);
+
+    frames = getShmFrames(pool);
+    for (int i = 0; i < numPages; i++)
+    {
+        frames[i].pageNum = NO_PAGE;
+    }
+
+    // Other processes may use the segment from now on
+    __atomic_store_n(&pool->ready, 1, __ATOMIC_RELEASE);
+}
+
+// This function maps the shared segment shmName, creating it if no process has it yet.
+// A segment that already exists must have been created for the same page file, number of frames and page size.
+RC attachSharedPool(const char *const shmName, const char *const pageFile, const int numPages,
+                    const int pageSize, ReplacementStrategy strategy, BM_SharedPool **pool)
+{
+    if (shmName == NULL || shmName[0] != '/' || strlen(shmName) >= SHM_NAME_LENGTH ||
+        pageFile == NULL || strlen(pageFile) >= SHM_NAME_LENGTH || numPages <= 0 || pageSize <= 0)
+    {
+        return RC_INVALID_PARAMETER;
+    }
+
+    size_t dataOffset = alignUp(alignUp(sizeof(BM_SharedPool), 64) + numPages * sizeof(ShmFrame), PAGE_SIZE);
+    size_t size = dataOffset + (size_t)numPages * pageSize;
+    bool created = true;
+
+    int fd = shm_open(shmName, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd == -1 && errno == EEXIST)
+    {
+        created = false;
+        fd = shm_open(shmName, O_RDWR, 0600);
+    }
+    if (fd == -1)
+    {
+        return RC_SHM_FAILED;
+    }
+
+    if (created && ftruncate(fd, size) != 0)
+    {
+        close(fd);
+        shm_unlink(shmName);
+        return RC_SHM_FAILED;
+    }
+
+    // The creator may not have sized the segment yet
+    struct stat status;
+    int waited = 0;
+    while (!created && fstat(fd, &status) == 0 && status.st_size == 0 && waited++ < SHM_ATTACH_TIMEOUT_MS)
+    {
+        waitMillisecond();
+    }
+    if (!created && (size_t)status.st_size != size)
+    {
+        close(fd);
+        return RC_INVALID_PARAMETER;
+    }
+
+    BM_SharedPool *mapped = (BM_SharedPool *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        if (created)
+            shm_unlink(shmName);
+        return RC_SHM_FAILED;
+    }
+
+    if (created)
+    {
+        initSharedSegment(mapped, shmName, pageFile, numPages, pageSize, strategy, size, dataOffset);
+    }
+
+    // Wait until the creator has initialized the latch and the frames
+    waited = 0;
+    while (!__atomic_load_n(&mapped->ready, __ATOMIC_ACQUIRE) && waited++ < SHM_ATTACH_TIMEOUT_MS)
+    {
+        waitMillisecond();
+    }
+    if (!mapped->ready || mapped->magic != SHM_POOL_MAGIC || mapped->numPages != numPages || mapped->pageSize != pageSize ||
+        strcmp(mapped->pageFile, pageFile) != 0)
+    {
+        munmap(mapped, size);
+        return RC_INVALID_PARAMETER;
+    }
+
+    // A segment whose last process is detaching is about to be removed
+    lockSharedPool(mapped);
+    if (!created && mapped->attached == 0)
+    {
+        unlockSharedPool(mapped);
+        munmap(mapped, size);
+        return RC_SHM_FAILED;
+    }
+    mapped->attached++;
+    unlockSharedPool(mapped);
+
+    *pool = mapped;
+    return RC_OK;
+}
+
+// This function unmaps the segment. The last process writes back the dirty pages and removes the segment.
+RC detachSharedPool(BM_BufferPool *const bm, BM_SharedPool *pool)
+{
+    char shmName[SHM_NAME_LENGTH];
+    size_t size = pool->size;
+    bool last;
+
+    lockSharedPool(pool);
+    pool->attached--;
+    last = pool->attached == 0;
+    if (last)
+    {
+        ShmFrame *frames = getShmFrames(pool);
+        for (int i = 0; i < pool->numPages; i++)
+        {
+            if (frames[i].pageNum != NO_PAGE && frames[i].dirtyBit == 1)
+            {
+                writeSharedFrame(bm, pool, i);
+            }
+        }
+    }
+    strcpy(shmName, pool->shmName);
+    unlockSharedPool(pool);
+
+    // The latch is not destroyed, a process that opened the segment just now may still be waiting for it
+    if (last)
+    {
+        shm_unlink(shmName);
+    }
+
+    munmap(pool, size);
+    return RC_OK;
+}
+
+// This function pins a page of the shared pool. On a miss the page is taken from preloaded if it is not NULL,
+// otherwise it is read from the page file while the latch is held. preloaded was read when the segment had
+// counted preloadedWrites writes, it is dropped if pages were written back since as it may be outdated.
+RC pinSharedPage(BM_BufferPool *const bm, BM_SharedPool *pool, const PageNumber pageNum,
+                 SM_PageHandle preloaded, long preloadedWrites, BM_PageHandle *const page)
+{
+    ShmFrame *frames = getShmFrames(pool);
+    BM_Stats *stats = getStats(bm);
+
+    lockSharedPool(pool);
+    pool->clock++;
+    if (pool->writes != preloadedWrites)
+    {
+        preloaded = NULL;
+    }
+
+    // The page may have been loaded by any of the processes
+    int index = findSharedPage(pool, pageNum);
+    if (index != -1)
+    {
+        stats->hits++;
+    }
+    else
+    {
+        stats->misses++;
+
+        // Use an empty frame if there is one, otherwise ask the replacement strategy
+        index = findSharedPage(pool, NO_PAGE);
+        if (index == -1)
+        {
+            index = chooseSharedVictim(pool);
+            if (index == -1)
+            {
+                unlockSharedPool(pool);
+                return RC_PINNED_PAGES_IN_BUFFER;
+            }
+
+            stats->evictions++;
+            if (frames[index].dirtyBit == 1)
+            {
+                writeSharedFrame(bm, pool, index);
+                stats->dirtyEvictions++;
+            }
+        }
+
+        // Load the page into the frame
+        char *data = getShmData(pool, index);
+        if (preloaded != NULL)
+        {
+            memcpy(data, preloaded, pool->pageSize);
+        }
+        else
+        {
+            SM_FileHandle fh;
+            memset(data, 0, pool->pageSize);
+            if (openPageFile(pool->pageFile, &fh) == RC_OK)
+            {
+                ensureCapacity(pageNum + 1, &fh);
+                long long startNanos = currentNanos();
+                if (readBlock(pageNum, &fh, data) == RC_OK)
+                {
+                    recordRead(bm, 1, startNanos);
+                }
+                closePageFile(&fh);
+            }
+        }
+
+        frames[index].pageNum = pageNum;
+        frames[index].fixCount = 0;
+        frames[index].dirtyBit = 0;
+        frames[index].loadTime = pool->clock;
+    }
+
+    frames[index].fixCount++;
+    frames[index].refBit = 1;
+    frames[index].accessTime = pool->clock;
+    unlockSharedPool(pool);
+
+    page->pageNum = pageNum;
+    page->data = getShmData(pool, index);
+    return RC_OK;
+}
+
+// This function releases one pin of a page of the shared pool.
+RC unpinSharedPage(BM_SharedPool *pool, const PageNumber pageNum)
+{
+    RC status = RC_ERROR;
+
+    lockSharedPool(pool);
+    int index = findSharedPage(pool, pageNum);
+    if (index != -1)
+    {
+        ShmFrame *frame = &getShmFrames(pool)[index];
+        if (frame->fixCount > 0)
+            frame->fixCount--;
+        status = RC_OK;
+    }
+    unlockSharedPool(pool);
+
+    return status;
+}
+
+// This function marks a page of the shared pool as modified.
+RC markSharedPageDirty(BM_SharedPool *pool, const PageNumber pageNum)
+{
+    RC status = RC_ERROR;
+
+    lockSharedPool(pool);
+    int index = findSharedPage(pool, pageNum);
+    if (index != -1)
+    {
+        getShmFrames(pool)[index].dirtyBit = 1;
+        status = RC_OK;
+    }
+    unlockSharedPool(pool);
+
+    return status;
+}
+
+// This function writes a page of the shared pool back to the page file.
+RC forceSharedPage(BM_BufferPool *const bm, BM_SharedPool *pool, const PageNumber pageNum)
+{
+    RC status = RC_ERROR;
+
+    lockSharedPool(pool);
+    int index = findSharedPage(pool, pageNum);
+    if (index != -1)
+    {
+        status = writeSharedFrame(bm, pool, index);
+    }
+    unlockSharedPool(pool);
+
+    return status;
+}
+
+// This function writes back every dirty page of the shared pool that no process has pinned.
+RC flushSharedPool(BM_BufferPool *const bm, BM_SharedPool *pool)
+{
+    ShmFrame *frames = getShmFrames(pool);
+
+    lockSharedPool(pool);
+    for (int i = 0; i < pool->numPages; i++)
+    {
+        if (frames[i].pageNum != NO_PAGE && frames[i].dirtyBit == 1 && frames[i].fixCount == 0)
+        {
+            writeSharedFrame(bm, pool, i);
+        }
+    }
+    unlockSharedPool(pool);
+
+    return RC_OK;
+}
+
+// This function returns the number of pages written back from the shared pool so far.
+long getSharedPoolWrites(BM_SharedPool *pool)
+{
+    lockSharedPool(pool);
+    long writes = pool->writes;
+    unlockSharedPool(pool);
+    return writes;
+}
+
+// This function copies the page numbers, dirty flags and fix counts of all frames of the shared pool.
+void getSharedPoolContents(BM_SharedPool *pool, PageNumber *pageNums, bool *dirtyFlags, int *fixCounts)
+{
+    ShmFrame *frames = getShmFrames(pool);
+
+    lockSharedPool(pool);
+    for (int i = 0; i < pool->numPages; i++)
+    {
+        if (pageNums != NULL)
+            pageNums[i] = frames[i].pageNum;
+        if (dirtyFlags != NULL)
+            dirtyFlags[i] = frames[i].dirtyBit == 1;
+        if (fixCounts != NULL)
+            fixCounts[i] = frames[i].fixCount;
+    }
+    unlockSharedPool(pool);
+}
@@ -0,0 +1,31 @@
+#ifndef BUFFER_MGR_SHM_H
+#define BUFFER_MGR_SHM_H
+
+#include "buffer_mgr.h"
+#include "storage_mgr.h"
+
+// Shared memory segment of a buffer pool that several processes use together.
+// The segment holds a header with a process-shared latch, one frame descriptor per frame
+// (page table and replacement metadata) and the page data of all frames.
+typedef struct BM_SharedPool BM_SharedPool;
+
+// Attaching and detaching, the first process creates the segment and the last one removes it
+RC attachSharedPool(const char *const shmName, const char *const pageFile, const int numPages,
+		const int pageSize, ReplacementStrategy strategy, BM_SharedPool **pool);
+RC detachSharedPool(BM_BufferPool *const bm, BM_SharedPool *pool);
+
+// Page access, all under the latch of the segment
+RC pinSharedPage(BM_BufferPool *const bm, BM_SharedPool *pool, const PageNumber pageNum,
+		SM_PageHandle preloaded, long preloadedWrites, BM_PageHandle *const page);
+RC unpinSharedPage(BM_SharedPool *pool, const PageNumber pageNum);
+RC markSharedPageDirty(BM_SharedPool *pool, const PageNumber pageNum);
+RC forceSharedPage(BM_BufferPool *const bm, BM_SharedPool *pool, const PageNumber pageNum);
+RC flushSharedPool(BM_BufferPool *const bm, BM_SharedPool *pool);
+
+// Number of pages written back, a page read without the latch is current if it did not change since
+long getSharedPoolWrites(BM_SharedPool *pool);
+
+// Snapshot of the frames, any of the arrays may be NULL
+void getSharedPoolContents(BM_SharedPool *pool, PageNumber *pageNums, bool *dirtyFlags, int *fixCounts);
+
+#endif
@@ -6,6 +6,7 @@
 
 // local functions
 static void printStrat (BM_BufferPool *const bm);
+static void printLatency (char *name, long *histogram);
 
 // external functions
 void 
@@ -78,6 +79,46 @@ sprintPageContent (BM_PageHandle *const page)
 	return message;
 }
 
+void
+printPoolStats (BM_BufferPool *const bm)
+{
+	BM_Stats stats;
+
+	if (getPoolStats(bm, &stats) != RC_OK)
+		return;
+
+	printf("{");
+	printStrat(bm);
+	printf(" %i}: ", bm->numPages);
+	printf("pins=%li hits=%li misses=%li hitRatio=%.3f\n", stats.numPins, stats.hits, stats.misses,
+			(stats.numPins > 0) ? (double) stats.hits / stats.numPins : 0.0);
+	printf("evictions=%li dirtyEvictions=%li prefetched=%li prefetchHits=%li\n", stats.evictions,
+			stats.dirtyEvictions, stats.prefetchedPages, stats.prefetchHits);
+	printf("readIO=%li writeIO=%li pinWait=%lldus strategySwitches=%li\n", stats.numReadIO, stats.numWriteIO,
+			stats.pinWaitNanos / 1000, stats.strategySwitches);
+	printf("victimStores=%li victimHits=%li\n", stats.victimStores, stats.victimHits);
+	printLatency("read", stats.readLatency);
+	printLatency("write", stats.writeLatency);
+}
+
+void
+printLatency (char *name, long *histogram)
+{
+	int i;
+
+	printf("%s latency (us):", name);
+	for (i = 0; i < BM_LATENCY_BUCKETS; i++)
+	{
+		if (histogram[i] == 0)
+			continue;
+		if (i == BM_LATENCY_BUCKETS - 1)
+			printf(" >=%li:%li", 1L << (i - 1), histogram[i]);
+		else
+			printf(" <%li:%li", 1L << i, histogram[i]);
+	}
+	printf("\n");
+}
+
 void
 printStrat (BM_BufferPool *const bm)
 {
@@ -17,6 +17,9 @@ typedef int RC;
 #define RC_READ_NON_EXISTING_PAGE 4
 #define RC_WRITE_NON_EXISTING_PAGE 5
 #define RC_NOT_IMPLEMENTED 6
+#define RC_IO_IN_PROGRESS 7
+#define RC_SHM_FAILED 8
+#define RC_FILE_ALREADY_EXISTS 9
 #define RC_ERROR 400
 #define RC_READ_ERROR 401
 #define RC_PINNED_PAGES_IN_BUFFER 500
@@ -1,5 +1,6 @@
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
 
 #include "dberror.h"
 #include "record_mgr.h"
@@ -50,6 +51,7 @@ valueSmaller (Value *left, Value *right, Value *result)
 		break;
 	case DT_BOOL:
 		result->v.boolV = (left->v.boolV < right->v.boolV);
+		break;
 	case DT_STRING:
 		result->v.boolV = (strcmp(left->v.stringV, right->v.stringV) < 0);
 		break;
@@ -74,6 +76,7 @@ boolAnd (Value *left, Value *right, Value *result)
 {
 	if (left->dt != DT_BOOL || right->dt != DT_BOOL)
 		THROW(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN, "boolean AND requires boolean inputs");
+	result->dt = DT_BOOL;
 	result->v.boolV = (left->v.boolV && right->v.boolV);
 
 	return RC_OK;
@@ -84,6 +87,7 @@ boolOr (Value *left, Value *right, Value *result)
 {
 	if (left->dt != DT_BOOL || right->dt != DT_BOOL)
 		THROW(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN, "boolean OR requires boolean inputs");
+	result->dt = DT_BOOL;
 	result->v.boolV = (left->v.boolV || right->v.boolV);
 
 	return RC_OK;
@@ -188,3 +192,284 @@ freeVal (Value *val)
 	free(val);
 }
 
+
+// compiled expressions
+static int
+countExprNodes (Expr *expr)
+{
+	if (expr->type != EXPR_OP)
+		return 1;
+
+	Operator *op = expr->expr.op;
+	int count = 1 + countExprNodes(op->args[0]);
+	if (op->type != OP_BOOL_NOT)
+		count += countExprNodes(op->args[1]);
+	return count;
+}
+
+// appends the instructions of expr to the program, its value ends up at stack position depth
+static RC
+compileExprNode (Expr *expr, Schema *schema, int *offsets, CompiledExpr *compiled, int depth, int *maxDepth, DataType *type)
+{
+	ExprInstruction *instruction;
+
+	if (depth + 1 > *maxDepth)
+		*maxDepth = depth + 1;
+
+	switch(expr->type)
+	{
+	case EXPR_CONST:
+		instruction = &compiled->program[compiled->numInstructions++];
+		instruction->code = EXPR_PUSH_CONST;
+		instruction->offset = 0;
+		*type = expr->expr.cons->dt;
+		switch(*type) {
+		case DT_INT:
+			instruction->operand.v.intV = expr->expr.cons->v.intV;
+			break;
+		case DT_FLOAT:
+			instruction->operand.v.floatV = expr->expr.cons->v.floatV;
+			break;
+		case DT_BOOL:
+			instruction->operand.v.boolV = expr->expr.cons->v.boolV;
+			break;
+		case DT_STRING:
+			instruction->operand.v.stringV = expr->expr.cons->v.stringV;
+			break;
+		}
+		instruction->operand.length = INT_MAX;
+		break;
+	case EXPR_ATTRREF:
+	{
+		int attr = expr->expr.attrRef;
+		if (schema == NULL || attr < 0 || attr >= schema->numAttr)
+			THROW(RC_INVALID_ATTRIBUTE_NUM, "attribute reference is not an attribute of the schema");
+
+		instruction = &compiled->program[compiled->numInstructions++];
+		instruction->offset = offsets[attr];
+		instruction->operand.length = schema->typeLength[attr];
+		*type = schema->dataTypes[attr];
+		switch(*type) {
+		case DT_INT:
+			instruction->code = EXPR_LOAD_INT;
+			break;
+		case DT_FLOAT:
+			instruction->code = EXPR_LOAD_FLOAT;
+			break;
+		case DT_BOOL:
+			instruction->code = EXPR_LOAD_BOOL;
+			break;
+		case DT_STRING:
+			instruction->code = EXPR_LOAD_STRING;
+			break;
+		}
+	}
+	break;
+	case EXPR_OP:
+	{
+		Operator *op = expr->expr.op;
+		DataType leftType, rightType = DT_BOOL;
+		ExprOpcode code;
+
+		RC rc = compileExprNode(op->args[0], schema, offsets, compiled, depth, maxDepth, &leftType);
+		if (rc == RC_OK && op->type != OP_BOOL_NOT)
+			rc = compileExprNode(op->args[1], schema, offsets, compiled, depth + 1, maxDepth, &rightType);
+		if (rc != RC_OK)
+			return rc;
+
+		switch(op->type)
+		{
+		case OP_BOOL_NOT:
+		case OP_BOOL_AND:
+		case OP_BOOL_OR:
+			if (leftType != DT_BOOL || rightType != DT_BOOL)
+				THROW(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN, "boolean operators require boolean inputs");
+			code = op->type == OP_BOOL_NOT ? EXPR_NOT : (op->type == OP_BOOL_AND ? EXPR_AND : EXPR_OR);
+			break;
+		case OP_COMP_EQUAL:
+		case OP_COMP_SMALLER:
+			if (leftType != rightType)
+				THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "comparison only supported for values of the same datatype");
+			switch(leftType) {
+			case DT_INT:
+				code = op->type == OP_COMP_EQUAL ? EXPR_EQUAL_INT : EXPR_SMALLER_INT;
+				break;
+			case DT_FLOAT:
+				code = op->type == OP_COMP_EQUAL ? EXPR_EQUAL_FLOAT : EXPR_SMALLER_FLOAT;
+				break;
+			case DT_BOOL:
+				code = op->type == OP_COMP_EQUAL ? EXPR_EQUAL_BOOL : EXPR_SMALLER_BOOL;
+				break;
+			case DT_STRING:
+			default:
+				code = op->type == OP_COMP_EQUAL ? EXPR_EQUAL_STRING : EXPR_SMALLER_STRING;
+				break;
+			}
+			break;
+		default:
+			THROW(RC_RM_UNKOWN_DATATYPE, "unknown operator");
+		}
+
+		instruction = &compiled->program[compiled->numInstructions++];
+		instruction->code = code;
+		instruction->offset = 0;
+		*type = DT_BOOL;
+	}
+	break;
+	}
+
+	return RC_OK;
+}
+
+RC
+compileExpr (Expr *expr, Schema *schema, CompiledExpr **compiled)
+{
+	int *offsets = NULL;
+	int maxDepth = 0;
+	DataType type;
+	RC rc;
+
+	if (expr == NULL || compiled == NULL)
+		return RC_RM_NULL_ARGUMENT;
+
+	// the position of every attribute in the record data, after the tombstone byte
+	if (schema != NULL) {
+		offsets = (int *) malloc(sizeof(int) * (schema->numAttr + 1));
+		offsets[0] = 1;
+		for (int i = 0; i < schema->numAttr; i++) {
+			switch(schema->dataTypes[i]) {
+			case DT_STRING:
+				offsets[i + 1] = offsets[i] + schema->typeLength[i];
+				break;
+			case DT_FLOAT:
+				offsets[i + 1] = offsets[i] + sizeof(float);
+				break;
+			case DT_BOOL:
+				offsets[i + 1] = offsets[i] + sizeof(bool);
+				break;
+			case DT_INT:
+			default:
+				offsets[i + 1] = offsets[i] + sizeof(int);
+				break;
+			}
+		}
+	}
+
+	CompiledExpr *result = (CompiledExpr *) malloc(sizeof(CompiledExpr));
+	result->numInstructions = 0;
+	result->program = (ExprInstruction *) malloc(sizeof(ExprInstruction) * countExprNodes(expr));
+	result->stack = NULL;
+
+	rc = compileExprNode(expr, schema, offsets, result, 0, &maxDepth, &type);
+	free(offsets);
+	if (rc == RC_OK && type != DT_BOOL) {
+		RC_message = "condition does not evaluate to a boolean";
+		rc = RC_RM_EXPR_RESULT_IS_NOT_BOOLEAN;
+	}
+	if (rc != RC_OK) {
+		freeCompiledExpr(result);
+		return rc;
+	}
+
+	result->stack = (ExprSlot *) malloc(sizeof(ExprSlot) * maxDepth);
+	*compiled = result;
+	return RC_OK;
+}
+
+// compares like strcmp, a string ends at its zero byte or after its length
+static int
+compareSlotStrings (ExprSlot *left, ExprSlot *right)
+{
+	size_t leftLength = strnlen(left->v.stringV, left->length);
+	size_t rightLength = strnlen(right->v.stringV, right->length);
+	int result = memcmp(left->v.stringV, right->v.stringV, leftLength < rightLength ? leftLength : rightLength);
+	if (result != 0)
+		return result;
+	return (leftLength > rightLength) - (leftLength < rightLength);
+}
+
+bool
+evalCompiledExpr (CompiledExpr *compiled, char *recordData)
+{
+	ExprSlot *top = compiled->stack - 1;
+	ExprInstruction *instruction = compiled->program;
+	ExprInstruction *end = instruction + compiled->numInstructions;
+
+	for (; instruction < end; instruction++)
+	{
+		switch(instruction->code)
+		{
+		case EXPR_LOAD_INT:
+			memcpy(&(++top)->v.intV, recordData + instruction->offset, sizeof(int));
+			break;
+		case EXPR_LOAD_FLOAT:
+			memcpy(&(++top)->v.floatV, recordData + instruction->offset, sizeof(float));
+			break;
+		case EXPR_LOAD_BOOL:
+			memcpy(&(++top)->v.boolV, recordData + instruction->offset, sizeof(bool));
+			break;
+		case EXPR_LOAD_STRING:
+			(++top)->v.stringV = recordData + instruction->offset;
+			top->length = instruction->operand.length;
+			break;
+		case EXPR_PUSH_CONST:
+			*++top = instruction->operand;
+			break;
+		case EXPR_EQUAL_INT:
+			top--;
+			top->v.boolV = (top[0].v.intV == top[1].v.intV);
+			break;
+		case EXPR_EQUAL_FLOAT:
+			top--;
+			top->v.boolV = (top[0].v.floatV == top[1].v.floatV);
+			break;
+		case EXPR_EQUAL_BOOL:
+			top--;
+			top->v.boolV = (top[0].v.boolV == top[1].v.boolV);
+			break;
+		case EXPR_EQUAL_STRING:
+			top--;
+			top->v.boolV = (compareSlotStrings(&top[0], &top[1]) == 0);
+			break;
+		case EXPR_SMALLER_INT:
+			top--;
+			top->v.boolV = (top[0].v.intV < top[1].v.intV);
+			break;
+		case EXPR_SMALLER_FLOAT:
+			top--;
+			top->v.boolV = (top[0].v.floatV < top[1].v.floatV);
+			break;
+		case EXPR_SMALLER_BOOL:
+			top--;
+			top->v.boolV = (top[0].v.boolV < top[1].v.boolV);
+			break;
+		case EXPR_SMALLER_STRING:
+			top--;
+			top->v.boolV = (compareSlotStrings(&top[0], &top[1]) < 0);
+			break;
+		case EXPR_NOT:
+			top->v.boolV = !(top->v.boolV);
+			break;
+		case EXPR_AND:
+			top--;
+			top->v.boolV = (top[0].v.boolV && top[1].v.boolV);
+			break;
+		case EXPR_OR:
+			top--;
+			top->v.boolV = (top[0].v.boolV || top[1].v.boolV);
+			break;
+		}
+	}
+
+	return top->v.boolV;
+}
+
+void
+freeCompiledExpr (CompiledExpr *compiled)
+{
+	if (compiled == NULL)
+		return;
+	free(compiled->program);
+	free(compiled->stack);
+	free(compiled);
+}
@@ -44,6 +44,56 @@ extern RC evalExpr (Record *record, Schema *schema, Expr *expr, Value **result);
 extern RC freeExpr (Expr *expr);
 extern void freeVal(Value *val);
 
+// compiled expressions: a condition is flattened once into a program in postfix order whose instructions are
+// specialized for the types of their operands. The program reads attributes at fixed offsets of the record data
+// and evaluates a record without walking the tree and without allocating.
+typedef enum ExprOpcode {
+  EXPR_LOAD_INT,
+  EXPR_LOAD_FLOAT,
+  EXPR_LOAD_BOOL,
+  EXPR_LOAD_STRING,
+  EXPR_PUSH_CONST,
+  EXPR_EQUAL_INT,
+  EXPR_EQUAL_FLOAT,
+  EXPR_EQUAL_BOOL,
+  EXPR_EQUAL_STRING,
+  EXPR_SMALLER_INT,
+  EXPR_SMALLER_FLOAT,
+  EXPR_SMALLER_BOOL,
+  EXPR_SMALLER_STRING,
+  EXPR_NOT,
+  EXPR_AND,
+  EXPR_OR
+} ExprOpcode;
+
+// value on the stack of a program, a string ends at a zero byte or after length bytes
+typedef struct ExprSlot {
+  union {
+    int intV;
+    char *stringV;
+    float floatV;
+    bool boolV;
+  } v;
+  int length;
+} ExprSlot;
+
+typedef struct ExprInstruction {
+  ExprOpcode code;
+  int offset;          // position of a loaded attribute in the record data
+  ExprSlot operand;    // value of EXPR_PUSH_CONST, length of EXPR_LOAD_STRING
+} ExprInstruction;
+
+typedef struct CompiledExpr {
+  int numInstructions;
+  ExprInstruction *program;
+  ExprSlot *stack;     // room for the deepest point of the program
+} CompiledExpr;
+
+// the compiled expression refers to the string constants of expr, which has to outlive it
+extern RC compileExpr (Expr *expr, Schema *schema, CompiledExpr **compiled);
+extern bool evalCompiledExpr (CompiledExpr *compiled, char *recordData);
+extern void freeCompiledExpr (CompiledExpr *compiled);
+
 
 #define CPVAL(_result,_input)						\
   do {									\
@@ -0,0 +1,146 @@
+#include <string.h>
+#include "lz_codec.h"
+
+// Number of hash buckets used to find earlier occurrences of 3 byte sequences, must be a power of two.
+#define LZ_HASH_SIZE 4096
+
+// Largest distance a match may reach back.
+#define LZ_MAX_OFFSET 0xFFFF
+
+// This function hashes the 3 bytes at position p.
+static int hashSequence(const unsigned char *p)
+{
+    unsigned int value = p[0] | (p[1] << 8) | (p[2] << 16);
+    return (int)((value * 2654435761u) >> 20) & (LZ_HASH_SIZE - 1);
+}
+
+// This function writes the pending literals src[start, end) as literal commands, returns the new output position or -1.
+static int flushLiterals(const unsigned char *src, int start, int end, unsigned char *dst, int out, int dstCapacity)
+{
+    while (start < end)
+    {
+        int run = end - start;
+        if (run > LZ_MAX_LITERALS)
+        {
+            run = LZ_MAX_LITERALS;
+        }
+        if (out + 1 + run > dstCapacity)
+        {
+            return -1;
+        }
+
+        dst[out++] = (unsigned char)(run - 1);
+        memcpy(dst + out, src + start, run);
+        out += run;
+        start += run;
+    }
+    return out;
+}
+
+// This function compresses src greedily: at every position the last earlier occurrence of the next 3 bytes
+// is looked up in a hash table and extended as far as possible. A match costs 3 bytes, so only matches of
+// at least LZ_MIN_MATCH bytes are taken, which keeps the output within LZ_MAX_COMPRESSED_SIZE.
+int lzCompress(const char *source, int srcLen, char *destination, int dstCapacity)
+{
+    const unsigned char *src = (const unsigned char *)source;
+    unsigned char *dst = (unsigned char *)destination;
+    int table[LZ_HASH_SIZE];
+    int pos = 0;
+    int literalStart = 0;
+    int out = 0;
+
+    for (int i = 0; i < LZ_HASH_SIZE; i++)
+    {
+        table[i] = -1;
+    }
+
+    while (pos + 3 <= srcLen)
+    {
+        int hash = hashSequence(src + pos);
+        int candidate = table[hash];
+        table[hash] = pos;
+
+        // Measure the match with the previous occurrence, if it is close enough
+        int length = 0;
+        if (candidate >= 0 && pos - candidate <= LZ_MAX_OFFSET)
+        {
+            while (length < LZ_MAX_MATCH && pos + length < srcLen && src[candidate + length] == src[pos + length])
+            {
+                length++;
+            }
+        }
+
+        if (length < LZ_MIN_MATCH)
+        {
+            pos++;
+            continue;
+        }
+
+        // Emit the literals before the match, then the match itself
+        out = flushLiterals(src, literalStart, pos, dst, out, dstCapacity);
+        if (out == -1 || out + 3 > dstCapacity)
+        {
+            return -1;
+        }
+
+        int offset = pos - candidate;
+        dst[out++] = (unsigned char)(0x80 | (length - LZ_MIN_MATCH));
+        dst[out++] = (unsigned char)(offset & 0xFF);
+        dst[out++] = (unsigned char)(offset >> 8);
+
+        pos += length;
+        literalStart = pos;
+    }
+
+    // The tail that is too short for a match is stored as literals
+    return flushLiterals(src, literalStart, srcLen, dst, out, dstCapacity);
+}
+
+// This function restores the bytes of a stream produced by lzCompress.
+int lzDecompress(const char *source, int srcLen, char *destination, int dstCapacity)
+{
+    const unsigned char *src = (const unsigned char *)source;
+    unsigned char *dst = (unsigned char *)destination;
+    int in = 0;
+    int out = 0;
+
+    while (in < srcLen)
+    {
+        int control = src[in++];
+
+        if (control < 0x80)
+        {
+            // Literal run
+            int run = control + 1;
+            if (in + run > srcLen || out + run > dstCapacity)
+            {
+                return -1;
+            }
+            memcpy(dst + out, src + in, run);
+            in += run;
+            out += run;
+            continue;
+        }
+
+        // Match, copied byte by byte because it may overlap its own output
+        if (in + 2 > srcLen)
+        {
+            return -1;
+        }
+        int length = (control & 0x7F) + LZ_MIN_MATCH;
+        int offset = src[in] | (src[in + 1] << 8);
+        in += 2;
+
+        if (offset == 0 || offset > out || out + length > dstCapacity)
+        {
+            return -1;
+        }
+        for (int i = 0; i < length; i++)
+        {
+            dst[out + i] = dst[out - offset + i];
+        }
+        out += length;
+    }
+
+    return out;
+}
@@ -0,0 +1,25 @@
+#ifndef LZ_CODEC_H
+#define LZ_CODEC_H
+
+/************************************************************
+ *                    stream format                         *
+ ************************************************************/
+/* A compressed stream is a sequence of commands. A control byte c < 0x80 is
+ * followed by c + 1 literal bytes. A control byte c >= 0x80 copies
+ * (c & 0x7F) + LZ_MIN_MATCH bytes starting offset bytes back in the output,
+ * the offset (1 to 65535) follows as two bytes, low byte first. */
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_MATCH (0x7F + LZ_MIN_MATCH)
+#define LZ_MAX_LITERALS 0x80
+
+/* worst case size of the compressed stream of srcLen bytes */
+#define LZ_MAX_COMPRESSED_SIZE(srcLen) ((srcLen) + (srcLen) / LZ_MAX_LITERALS + 1)
+
+/************************************************************
+ *                    interface                             *
+ ************************************************************/
+/* both return the number of bytes written to dst, or -1 if dst is too small or src is corrupt */
+extern int lzCompress (const char *src, int srcLen, char *dst, int dstCapacity);
+extern int lzDecompress (const char *src, int srcLen, char *dst, int dstCapacity);
+
+#endif
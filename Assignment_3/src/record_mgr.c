@@ -7,6 +7,16 @@
 
 
 
+// ProjectedColumn is an attribute a projecting scan returns: its number in the table, where it is in a full record,
+// where it goes in the compact record and how many bytes it has.
+typedef struct ProjectedColumn
+{
+    int attr;
+    int source;
+    int target;
+    int size;
+} ProjectedColumn;
+
 // RecordManager is a custom data structure used for managing records.
 typedef struct RecordManager
 {
@@ -21,6 +31,10 @@ typedef struct RecordManager
     
     // condition is an expression that dictates the criteria for record scanning.
     Expr *condition;
+
+    // compiledCondition is the condition of a scan compiled in startScan(), NULL if it could not be compiled and is
+    // evaluated with evalExpr().
+    CompiledExpr *compiledCondition;
     
     // tuplesCount holds the total number of tuples in the table.
     int tuplesCount;
@@ -31,6 +45,34 @@ typedef struct RecordManager
     // scanCount keeps track of the number of records scanned so far.
     int scanCount;
 
+    // fileHandle is the page file opened by a scan to skip pages marked free in the file's free map.
+    SM_FileHandle fileHandle;
+
+    // readaheadPage is the page at which a scan next announces the pages ahead of it to the kernel.
+    int readaheadPage;
+
+    // pagePinned tells whether a scan keeps the page of recordID pinned in pageHandle between calls of next().
+    bool pagePinned;
+
+    // emptyPageBytes is the free-space map entry of an empty page, a scan computes it once in startScan().
+    int emptyPageBytes;
+
+    // projectedSchema is the schema of the records a projecting scan returns, NULL for a scan returning whole records.
+    // columns holds one entry per attribute of it, their values are decoded straight into the compact record. wanted
+    // marks the attributes of the table the condition reads. When it reads one the scan does not return, scratchCondition
+    // is set and the condition is evaluated on scratch, a full-size record holding only those attributes.
+    Schema *projectedSchema;
+    ProjectedColumn *columns;
+    bool *wanted;
+    bool scratchCondition;
+    char *scratch;
+
+    // freeSpace is the free-space map of the table: the free bytes of every page, FREE_SPACE_UNKNOWN where they are
+    // not known yet. numPages is the number of pages it covers, freeSpaceSlots the number of entries allocated.
+    int *freeSpace;
+    int numPages;
+    int freeSpaceSlots;
+
 } RecordManager;
 
 
@@ -41,22 +83,668 @@ typedef struct RecordManager
 // ATTRIBUTE_SIZE specifies the maximum character length of an attribute's name.
 #define ATTRIBUTE_SIZE 15 
 
-RecordManager *recordManager;
+// BULK_LOAD_PAGES is the number of pages the bulk loader formats before it writes them with one request.
+#define BULK_LOAD_PAGES 64
+
+// SCAN_READAHEAD_PAGES is the number of pages a scan asks the kernel to read ahead of its position.
+#define SCAN_READAHEAD_PAGES 16
+
+// FREE_SPACE_SUFFIX is appended to the table name to get the name of the page file holding its free-space map.
+#define FREE_SPACE_SUFFIX ".fsm"
+
+// FREE_SPACE_MAP_OPEN is stored as the number of entries of the map file while the table is open. closeTable() writes
+// the real number back, a map still marked open after a crash may be stale and its entries are not used.
+#define FREE_SPACE_MAP_OPEN -1
+
+// FREE_SPACE_UNKNOWN marks a page of the free-space map whose free bytes are counted the next time it is pinned.
+#define FREE_SPACE_UNKNOWN -1
+
+// FREE_SPACE_FREED marks a page of the free-space map that was given back to the storage manager. Inserts and scans
+// pass it by, an insert that finds no room gets it back through allocatePage().
+#define FREE_SPACE_FREED -2
+
+// Header of a data page. Pages are slotted: the slot-occupancy bitmap follows the header, then the slot directory
+// growing towards the end of the page, while the records are stored from the end of the page towards the directory.
+// A page of zeros has no slots yet and is laid out when the first record is inserted.
+typedef struct PageHeader
+{
+    // liveCount is the number of used slots of the page.
+    int liveCount;
+
+    // numSlots is the number of entries of the slot directory, slots past it are free.
+    int numSlots;
+
+    // slotCapacity is the number of slots the bitmap has room for, 0 for a page that was never used.
+    int slotCapacity;
+
+    // dataStart is the offset of the lowest stored record, the page size while the page holds none.
+    int dataStart;
+
+    // usedBytes is the number of bytes of all stored records.
+    int usedBytes;
+} PageHeader;
+
+// SlotWord is a word of the slot-occupancy bitmap, bit n of word w is set while slot 64 * w + n is used.
+typedef unsigned long long SlotWord;
+#define SLOT_WORD_BITS 64
+
+// Entry of the slot directory: where the stored record of the slot is
+typedef struct SlotEntry
+{
+    unsigned short offset;
+    unsigned short length;
+} SlotEntry;
+
+// A stored record starts with a marker. Relocated records also keep the RID of their home slot, which holds a
+// forward stub with the RID of the relocated record. Strings are stored with their length instead of typeLength bytes.
+#define RECORD_MARKER '+'
+#define RELOCATED_MARKER '*'
+#define FORWARD_MARKER '>'
+
+// RECORD_HEADER_SIZE is the size of a forward stub, stored records are padded to at least this size so that the
+// home slot of a record can always hold the stub when the record has to move.
+#define RECORD_HEADER_SIZE ((int) (1 + 2 * sizeof(int)))
+
+RC attrOffset (Schema *schema, int attrNum, int *result);
+
+
+
+// This function returns the number of bitmap words of a page with room for numSlots slots
+int getSlotWords(int numSlots)
+{
+    return (numSlots + SLOT_WORD_BITS - 1) / SLOT_WORD_BITS;
+}
+
+// This function returns the offset of the slot-occupancy bitmap, the header rounded up to whole words
+int getBitmapOffset(void)
+{
+    return (int) ((sizeof(PageHeader) + sizeof(SlotWord) - 1) / sizeof(SlotWord) * sizeof(SlotWord));
+}
+
+// This function returns the number of bytes a string attribute uses to store its length
+int getLengthBytes(int typeLength)
+{
+    return typeLength < 256 ? 1 : 2;
+}
+
+// This function returns the size of an attribute of a type other than DT_STRING
+int getFixedSize(DataType type)
+{
+    switch (type) {
+        case DT_INT:
+            return sizeof(int);
+        case DT_FLOAT:
+            return sizeof(float);
+        case DT_BOOL:
+            return sizeof(bool);
+        default:
+            return 0;
+    }
+}
+
+// This function returns the size of the shortest stored record of a schema: all strings empty
+int getMinStoredSize(Schema *schema)
+{
+    int size = 1;
+    for (int i = 0; i < schema->numAttr; i++) {
+        if (schema->dataTypes[i] == DT_STRING)
+            size += getLengthBytes(schema->typeLength[i]);
+        else
+            size += getFixedSize(schema->dataTypes[i]);
+    }
+    return size < RECORD_HEADER_SIZE ? RECORD_HEADER_SIZE : size;
+}
+
+// This function returns the size of the longest stored record of a schema: a relocated record with all strings full
+int getMaxStoredSize(Schema *schema)
+{
+    int size = getRecordSize(schema) + 2 * sizeof(int);
+    for (int i = 0; i < schema->numAttr; i++)
+        if (schema->dataTypes[i] == DT_STRING)
+            size += getLengthBytes(schema->typeLength[i]);
+    return size < RECORD_HEADER_SIZE ? RECORD_HEADER_SIZE : size;
+}
+
+// This function returns the number of slots a data page has room for: as many records of the shortest size as fit
+// next to the header, the bitmap and their directory entries
+int getSlotCapacity(Schema *schema, int pageSize)
+{
+    int perSlot = getMinStoredSize(schema) + (int) sizeof(SlotEntry);
+    int numSlots = (pageSize - getBitmapOffset()) / perSlot;
+    while (numSlots > 0 && getBitmapOffset() + getSlotWords(numSlots) * (int) sizeof(SlotWord) + numSlots * perSlot > pageSize)
+        numSlots--;
+    return numSlots;
+}
+
+// This function returns the slot-occupancy bitmap of a data page
+SlotWord *getSlotBitmap(char *data)
+{
+    return (SlotWord *) (data + getBitmapOffset());
+}
+
+// This function returns the slot directory of a data page
+SlotEntry *getSlotDirectory(char *data)
+{
+    return (SlotEntry *) (data + getBitmapOffset() + getSlotWords(((PageHeader *) data)->slotCapacity) * sizeof(SlotWord));
+}
+
+// This function returns a pointer to the stored record of a slot
+char *getSlotPointer(char *data, int slot)
+{
+    return data + getSlotDirectory(data)[slot].offset;
+}
+
+// This function lays out a page that was never used, or whose last record was removed: no slots and no records
+void initializeRecordPage(char *data, int slotCapacity, int pageSize)
+{
+    PageHeader *header = (PageHeader *) data;
+    if (header->slotCapacity == 0 || header->liveCount == 0) {
+        if (header->slotCapacity == 0)
+            header->slotCapacity = slotCapacity;
+        header->liveCount = 0;
+        header->numSlots = 0;
+        header->dataStart = pageSize;
+        header->usedBytes = 0;
+        memset(getSlotBitmap(data), 0, getSlotWords(header->slotCapacity) * sizeof(SlotWord));
+    }
+}
+
+// This function tells whether a slot of a data page is used
+bool isSlotUsed(char *data, int slot)
+{
+    PageHeader *header = (PageHeader *) data;
+    if (slot < 0 || slot >= header->numSlots)
+        return FALSE;
+    return (getSlotBitmap(data)[slot / SLOT_WORD_BITS] >> (slot % SLOT_WORD_BITS)) & 1;
+}
 
+// This function marks a slot of a data page used or free and keeps the number of used slots of the page
+void setSlotUsed(char *data, int slot, bool used)
+{
+    PageHeader *header = (PageHeader *) data;
+    SlotWord bit = (SlotWord) 1 << (slot % SLOT_WORD_BITS);
+    SlotWord *word = &getSlotBitmap(data)[slot / SLOT_WORD_BITS];
 
+    if (used && !(*word & bit)) {
+        *word |= bit;
+        header->liveCount++;
+    }
+    else if (!used && (*word & bit)) {
+        *word &= ~bit;
+        header->liveCount--;
+    }
+}
 
-// This function returns a free slot within a page
-int findFreeSlot(char *data, int recordSize)
+// This function returns a free entry of the slot directory, found a bitmap word at a time, -1 if every entry is used
+int findFreeSlot(char *data)
 {
-    char *end = data + PAGE_SIZE;
-    int slotIndex = 0;
+    PageHeader *header = (PageHeader *) data;
+    SlotWord *bitmap = getSlotBitmap(data);
+
+    if (header->liveCount >= header->numSlots)
+        return -1;
 
-    for (char *current = data; current < end; current += recordSize, ++slotIndex)
-        if (*current != '+')
-            return slotIndex;
+    for (int w = 0; w < getSlotWords(header->numSlots); w++) {
+        if (~bitmap[w] != 0) {
+            int slot = w * SLOT_WORD_BITS + __builtin_ctzll(~bitmap[w]);
+            return slot < header->numSlots ? slot : -1;
+        }
+    }
     return -1;
 }
 
+// This function returns the first slot at or after slot that is used, -1 if there is none
+int findUsedSlot(char *data, int slot)
+{
+    PageHeader *header = (PageHeader *) data;
+    SlotWord *bitmap = getSlotBitmap(data);
+
+    if (header->liveCount == 0 || slot >= header->numSlots)
+        return -1;
+
+    // Bits below slot in its word are masked off, then whole words are skipped
+    int w = slot / SLOT_WORD_BITS;
+    SlotWord word = bitmap[w] & (~(SlotWord) 0 << (slot % SLOT_WORD_BITS));
+    while (word == 0) {
+        if (++w >= getSlotWords(header->numSlots))
+            return -1;
+        word = bitmap[w];
+    }
+    return w * SLOT_WORD_BITS + __builtin_ctzll(word);
+}
+
+// This function returns the bytes between the slot directory and the records
+int getContiguousBytes(char *data)
+{
+    PageHeader *header = (PageHeader *) data;
+    return header->dataStart - (int) ((char *) &getSlotDirectory(data)[header->numSlots] - data);
+}
+
+// This function returns the size of the longest record that can be stored on a page, after compacting it if needed.
+// A page that was never used has the room of an empty page.
+int getPageFreeBytes(char *data, int slotCapacity, int pageSize)
+{
+    PageHeader *header = (PageHeader *) data;
+    if (header->slotCapacity == 0 || header->liveCount == 0) {
+        int capacity = header->slotCapacity == 0 ? slotCapacity : header->slotCapacity;
+        return pageSize - getBitmapOffset() - getSlotWords(capacity) * (int) sizeof(SlotWord) - (int) sizeof(SlotEntry);
+    }
+
+    int freeBytes = pageSize - (int) ((char *) &getSlotDirectory(data)[header->numSlots] - data) - header->usedBytes;
+
+    // Without a free entry the record needs a new one
+    if (header->liveCount == header->numSlots) {
+        if (header->numSlots >= header->slotCapacity)
+            return 0;
+        freeBytes -= sizeof(SlotEntry);
+    }
+    return freeBytes > 0 ? freeBytes : 0;
+}
+
+// This function moves the records of a page together at its end, so that all free bytes lie between the slot
+// directory and the records
+void compactRecordPage(char *data, int pageSize)
+{
+    PageHeader *header = (PageHeader *) data;
+    SlotEntry *directory = getSlotDirectory(data);
+    char *copy = (char *) malloc(pageSize);
+    int end = pageSize;
+
+    memcpy(copy, data, pageSize);
+    for (int slot = 0; slot < header->numSlots; slot++) {
+        if (!isSlotUsed(data, slot))
+            continue;
+        end -= directory[slot].length;
+        memcpy(data + end, copy + directory[slot].offset, directory[slot].length);
+        directory[slot].offset = end;
+    }
+    header->dataStart = end;
+    free(copy);
+}
+
+// This function stores a record in the space of a slot, which must not be counted in usedBytes, compacting the page
+// if the free bytes are scattered
+void storeInSlot(char *data, int slot, char *stored, int length, int pageSize)
+{
+    PageHeader *header = (PageHeader *) data;
+    SlotEntry *directory = getSlotDirectory(data);
+
+    if (getContiguousBytes(data) < length)
+        compactRecordPage(data, pageSize);
+
+    header->dataStart -= length;
+    memcpy(data + header->dataStart, stored, length);
+    directory[slot].offset = header->dataStart;
+    directory[slot].length = length;
+    header->usedBytes += length;
+}
+
+// This function stores a record on a page, returns its slot or -1 if the page has no room for it
+int placeOnPage(char *data, char *stored, int length, int pageSize)
+{
+    PageHeader *header = (PageHeader *) data;
+    if (getPageFreeBytes(data, header->slotCapacity, pageSize) < length)
+        return -1;
+
+    // Reuse a free entry of the directory, or add one
+    int slot = findFreeSlot(data);
+    if (slot == -1) {
+        slot = header->numSlots++;
+    }
+
+    // The used bit is set first so that compaction keeps the entry in the directory
+    getSlotDirectory(data)[slot].length = 0;
+    setSlotUsed(data, slot, TRUE);
+    storeInSlot(data, slot, stored, length, pageSize);
+    return slot;
+}
+
+// This function removes the record of a slot. Free entries at the end of the directory are dropped, and a page
+// without records is laid out anew.
+void removeFromPage(char *data, int slot, int pageSize)
+{
+    PageHeader *header = (PageHeader *) data;
+    SlotEntry *directory = getSlotDirectory(data);
+
+    header->usedBytes -= directory[slot].length;
+    directory[slot].length = 0;
+    setSlotUsed(data, slot, FALSE);
+
+    while (header->numSlots > 0 && !isSlotUsed(data, header->numSlots - 1))
+        header->numSlots--;
+    if (header->liveCount == 0)
+        initializeRecordPage(data, header->slotCapacity, pageSize);
+}
+
+// This function replaces the record of a slot with one of another length, returns FALSE if the page has no room
+bool replaceOnPage(char *data, int slot, char *stored, int length, int pageSize)
+{
+    PageHeader *header = (PageHeader *) data;
+    SlotEntry *directory = getSlotDirectory(data);
+
+    // A record that is not longer stays where it is
+    if (length <= directory[slot].length) {
+        memcpy(data + directory[slot].offset, stored, length);
+        header->usedBytes -= directory[slot].length - length;
+        directory[slot].length = length;
+        return TRUE;
+    }
+
+    // A longer one needs the free bytes of the page together with its old space
+    int freeBytes = pageSize - (int) ((char *) &directory[header->numSlots] - data) - header->usedBytes;
+    if (freeBytes + directory[slot].length < length)
+        return FALSE;
+
+    header->usedBytes -= directory[slot].length;
+    directory[slot].length = 0;
+    storeInSlot(data, slot, stored, length, pageSize);
+    return TRUE;
+}
+
+// This function writes the attributes of a record in the stored format after the marker (and the home RID of a
+// relocated record), returns the length of the stored record
+int encodeRecord(Schema *schema, char *recordData, char marker, RID home, char *stored)
+{
+    int length = 0;
+    stored[length++] = marker;
+    if (marker == RELOCATED_MARKER) {
+        memcpy(stored + length, &home.page, sizeof(int));
+        memcpy(stored + length + sizeof(int), &home.slot, sizeof(int));
+        length += 2 * sizeof(int);
+    }
+
+    for (int i = 0; i < schema->numAttr; i++) {
+        int offset;
+        attrOffset(schema, i, &offset);
+        char *field = recordData + offset;
+
+        if (schema->dataTypes[i] == DT_STRING) {
+            // The characters up to the first zero byte, then the length before them
+            int size = (int) strnlen(field, schema->typeLength[i]);
+            stored[length] = (char) (size & 0xFF);
+            if (getLengthBytes(schema->typeLength[i]) == 2)
+                stored[length + 1] = (char) (size >> 8);
+            length += getLengthBytes(schema->typeLength[i]);
+            memcpy(stored + length, field, size);
+            length += size;
+        }
+        else {
+            int size = getFixedSize(schema->dataTypes[i]);
+            memcpy(stored + length, field, size);
+            length += size;
+        }
+    }
+
+    // Pad short records so that a forward stub always fits into their space
+    while (length < RECORD_HEADER_SIZE)
+        stored[length++] = 0;
+    return length;
+}
+
+// This function restores the attributes of a record from its stored format, strings are padded with zeros to typeLength.
+// Only the attributes set in wanted are copied, NULL copies all of them.
+void decodeRecord(Schema *schema, char *stored, char *recordData, bool *wanted)
+{
+    int position = (stored[0] == RELOCATED_MARKER) ? RECORD_HEADER_SIZE : 1;
+    int offset = 1;
+
+    for (int i = 0; i < schema->numAttr; i++) {
+        char *field = recordData + offset;
+        bool copy = wanted == NULL || wanted[i];
+
+        if (schema->dataTypes[i] == DT_STRING) {
+            int size = (unsigned char) stored[position];
+            if (getLengthBytes(schema->typeLength[i]) == 2)
+                size |= (unsigned char) stored[position + 1] << 8;
+            position += getLengthBytes(schema->typeLength[i]);
+            if (copy) {
+                memcpy(field, stored + position, size);
+                memset(field + size, 0, schema->typeLength[i] - size);
+            }
+            position += size;
+            offset += schema->typeLength[i];
+        }
+        else {
+            int size = getFixedSize(schema->dataTypes[i]);
+            if (copy)
+                memcpy(field, stored + position, size);
+            position += size;
+            offset += size;
+        }
+    }
+}
+
+// This function restores the attributes a projecting scan returns from the stored format of a record straight into
+// the compact record, strings are padded with zeros to typeLength. An attribute may be returned more than once.
+void decodeProjectedRecord(Schema *schema, char *stored, ProjectedColumn *columns, int numColumns, char *recordData)
+{
+    int position = (stored[0] == RELOCATED_MARKER) ? RECORD_HEADER_SIZE : 1;
+
+    for (int i = 0; i < schema->numAttr; i++) {
+        int size;
+        if (schema->dataTypes[i] == DT_STRING) {
+            size = (unsigned char) stored[position];
+            if (getLengthBytes(schema->typeLength[i]) == 2)
+                size |= (unsigned char) stored[position + 1] << 8;
+            position += getLengthBytes(schema->typeLength[i]);
+        }
+        else {
+            size = getFixedSize(schema->dataTypes[i]);
+        }
+
+        for (int c = 0; c < numColumns; c++) {
+            if (columns[c].attr == i) {
+                memcpy(recordData + columns[c].target, stored + position, size);
+                memset(recordData + columns[c].target + size, 0, columns[c].size - size);
+            }
+        }
+        position += size;
+    }
+}
+
+// This function returns the RID stored after the marker of a forward stub or a relocated record
+RID getStoredRID(char *stored)
+{
+    RID id;
+    memcpy(&id.page, stored + 1, sizeof(int));
+    memcpy(&id.slot, stored + 1 + sizeof(int), sizeof(int));
+    return id;
+}
+
+// This function writes a forward stub pointing at target, returns its length
+int encodeForwardStub(RID target, char *stored)
+{
+    stored[0] = FORWARD_MARKER;
+    memcpy(stored + 1, &target.page, sizeof(int));
+    memcpy(stored + 1 + sizeof(int), &target.slot, sizeof(int));
+    return RECORD_HEADER_SIZE;
+}
+
+// This function returns the name of the page file holding the free-space map of a table.
+char *getFreeSpaceFileName(const char *tableName)
+{
+    char *fileName = (char *) malloc(strlen(tableName) + strlen(FREE_SPACE_SUFFIX) + 1);
+    strcpy(fileName, tableName);
+    strcat(fileName, FREE_SPACE_SUFFIX);
+    return fileName;
+}
+
+// This function makes the free-space map cover numPages pages, new pages are of unknown free space
+void growFreeSpaceMap(RecordManager *manager, int numPages)
+{
+    if (numPages <= manager->numPages) {
+        return;
+    }
+
+    if (numPages > manager->freeSpaceSlots) {
+        int slots = manager->freeSpaceSlots > 0 ? manager->freeSpaceSlots : 64;
+        while (slots < numPages)
+            slots *= 2;
+        manager->freeSpace = (int *) realloc(manager->freeSpace, slots * sizeof(int));
+        manager->freeSpaceSlots = slots;
+    }
+
+    for (int i = manager->numPages; i < numPages; i++)
+        manager->freeSpace[i] = FREE_SPACE_UNKNOWN;
+    manager->numPages = numPages;
+}
+
+// This function loads the free-space map of a table. Pages of the table the map does not cover (a table written
+// without a map, or pages added after the map was saved) start out unknown. The header page never has room. Whether
+// a page is freed is taken from the free map of the page file, not from the saved entry. The map file is marked open
+// until closeTable() saves the map again.
+void loadFreeSpaceMap(RecordManager *manager)
+{
+    char *tableName = manager->bufferPool.pageFile;
+    SM_FileHandle fileHandle;
+    SM_FileHandle tableHandle;
+
+    manager->numPages = 0;
+    bool opened = openPageFile(tableName, &tableHandle) == RC_OK;
+    if (opened) {
+        growFreeSpaceMap(manager, tableHandle.totalNumPages);
+    }
+    growFreeSpaceMap(manager, 1);
+
+    // The map file holds the number of entries followed by the entries, spread over its pages
+    char *fileName = getFreeSpaceFileName(tableName);
+    if (openPageFile(fileName, &fileHandle) == RC_OK) {
+        char *data = (char *) malloc((size_t) fileHandle.totalNumPages * fileHandle.pageSize);
+        if (fileHandle.totalNumPages > 0 && readBlocks(0, fileHandle.totalNumPages, &fileHandle, data) == RC_OK) {
+            int count = *(int *) data;
+            int capacity = (int) ((size_t) fileHandle.totalNumPages * fileHandle.pageSize / sizeof(int)) - 1;
+            if (count > capacity)
+                count = capacity;
+            growFreeSpaceMap(manager, count);
+            memcpy(manager->freeSpace, data + sizeof(int), (count > 0 ? count : 0) * sizeof(int));
+
+            *(int *) data = FREE_SPACE_MAP_OPEN;
+            writeBlock(0, &fileHandle, data);
+        }
+        free(data);
+        closePageFile(&fileHandle);
+    }
+    free(fileName);
+
+    if (opened) {
+        for (int i = 1; i < manager->numPages; i++) {
+            if (isPageFree(i, &tableHandle))
+                manager->freeSpace[i] = FREE_SPACE_FREED;
+            else if (manager->freeSpace[i] == FREE_SPACE_FREED)
+                manager->freeSpace[i] = FREE_SPACE_UNKNOWN;
+        }
+        closePageFile(&tableHandle);
+    }
+    manager->freeSpace[0] = 0;
+
+    // The insert hint is the first page with room, or not known to be full
+    manager->freePage = 1;
+    while (manager->freePage < manager->numPages && manager->freeSpace[manager->freePage] == 0)
+        manager->freePage++;
+}
+
+// This function writes the free-space map of a table to its page file, creating the file for tables written without one
+RC saveFreeSpaceMap(RecordManager *manager)
+{
+    char *fileName = getFreeSpaceFileName(manager->bufferPool.pageFile);
+    int pageSize = manager->bufferPool.pageSize;
+    SM_FileHandle fileHandle;
+    RC result;
+
+    if (openPageFile(fileName, &fileHandle) != RC_OK &&
+        ((result = createPageFileWithSize(fileName, pageSize)) != RC_OK || (result = openPageFile(fileName, &fileHandle)) != RC_OK)) {
+        free(fileName);
+        return result;
+    }
+    free(fileName);
+
+    // Serialize the number of entries and the entries into whole pages
+    int numPages = (int) (((size_t) manager->numPages + 1) * sizeof(int) + pageSize - 1) / pageSize;
+    char *data = (char *) calloc((size_t) numPages, pageSize);
+    *(int *) data = manager->numPages;
+    memcpy(data + sizeof(int), manager->freeSpace, manager->numPages * sizeof(int));
+
+    result = ensureCapacity(numPages, &fileHandle);
+    for (int i = 0; i < numPages && result == RC_OK; i++)
+        result = writeBlock(i, &fileHandle, data + (size_t) i * pageSize);
+
+    free(data);
+    closePageFile(&fileHandle);
+    return result;
+}
+
+// This function returns the first page at or after the insert hint that has room for size bytes or whose free space
+// is not known, the page after the last one if there is none. Pages before the hint have no room for even the
+// shortest record, so the search starts right at a page with room unless records were only added since the last delete.
+int findPageWithRoom(RecordManager *manager, int size)
+{
+    int page = manager->freePage;
+    while (page < manager->numPages && manager->freeSpace[page] != FREE_SPACE_UNKNOWN && manager->freeSpace[page] < size)
+        page++;
+    return page;
+}
+
+// This function records the free bytes of a pinned data page in the free-space map and moves the insert hint past
+// the pages that have no room for the shortest record of the table
+void noteFreeSpace(RecordManager *manager, Schema *schema, int page, char *data)
+{
+    int pageSize = manager->bufferPool.pageSize;
+    int minSize = getMinStoredSize(schema);
+
+    growFreeSpaceMap(manager, page + 1);
+    manager->freeSpace[page] = getPageFreeBytes(data, getSlotCapacity(schema, pageSize), pageSize);
+
+    if (page < manager->freePage && manager->freeSpace[page] >= minSize)
+        manager->freePage = page;
+    while (manager->freePage < manager->numPages && manager->freeSpace[manager->freePage] != FREE_SPACE_UNKNOWN &&
+           manager->freeSpace[manager->freePage] < minSize)
+        manager->freePage++;
+}
+
+// This function takes a new data page for the table from the storage manager, a page freed before or one appended to
+// the page file. Its free space is counted when it is pinned.
+RC allocateTablePage(RecordManager *manager, int *page)
+{
+    SM_FileHandle fileHandle;
+    RC result = openPageFile(manager->bufferPool.pageFile, &fileHandle);
+    if (result != RC_OK) {
+        return result;
+    }
+    result = allocatePage(&fileHandle, page);
+    closePageFile(&fileHandle);
+    if (result != RC_OK) {
+        return result;
+    }
+
+    growFreeSpaceMap(manager, *page + 1);
+    manager->freeSpace[*page] = FREE_SPACE_UNKNOWN;
+    return RC_OK;
+}
+
+// This function gives a data page whose last record was removed back to the storage manager. The page is written
+// back first, so the empty page a frame of the pool may still hold is what the file holds, and allocatePage() hands
+// it out zeroed, which reads the same. Pages cut off the end of the file leave the free-space map. A page that cannot
+// be freed simply stays an empty page of the table.
+void releaseEmptyPage(RecordManager *manager, BM_PageHandle *pageHandle)
+{
+    SM_FileHandle fileHandle;
+    int page = pageHandle->pageNum;
+    if (page <= 0 || forcePage(&manager->bufferPool, pageHandle) != RC_OK ||
+        openPageFile(manager->bufferPool.pageFile, &fileHandle) != RC_OK) {
+        return;
+    }
+
+    int numPages = fileHandle.totalNumPages;
+    if (freePage(page, &fileHandle) == RC_OK) {
+        manager->freeSpace[page] = FREE_SPACE_FREED;
+        if (fileHandle.totalNumPages < numPages && fileHandle.totalNumPages < manager->numPages)
+            manager->numPages = fileHandle.totalNumPages;
+        if (manager->freePage > manager->numPages)
+            manager->freePage = manager->numPages;
+    }
+    closePageFile(&fileHandle);
+}
+
 // This function initializes the Record Manager
 extern RC initRecordManager (void *mgmtData)
 {
@@ -68,8 +756,7 @@ extern RC initRecordManager (void *mgmtData)
 // This functions shuts down the Record Manager
 extern RC shutdownRecordManager ()
 {
-	recordManager = NULL;
-	free(recordManager);
+	// Every open table keeps its own manager and buffer pool, closeTable releases them
 	return RC_OK;
 }
 
@@ -89,6 +776,16 @@ void writeSchemaAttributes(char** pageHandle, Schema* schema) {
 }
 
 extern RC createTable (char *name, Schema *schema)
+{
+    return createTableWithPageSize(name, schema, PAGE_SIZE);
+}
+
+extern RC createTableWithPageSize (char *name, Schema *schema, int pageSize)
+{
+    return createTableWithFlags(name, schema, pageSize, 0);
+}
+
+extern RC createTableWithFlags (char *name, Schema *schema, int pageSize, int flags)
 {
 
     // Validate input parameters
@@ -96,16 +793,13 @@ extern RC createTable (char *name, Schema *schema)
         printf("Invalid parameters.\n");
         return RC_RM_NULL_ARGUMENT;  
     }
+    if (!isValidPageSize(pageSize)) {
+        return RC_INVALID_PARAMETER;
+    }
 
-    char data[PAGE_SIZE];
+    char *data = (char*) calloc(pageSize, sizeof(char));
     char *pageHandle = data;
 
-    // Allocate memory for the record manager and initialize the buffer pool
-    recordManager = (RecordManager*) malloc(sizeof(RecordManager));
-    initBufferPool(&recordManager->bufferPool, name, MAX_NUMBER_OF_PAGES, RS_LRU, NULL);
-
-    
- 
     // Write initial configurations to the page
     *(int*)pageHandle = 0;  // number of tuples
     pageHandle += sizeof(int);
@@ -121,15 +815,22 @@ extern RC createTable (char *name, Schema *schema)
 
     SM_FileHandle fileHandle;
     RC result;
+    char *freeSpaceFile = getFreeSpaceFileName(name);
 
-    // Perform page file operations and check for errors
-    if ((result = createPageFile(name)) != RC_OK ||
+    // Perform page file operations and check for errors, the free-space map lives next to the table in the same backend
+    if ((result = createPageFileWithFlags(name, pageSize, flags)) != RC_OK ||
         (result = openPageFile(name, &fileHandle)) != RC_OK ||
         (result = writeBlock(0, &fileHandle, data)) != RC_OK ||
-        (result = closePageFile(&fileHandle)) != RC_OK) {
+        (result = closePageFile(&fileHandle)) != RC_OK ||
+        (result = createPageFileWithFlags(freeSpaceFile, pageSize, flags & SM_IN_MEMORY)) != RC_OK) {
+        free(freeSpaceFile);
+        free(data);
         return result;
     }
+    free(freeSpaceFile);
+    free(data);
 
+    // The table gets its manager and buffer pool when it is opened
     return RC_OK;
 }
 
@@ -157,7 +858,18 @@ void readSchemaAttributes(char** pageHandle, Schema* schema) {
 
 extern RC openTable (RM_TableData *rel, char *name)
 {
-    // Initialize record manager and table data
+    // Every open table has its own record manager and buffer pool, the frames take the page size of the file
+    RecordManager *recordManager = (RecordManager*) calloc(1, sizeof(RecordManager));
+    if (recordManager == NULL) {
+        return RC_RM_NO_MORE_MEMORY;
+    }
+    RC status = initBufferPool(&recordManager->bufferPool, name, MAX_NUMBER_OF_PAGES, RS_LRU, NULL);
+    if (status != RC_OK) {
+        free(recordManager);
+        return status;
+    }
+
+    // Initialize table data
     rel->mgmtData = recordManager;
     rel->name = name;
     // Pin the first page of the table
@@ -167,15 +879,20 @@ extern RC openTable (RM_TableData *rel, char *name)
     // Read the tuples count from the page
     recordManager->tuplesCount = *(int*)pageHandle;
     pageHandle += sizeof(int);
-    // Read the free page from the page
+    // Read the free page from the page, the free-space map replaces it with the first page with room
     recordManager->freePage = *(int*)pageHandle;
     pageHandle += sizeof(int);
+    loadFreeSpaceMap(recordManager);
 
     // Create a new schema and allocate memory for its attributes
     Schema* schema = (Schema*) malloc(sizeof(Schema));
     // Read the number of attributes from the page
     schema->numAttr = *(int*)pageHandle;
     pageHandle += sizeof(int);
+    // Read the key size from the page, the key attributes are not stored
+    schema->keySize = *(int*)pageHandle;
+    schema->keyAttrs = NULL;
+    pageHandle += sizeof(int);
     // Allocate memory for the attribute names, data types, and type lengths
     schema->attrNames = (char**) malloc(sizeof(char*) * schema->numAttr);
     schema->dataTypes = (DataType*) malloc(sizeof(DataType) * schema->numAttr);
@@ -208,15 +925,47 @@ extern RC openTable (RM_TableData *rel, char *name)
 
 
   
+// This function writes the tuples count and the insert hint back to the first page of the table
+RC writeTableHeader(RecordManager *recordManager)
+{
+    RC result = pinPage(&recordManager->bufferPool, &recordManager->pageHandle, 0);
+    if (result != RC_OK) {
+        return result;
+    }
+
+    ((int *) recordManager->pageHandle.data)[0] = recordManager->tuplesCount;
+    ((int *) recordManager->pageHandle.data)[1] = recordManager->freePage;
+    markDirty(&recordManager->bufferPool, &recordManager->pageHandle);
+    return unpinPage(&recordManager->bufferPool, &recordManager->pageHandle);
+}
+
 // This function closes the table and cleans up the buffer pool
 extern RC closeTable (RM_TableData *rel)
 {
     // Get the record manager from the relation data
     RecordManager *recordManager = rel->mgmtData;
+    if (recordManager == NULL) {
+        return RC_RM_NULL_ARGUMENT;
+    }
 
-    // If the record manager exists, shut down the buffer pool
-    if (recordManager != NULL && &recordManager->bufferPool != NULL) {
-        shutdownBufferPool(&recordManager->bufferPool);
+    // Write the table header and save the free-space map, then shut down the buffer pool, a pool with pinned pages
+    // keeps the table open
+    writeTableHeader(recordManager);
+    saveFreeSpaceMap(recordManager);
+    RC result = shutdownBufferPool(&recordManager->bufferPool);
+    if (result != RC_OK) {
+        return result;
+    }
+
+    // Release the manager and the schema read by openTable
+    free(recordManager->freeSpace);
+    free(recordManager);
+    rel->mgmtData = NULL;
+    if (rel->schema != NULL) {
+        for (int i = 0; i < rel->schema->numAttr; i++)
+            free(rel->schema->attrNames[i]);
+        freeSchema(rel->schema);
+        rel->schema = NULL;
     }
 
     // Return success code
@@ -226,9 +975,12 @@ extern RC closeTable (RM_TableData *rel)
 // This function deletes a table by its name
 extern RC deleteTable (char *tableName)
 {
-    // If the table name exists, destroy the page file
+    // If the table name exists, destroy the page file and the page file of its free-space map
     if(tableName != NULL) {
         destroyPageFile(tableName);
+        char *freeSpaceFile = getFreeSpaceFileName(tableName);
+        destroyPageFile(freeSpaceFile);
+        free(freeSpaceFile);
     }
 
     // Return success code
@@ -248,34 +1000,66 @@ extern int getNumTuples (RM_TableData *rel)
 }
 
 
-// Function to manage page pinning and data setting for a record
-void manageRecordPage(RM_TableData *rel, Record *record, int recordSize, int nextPageFlag) {
-    // Validate input parameters
-    if (rel == NULL || record == NULL || recordSize <= 0) {
-        printf("Invalid parameters.\n");
-        return;
-    }
-
-    // Retrieve the RecordManager and the RID from the parameters
+// This function stores a record in its stored format on the first page with room for it, found through the
+// free-space map. A page whose entry turns out to be stale is corrected and skipped.
+RC placeRecord(RM_TableData *rel, char *stored, int length, RID *id)
+{
     RecordManager *recordManager = rel->mgmtData;
-    RID *recordID = &record->id;
+    int pageSize = recordManager->bufferPool.pageSize;
+    int slotCapacity = getSlotCapacity(rel->schema, pageSize);
+    BM_PageHandle pageHandle;
 
-    // Page management
-    if (nextPageFlag) {
-        if (unpinPage(&recordManager->bufferPool, &recordManager->pageHandle) != RC_OK) {
-            printf("Failed to unpin page.\n");
-            return;
+    id->page = findPageWithRoom(recordManager, length);
+    id->slot = -1;
+    while (id->slot == -1) {
+        // Past the pages of the map the table takes a new page from the storage manager
+        if (id->page >= recordManager->numPages && allocateTablePage(recordManager, &id->page) != RC_OK) {
+            return RC_ERROR;
+        }
+        if (pinPage(&recordManager->bufferPool, &pageHandle, id->page) != RC_OK) {
+            printf("Failed to pin page.\n");
+            return RC_ERROR;
         }
-        recordID->page++;
-    }
 
-    if (pinPage(&recordManager->bufferPool, &recordManager->pageHandle, recordID->page) != RC_OK) {
-        printf("Failed to pin page.\n");
-        return;
+        initializeRecordPage(pageHandle.data, slotCapacity, pageSize);
+        id->slot = placeOnPage(pageHandle.data, stored, length, pageSize);
+        noteFreeSpace(recordManager, rel->schema, id->page, pageHandle.data);
+        bool empty = ((PageHeader *) pageHandle.data)->liveCount == 0;
+        if (id->slot != -1)
+            markDirty(&recordManager->bufferPool, &pageHandle);
+        unpinPage(&recordManager->bufferPool, &pageHandle);
+
+        // Even an empty page has no room for the record
+        if (id->slot == -1 && empty)
+            return RC_ERROR;
+        if (id->slot == -1)
+            id->page = findPageWithRoom(recordManager, length);
     }
+    return RC_OK;
+}
+
+// This function removes a stored record from its page and records the new free space of the page, a page left
+// without records is freed
+RC removeRecord(RM_TableData *rel, RID id)
+{
+    RecordManager *recordManager = rel->mgmtData;
+    BM_PageHandle pageHandle;
+    bool emptied = FALSE;
+
+    RC status = pinPage(&recordManager->bufferPool, &pageHandle, id.page);
+    if (status != RC_OK)
+        return status;
 
-    // Find and set the slot for the record
-    recordID->slot = findFreeSlot(recordManager->pageHandle.data, recordSize);
+    if (isSlotUsed(pageHandle.data, id.slot)) {
+        removeFromPage(pageHandle.data, id.slot, recordManager->bufferPool.pageSize);
+        noteFreeSpace(recordManager, rel->schema, id.page, pageHandle.data);
+        markDirty(&recordManager->bufferPool, &pageHandle);
+        emptied = ((PageHeader *) pageHandle.data)->liveCount == 0;
+    }
+    status = unpinPage(&recordManager->bufferPool, &pageHandle);
+    if (emptied)
+        releaseEmptyPage(recordManager, &pageHandle);
+    return status;
 }
 
 extern RC insertRecord (RM_TableData *rel, Record *record)
@@ -286,52 +1070,174 @@ extern RC insertRecord (RM_TableData *rel, Record *record)
         return RC_INVALID_PARAMETER;
     }
 
-    // Retrieve the RecordManager and the RID from the parameters
+    // A single record is a batch of one
+    return insertRecords(rel, &record, 1);
+}
+
+// This function inserts numRecords records and sets their RIDs. Each page the free-space map picks is pinned once
+// and filled with as many of the records as fit, the tuple count is updated once for the whole batch. If a record
+// does not fit even an empty page, the records before it stay inserted and RC_ERROR is returned.
+extern RC insertRecords (RM_TableData *rel, Record **records, int numRecords)
+{
+    // Validate input parameters
+    if (rel == NULL || records == NULL || numRecords < 0) {
+        printf("Invalid parameters.\n");
+        return RC_INVALID_PARAMETER;
+    }
+
     RecordManager *recordManager = rel->mgmtData;
-    RID *recordID = &record->id;
+    int pageSize = recordManager->bufferPool.pageSize;
+    int slotCapacity = getSlotCapacity(rel->schema, pageSize);
+    char *stored = (char *) malloc(getMaxStoredSize(rel->schema));
+    BM_PageHandle pageHandle;
+    RC status = RC_OK;
+    int inserted = 0;
+    int length = -1;
+
+    while (inserted < numRecords) {
+        // Encode the next record, strings take only the bytes they use
+        if (length == -1)
+            length = encodeRecord(rel->schema, records[inserted]->data, RECORD_MARKER, records[inserted]->id, stored);
+
+        // Go to the first page the free-space map knows to have room for it, or take a new page
+        int page = findPageWithRoom(recordManager, length);
+        if (page >= recordManager->numPages && (status = allocateTablePage(recordManager, &page)) != RC_OK) {
+            break;
+        }
+        if ((status = pinPage(&recordManager->bufferPool, &pageHandle, page)) != RC_OK) {
+            printf("Failed to pin page.\n");
+            break;
+        }
+        initializeRecordPage(pageHandle.data, slotCapacity, pageSize);
+
+        // Fill the page under this pin until a record does not fit, a stale entry places none
+        int placed = 0;
+        while (inserted < numRecords) {
+            if (length == -1)
+                length = encodeRecord(rel->schema, records[inserted]->data, RECORD_MARKER, records[inserted]->id, stored);
+            int slot = placeOnPage(pageHandle.data, stored, length, pageSize);
+            if (slot == -1)
+                break;
+            records[inserted]->id = (RID){ .page = page, .slot = slot };
+            inserted++;
+            placed++;
+            length = -1;
+        }
 
-    // Calculate the size of the record
-    int recordSize = getRecordSize(rel->schema);
+        noteFreeSpace(recordManager, rel->schema, page, pageHandle.data);
+        bool empty = ((PageHeader *) pageHandle.data)->liveCount == 0;
+        if (placed > 0)
+            markDirty(&recordManager->bufferPool, &pageHandle);
+        unpinPage(&recordManager->bufferPool, &pageHandle);
 
-    // Assign the free page to the record ID
-    recordID->page = recordManager->freePage;
+        // Even an empty page has no room for the record
+        if (placed == 0 && empty) {
+            status = RC_ERROR;
+            break;
+        }
+    }
+    free(stored);
+
+    // Increment the count of tuples in the record manager
+    recordManager->tuplesCount += inserted;
+
+    return status;
+}
 
-    // Manage the record page without incrementing the page
-    manageRecordPage(rel, record, recordSize, 0);
+// This function writes the formatted pages of the bulk loader to the end of the table and enters their free bytes
+// into the free-space map
+RC writeBulkPages(RecordManager *recordManager, Schema *schema, SM_FileHandle *fileHandle, int firstPage, int numPages, char *pages)
+{
+    int pageSize = recordManager->bufferPool.pageSize;
+    int slotCapacity = getSlotCapacity(schema, pageSize);
 
-    // If no free slot is found, manage the record page with incrementing the page
-    while(recordID->slot == -1) {
-        manageRecordPage(rel, record, recordSize, 1);
+    RC result = writeBlocks(firstPage, numPages, fileHandle, pages);
+    if (result != RC_OK) {
+        return result;
     }
 
-    // Get the pointer to the slot in the page
-    char *slotPointer = recordManager->pageHandle.data + (recordID->slot * recordSize);
+    growFreeSpaceMap(recordManager, firstPage + numPages);
+    for (int i = 0; i < numPages; i++)
+        recordManager->freeSpace[firstPage + i] = getPageFreeBytes(pages + (size_t) i * pageSize, slotCapacity, pageSize);
+    return RC_OK;
+}
 
-    // Mark the page as dirty as it's going to be modified
-    markDirty(&recordManager->bufferPool, &recordManager->pageHandle);
+// This function appends numRecords records to the table on new pages and sets their RIDs, without going through the
+// buffer pool. The pages are formatted in a private buffer and written BULK_LOAD_PAGES at a time with writeBlocks().
+// The pool is flushed first and only pages past the end of the file are written, so no frame and no evicted copy of
+// the pool can hold an old version of them. Free space on the existing pages is not used. The tuple count and the
+// table header are updated once at the end.
+extern RC bulkLoadRecords (RM_TableData *rel, Record **records, int numRecords)
+{
+    // Validate input parameters
+    if (rel == NULL || records == NULL || numRecords < 0) {
+        printf("Invalid parameters.\n");
+        return RC_INVALID_PARAMETER;
+    }
 
-    // Assign the record to the slot and advance the slotPointer
-    *slotPointer = '+';
-    memcpy(slotPointer + 1, record->data + 1, recordSize - 1);
+    RecordManager *recordManager = rel->mgmtData;
+    int pageSize = recordManager->bufferPool.pageSize;
+    int slotCapacity = getSlotCapacity(rel->schema, pageSize);
+    SM_FileHandle fileHandle;
 
-    // Unpin the page, as we've finished writing to it
-    RC status = unpinPage(&recordManager->bufferPool, &recordManager->pageHandle);
-    if (status != RC_OK) {
-        printf("Failed to unpin the page.\n");
+    // Write back the pool, then append after the last page of the file
+    RC status = forceFlushPool(&recordManager->bufferPool);
+    if (status != RC_OK || (status = openPageFile(recordManager->bufferPool.pageFile, &fileHandle)) != RC_OK) {
         return status;
     }
+    int firstPage = fileHandle.totalNumPages;
+
+    char *pages = (char *) calloc(BULK_LOAD_PAGES, pageSize);
+    char *stored = (char *) malloc(getMaxStoredSize(rel->schema));
+    int filled = 0;
+    int loaded = 0;
+    bool tooLong = FALSE;
+
+    char *page = pages;
+    initializeRecordPage(page, slotCapacity, pageSize);
+    while (loaded < numRecords && status == RC_OK) {
+        int length = encodeRecord(rel->schema, records[loaded]->data, RECORD_MARKER, records[loaded]->id, stored);
+        int slot = placeOnPage(page, stored, length, pageSize);
+
+        // A full page is done, the buffer is written when all of its pages are
+        if (slot == -1) {
+            if (((PageHeader *) page)->liveCount == 0) {
+                tooLong = TRUE;
+                break;
+            }
+            if (++filled == BULK_LOAD_PAGES) {
+                status = writeBulkPages(recordManager, rel->schema, &fileHandle, firstPage, filled, pages);
+                firstPage += filled;
+                filled = 0;
+                memset(pages, 0, (size_t) BULK_LOAD_PAGES * pageSize);
+            }
+            page = pages + (size_t) filled * pageSize;
+            initializeRecordPage(page, slotCapacity, pageSize);
+            continue;
+        }
 
-    // Increment the count of tuples in the record manager
-    recordManager->tuplesCount++;
-
-    // Pin the first page in the buffer pool
-    status = pinPage(&recordManager->bufferPool, &recordManager->pageHandle, 0);
-    if (status != RC_OK) {
-        printf("Failed to pin the first page.\n");
+        records[loaded]->id = (RID){ .page = firstPage + filled, .slot = slot };
+        loaded++;
     }
 
-    // Return the status of the operation
-    return status;
+    // Write the pages of the buffer that hold records, a record that does not fit an empty page stops the load after
+    // the records before it
+    if (status == RC_OK) {
+        if (((PageHeader *) page)->liveCount > 0)
+            filled++;
+        if (filled > 0)
+            status = writeBulkPages(recordManager, rel->schema, &fileHandle, firstPage, filled, pages);
+        if (status == RC_OK && tooLong)
+            status = RC_ERROR;
+    }
+    free(stored);
+    free(pages);
+    closePageFile(&fileHandle);
+
+    // Update the tuple count and the table header once
+    recordManager->tuplesCount += loaded;
+    RC written = writeTableHeader(recordManager);
+    return status != RC_OK ? status : written;
 }
 
 
@@ -347,9 +1253,6 @@ RC deleteRecord (RM_TableData *rel, RID id) {
     // Retrieve the record manager from the table's meta data
     RecordManager *recordManager = rel->mgmtData;
 
-    // Calculate the size of the record
-    int recordSize = getRecordSize(rel->schema);
-
     // Pin the page containing the record to be deleted
     RC status = pinPage(&recordManager->bufferPool, &recordManager->pageHandle, id.page);
     if (status != RC_OK) {
@@ -357,14 +1260,24 @@ RC deleteRecord (RM_TableData *rel, RID id) {
         return status;
     }
 
-    // Set the data pointer to the start of the record to be deleted
-    char *data = recordManager->pageHandle.data + id.slot * recordSize;
-
-    // Mark the record with a tombstone as deleted 
-    *data = '-';
+    // The space of a live record becomes free space of the page, a record that was moved away is removed too
+    char *page = recordManager->pageHandle.data;
+    bool emptied = FALSE;
+    if (isSlotUsed(page, id.slot)) {
+        char *stored = getSlotPointer(page, id.slot);
+        if (*stored == FORWARD_MARKER) {
+            status = removeRecord(rel, getStoredRID(stored));
+            if (status != RC_OK) {
+                unpinPage(&recordManager->bufferPool, &recordManager->pageHandle);
+                return status;
+            }
+        }
 
-    // Update the free page since this page now has a free slot
-    recordManager->freePage = id.page;
+        removeFromPage(page, id.slot, recordManager->bufferPool.pageSize);
+        noteFreeSpace(recordManager, rel->schema, id.page, page);
+        recordManager->tuplesCount--;
+        emptied = ((PageHeader *) page)->liveCount == 0;
+    }
 
     // Mark the page as dirty since it has been modified
     status = markDirty(&recordManager->bufferPool, &recordManager->pageHandle);
@@ -380,36 +1293,90 @@ RC deleteRecord (RM_TableData *rel, RID id) {
         return status;
     }
 
+    // A page without records goes back to the storage manager
+    if (emptied) {
+        releaseEmptyPage(recordManager, &recordManager->pageHandle);
+    }
+
     return RC_OK;
 }
 
 
 
+// This function replaces the stored record of a slot, or moves it to another page with room for it when it grew
+// past the room of its page. The old slot then keeps a forward stub, so the RID of the record stays valid.
+RC storeUpdatedRecord(RM_TableData *rel, Record *record, RID id, char *stored, int length, bool relocated)
+{
+    RecordManager *recordManager = rel->mgmtData;
+    int pageSize = recordManager->bufferPool.pageSize;
+    BM_PageHandle pageHandle;
+
+    RC status = pinPage(&recordManager->bufferPool, &pageHandle, id.page);
+    if (status != RC_OK)
+        return status;
+
+    bool replaced = replaceOnPage(pageHandle.data, id.slot, stored, length, pageSize);
+    if (replaced) {
+        noteFreeSpace(recordManager, rel->schema, id.page, pageHandle.data);
+        markDirty(&recordManager->bufferPool, &pageHandle);
+    }
+    unpinPage(&recordManager->bufferPool, &pageHandle);
+    if (replaced)
+        return RC_OK;
+
+    // The new copy is placed before a relocated record leaves its page, so a failed move keeps the old one
+    if (!relocated)
+        length = encodeRecord(rel->schema, record->data, RELOCATED_MARKER, record->id, stored);
+
+    RID target;
+    status = placeRecord(rel, stored, length, &target);
+    if (status != RC_OK)
+        return status;
+
+    // The home slot becomes a stub, which is never longer than the record it replaces
+    length = encodeForwardStub(target, stored);
+    status = pinPage(&recordManager->bufferPool, &pageHandle, record->id.page);
+    if (status != RC_OK)
+        return status;
+    replaceOnPage(pageHandle.data, record->id.slot, stored, length, pageSize);
+    noteFreeSpace(recordManager, rel->schema, record->id.page, pageHandle.data);
+    markDirty(&recordManager->bufferPool, &pageHandle);
+    status = unpinPage(&recordManager->bufferPool, &pageHandle);
+    if (status != RC_OK)
+        return status;
+
+    // The stub points at the new copy, the old one is removed
+    return relocated ? removeRecord(rel, id) : RC_OK;
+}
+
 extern RC updateRecord (RM_TableData *rel, Record *record)
 {
     // Retrieve the record manager from the table's metadata
     RecordManager *recordManager = rel->mgmtData;
-    
-    // Calculate the size of the record
-    int recordSize = getRecordSize(rel->schema);
-    
+
     // Pin the page containing the record to be updated
     pinPage(&recordManager->bufferPool, &recordManager->pageHandle, record->id.page);
 
-    // Calculate the start position of the record to be updated
-    char *data = recordManager->pageHandle.data + record->id.slot * recordSize;
-    
-   // Update the record data
-    data[0] = '+';
-    memcpy(data + 1, record->data + 1, recordSize - 1);
-
-    // Handle page modifications
-    if (markDirty(&recordManager->bufferPool, &recordManager->pageHandle) == RC_OK && 
-        unpinPage(&recordManager->bufferPool, &recordManager->pageHandle) == RC_OK) {
-        return RC_OK;
-    } else {
-        return RC_ERROR;
+    // Only a slot that holds a record can be updated
+    char *page = recordManager->pageHandle.data;
+    if (!isSlotUsed(page, record->id.slot)) {
+        unpinPage(&recordManager->bufferPool, &recordManager->pageHandle);
+        return RC_RM_NO_TUPLE_WITH_GIVEN_RID;
     }
+
+    // A record that was moved away is updated where it is now
+    char *data = getSlotPointer(page, record->id.slot);
+    bool relocated = *data == FORWARD_MARKER;
+    RID id = relocated ? getStoredRID(data) : record->id;
+    unpinPage(&recordManager->bufferPool, &recordManager->pageHandle);
+
+    // Encode the new record data, then store it in place or move it
+    char *stored = (char *) malloc(getMaxStoredSize(rel->schema));
+    int length = encodeRecord(rel->schema, record->data, relocated ? RELOCATED_MARKER : RECORD_MARKER, record->id, stored);
+    RC status = storeUpdatedRecord(rel, record, id, stored, length, relocated);
+    free(stored);
+
+    return status == RC_OK ? RC_OK : RC_ERROR;
 }
 
 
@@ -435,21 +1402,35 @@ RC getRecord(RM_TableData *rel, RID id, Record *record) {
         return pinStatus;
     }
 
-    // Calculate the slot's position in the page
-    char *slotPointer = recordManager->pageHandle.data + (id.slot * recordSize);
-
     // Check if the record exists
-    if(*slotPointer != '+') {
+    char *page = recordManager->pageHandle.data;
+    if(!isSlotUsed(page, id.slot)) {
         unpinPage(&recordManager->bufferPool, &recordManager->pageHandle); 
         return RC_RM_NO_TUPLE_WITH_GIVEN_RID;
     }
 
+    // Find the stored record of the slot, following the stub of a record that was moved away
+    char *slotPointer = getSlotPointer(page, id.slot);
+    BM_PageHandle target;
+    bool relocated = *slotPointer == FORWARD_MARKER;
+    if (relocated) {
+        RID targetID = getStoredRID(slotPointer);
+        pinStatus = pinPage(&recordManager->bufferPool, &target, targetID.page);
+        if (pinStatus != RC_OK) {
+            unpinPage(&recordManager->bufferPool, &recordManager->pageHandle);
+            return pinStatus;
+        }
+        slotPointer = getSlotPointer(target.data, targetID.slot);
+    }
+
     // Copy the record's data
     record->id = id;
-    char *recordData = record->data;
-    memcpy(++recordData, ++slotPointer, recordSize - 1);
+    decodeRecord(rel->schema, slotPointer, record->data, NULL);
 
     // Unpin the page
+    if (relocated) {
+        unpinPage(&recordManager->bufferPool, &target);
+    }
     RC unpinStatus = unpinPage(&recordManager->bufferPool, &recordManager->pageHandle);
     if(unpinStatus != RC_OK) {
         return unpinStatus;
@@ -463,110 +1444,457 @@ RC getRecord(RM_TableData *rel, RID id, Record *record) {
 
 // ******** SCAN FUNCTIONS ******** //
 
+// Helper function to move the scan past pages that are free in the page file
+void skipFreePages(RecordManager *scanManager) {
+    while (isPageFree(scanManager->recordID.page, &scanManager->fileHandle)) {
+        scanManager->recordID.page++;
+    }
+}
+
+// Helper function to let the kernel read the pages ahead of the scan, renewed every half window
+void adviseScanReadahead(RecordManager *scanManager) {
+    int page = scanManager->recordID.page;
+    if (scanManager->fileHandle.mgmtInfo == NULL || page < scanManager->readaheadPage) {
+        return;
+    }
+
+    adviseBlocks(page, SCAN_READAHEAD_PAGES, &scanManager->fileHandle, SM_ADVICE_WILLNEED);
+    scanManager->readaheadPage = page + SCAN_READAHEAD_PAGES / 2;
+}
+
+// Helper function to mark the attributes a condition reads
+void markConditionAttrs(Expr *expr, bool *wanted, int numAttr) {
+    if (expr->type == EXPR_ATTRREF) {
+        if (expr->expr.attrRef >= 0 && expr->expr.attrRef < numAttr) {
+            wanted[expr->expr.attrRef] = TRUE;
+        }
+    }
+    else if (expr->type == EXPR_OP) {
+        int numArgs = expr->expr.op->type == OP_BOOL_NOT ? 1 : 2;
+        for (int i = 0; i < numArgs; i++) {
+            markConditionAttrs(expr->expr.op->args[i], wanted, numAttr);
+        }
+    }
+}
+
+// Helper function to release what a projecting scan allocated
+void freeScanProjection(RecordManager *scanManager) {
+    if (scanManager->projectedSchema != NULL) {
+        for (int i = 0; i < scanManager->projectedSchema->numAttr; i++) {
+            free(scanManager->projectedSchema->attrNames[i]);
+        }
+        freeSchema(scanManager->projectedSchema);
+    }
+    free(scanManager->columns);
+    free(scanManager->wanted);
+    free(scanManager->scratch);
+    scanManager->projectedSchema = NULL;
+    scanManager->columns = NULL;
+    scanManager->wanted = NULL;
+    scanManager->scratch = NULL;
+}
+
+// Helper function to set up a scan returning only the attributes attrs of the table, in that order
+RC setupScanProjection(RecordManager *scanManager, Schema *schema, Expr *cond, int *attrs, int numAttrs) {
+    char **attrNames = calloc(numAttrs, sizeof(char *));
+    DataType *dataTypes = malloc(sizeof(DataType) * numAttrs);
+    int *typeLength = malloc(sizeof(int) * numAttrs);
+    scanManager->projectedSchema = createSchema(numAttrs, attrNames, dataTypes, typeLength, 0, NULL);
+    scanManager->columns = malloc(sizeof(ProjectedColumn) * numAttrs);
+    scanManager->wanted = calloc(schema->numAttr, sizeof(bool));
+    scanManager->scratch = malloc(getRecordSize(schema));
+    if (attrNames == NULL || dataTypes == NULL || typeLength == NULL || scanManager->projectedSchema == NULL
+        || scanManager->columns == NULL || scanManager->wanted == NULL || scanManager->scratch == NULL) {
+        if (scanManager->projectedSchema == NULL) {
+            free(attrNames);
+            free(dataTypes);
+            free(typeLength);
+        }
+        freeScanProjection(scanManager);
+        return RC_RM_NO_MORE_MEMORY;
+    }
+
+    // The projected schema copies the attributes, the compact record has them back to back in the order asked for
+    int target = 1;
+    for (int i = 0; i < numAttrs; i++) {
+        int attr = attrs[i];
+        attrNames[i] = strdup(schema->attrNames[attr]);
+        dataTypes[i] = schema->dataTypes[attr];
+        typeLength[i] = schema->typeLength[attr];
+
+        ProjectedColumn *column = &scanManager->columns[i];
+        column->attr = attr;
+        attrOffset(schema, attr, &column->source);
+        column->target = target;
+        column->size = dataTypes[i] == DT_STRING ? typeLength[i] : getFixedSize(dataTypes[i]);
+        target += column->size;
+    }
+
+    // The attributes the condition reads
+    markConditionAttrs(cond, scanManager->wanted, schema->numAttr);
+    return RC_OK;
+}
+
+// Helper function to let the compiled condition of a projecting scan read the compact record it returns. This works
+// when the scan returns every attribute the condition reads, the loads of the program are moved to their columns.
+bool moveConditionToProjection(RecordManager *scanManager, Schema *schema) {
+    CompiledExpr *compiled = scanManager->compiledCondition;
+    if (compiled == NULL)
+        return FALSE;
+
+    // Every attribute of the condition has to be one of the columns
+    for (int attr = 0; attr < schema->numAttr; attr++) {
+        bool returned = !scanManager->wanted[attr];
+        for (int c = 0; c < scanManager->projectedSchema->numAttr && !returned; c++)
+            returned = scanManager->columns[c].attr == attr;
+        if (!returned)
+            return FALSE;
+    }
+
+    // Attributes are loaded at their offset in the full record, which is the source of their column. The loads are
+    // the first opcodes of ExprOpcode.
+    for (int i = 0; i < compiled->numInstructions; i++) {
+        ExprInstruction *instruction = &compiled->program[i];
+        if (instruction->code > EXPR_LOAD_STRING)
+            continue;
+        for (int c = 0; c < scanManager->projectedSchema->numAttr; c++) {
+            if (scanManager->columns[c].source == instruction->offset) {
+                instruction->offset = scanManager->columns[c].target;
+                break;
+            }
+        }
+    }
+    return TRUE;
+}
+
 // This function scans all the records using the condition
 extern RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond)
+{
+    return startScanWithProjection(rel, scan, cond, NULL, 0);
+}
+
+// This function scans the records that meet the condition and returns only the attributes attrs of each, in a
+// compact record of the schema getScanSchema() returns. Attributes that are neither returned nor read by the
+// condition are not copied out of the page. A NULL attrs returns whole records like startScan().
+extern RC startScanWithProjection (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond, int *attrs, int numAttrs)
 {
     // Return an error if the scan condition is not provided
     if (!cond) return RC_SCAN_CONDITION_NOT_FOUND;
 
-    // Open the table in memory
-    openTable(rel, "ScanTable");
+    // Every attribute asked for has to be one of the table
+    if (attrs != NULL) {
+        if (numAttrs <= 0) return RC_INVALID_PARAMETER;
+        for (int i = 0; i < numAttrs; i++) {
+            if (attrs[i] < 0 || attrs[i] >= rel->schema->numAttr) return RC_INVALID_PARAMETER;
+        }
+    }
 
     // Allocate memory for Scan Manager
-RecordManager *scanManager = calloc(1, sizeof(RecordManager));
-// Handle memory allocation failure
-if(scanManager == NULL) return RC_RM_NO_MORE_MEMORY;
+    RecordManager *scanManager = calloc(1, sizeof(RecordManager));
+    // Handle memory allocation failure
+    if(scanManager == NULL) return RC_RM_NO_MORE_MEMORY;
+
+    // Set up the projection
+    if (attrs != NULL) {
+        RC status = setupScanProjection(scanManager, rel->schema, cond, attrs, numAttrs);
+        if (status != RC_OK) {
+            free(scanManager);
+            return status;
+        }
+    }
+
+    // Set the mgmtData of scan to scanManager
+    scan->mgmtData = scanManager;
+
+    // Set the initial page and slot for the scan
+    scanManager->recordID = (RID){ .page = 1, .slot = 0 };
 
-// Set the mgmtData of scan to scanManager
-scan->mgmtData = scanManager;
+    // The free-space map entry of an empty page, empty pages are skipped without pinning them
+    RecordManager *tableManager = rel->mgmtData;
+    int pageSize = tableManager->bufferPool.pageSize;
+    scanManager->emptyPageBytes = getPageFreeBytes((char *) &(PageHeader){ 0 }, getSlotCapacity(rel->schema, pageSize), pageSize);
 
-// Set the initial page and slot for the scan
-scanManager->recordID = (RID){ .page = 1, .slot = 0 };
+    // Open the page file to consult its free map, the scan still works without it
+    if (openPageFile(tableManager->bufferPool.pageFile, &scanManager->fileHandle) != RC_OK)
+        scanManager->fileHandle.mgmtInfo = NULL;
+    else
+        adviseBlocks(0, 0, &scanManager->fileHandle, SM_ADVICE_SEQUENTIAL);
+    skipFreePages(scanManager);
 
-// Initialize scanCount and condition
-scanManager->scanCount = 0; 
-scanManager->condition = cond;
+    // Initialize scanCount and condition, the condition is compiled once for all records of the scan
+    scanManager->scanCount = 0;
+    scanManager->condition = cond;
+    if (compileExpr(cond, rel->schema, &scanManager->compiledCondition) != RC_OK)
+        scanManager->compiledCondition = NULL;
 
+    // A projecting scan evaluates the condition on the record it returns if it can, on scratch otherwise
+    if (scanManager->projectedSchema != NULL)
+        scanManager->scratchCondition = !moveConditionToProjection(scanManager, rel->schema);
 
     // Set the scan's table
     scan->rel= rel;
 
-    // Set the table manager attributes
-    RecordManager *tableManager = rel->mgmtData;
-    tableManager->tuplesCount = ATTRIBUTE_SIZE;  // Set the tuple count
-
     return RC_OK;
 }
 
-
-
-// Helper function to increment the record ID
-void incrementRecordID(RecordManager *scanManager, int totalSlots) {
-    if(++scanManager->recordID.slot >= totalSlots) {
-        scanManager->recordID.slot = 0;
-        scanManager->recordID.page++;
+// This function returns the schema of the records a scan returns, the projected one for a projecting scan
+extern Schema *getScanSchema (RM_ScanHandle *scan)
+{
+    if (scan == NULL || scan->mgmtData == NULL) {
+        return NULL;
     }
+
+    RecordManager *scanManager = scan->mgmtData;
+    return scanManager->projectedSchema != NULL ? scanManager->projectedSchema : scan->rel->schema;
 }
 
-extern RC next (RM_ScanHandle *scan, Record *record) {
-    // Validate input parameters
-    if (scan == NULL || record == NULL) {
-        printf("Invalid parameters.\n");
-        return RC_RM_NULL_ARGUMENT;
+
+
+// Helper function to unpin the page a scan has visited all slots of, the scan will not come back to it
+void releaseScanPage(RecordManager *scanManager, RecordManager *tableManager) {
+    if (scanManager->pagePinned) {
+        unpinPageWithHint(&tableManager->bufferPool, &scanManager->pageHandle, EH_EVICT_SOON);
+        scanManager->pagePinned = FALSE;
     }
+}
 
-    // Retrieve the necessary data
-    RecordManager *scanManager = scan->mgmtData;
-    RecordManager *tableManager = scan->rel->mgmtData;
-    Schema *schema = scan->rel->schema;
-    int totalSlots = PAGE_SIZE / getRecordSize(schema);
-    Value *result = (Value *) malloc(sizeof(Value));
+// Helper function to move the scan to the first slot of the next page that is not free in the page file
+void moveScanToNextPage(RecordManager *scanManager) {
+    scanManager->recordID.page++;
+    scanManager->recordID.slot = 0;
+    skipFreePages(scanManager);
+}
 
-    // Early return if no tuples or no scan condition
-    if (tableManager->tuplesCount == 0) return RC_RM_NO_MORE_TUPLES;
-    if (scanManager->condition == NULL) return RC_SCAN_CONDITION_NOT_FOUND;
+// Helper function to pin the page of a scan, or the next page after it that may hold records. Pages the free-space
+// map knows to be empty or freed are skipped without pinning them. RC_RM_NO_MORE_TUPLES is returned at the end of
+// the table.
+RC pinScanPage(RecordManager *scanManager, RecordManager *tableManager) {
+    RID *recordID = &scanManager->recordID;
+
+    while (!scanManager->pagePinned) {
+        if (recordID->page >= tableManager->numPages)
+            return RC_RM_NO_MORE_TUPLES;
+        if (tableManager->freeSpace[recordID->page] == scanManager->emptyPageBytes ||
+            tableManager->freeSpace[recordID->page] == FREE_SPACE_FREED) {
+            moveScanToNextPage(scanManager);
+            continue;
+        }
 
-    // Scan loop
-    while(scanManager->scanCount++ < tableManager->tuplesCount) {
-        // Handle incrementing record ID
-        if (scanManager->scanCount > 1) incrementRecordID(scanManager, totalSlots);
+        // Keep the kernel reading ahead of the scan
+        adviseScanReadahead(scanManager);
 
         // Pin the page
-        RC status = pinPage(&tableManager->bufferPool, &scanManager->pageHandle, scanManager->recordID.page);
+        RC status = pinPage(&tableManager->bufferPool, &scanManager->pageHandle, recordID->page);
         if (status != RC_OK) {
             printf("Failed to pin page.\n");
             return status;
         }
+        scanManager->pagePinned = TRUE;
+    }
+    return RC_OK;
+}
 
-        // Retrieve record data
-        char *data = scanManager->pageHandle.data + (scanManager->recordID.slot * getRecordSize(schema));
+// Helper function to decode the stored record of a slot of the pinned page into record and check it against the
+// condition of the scan. A record that was moved keeps the RID of its home slot.
+bool matchScanRecord(RecordManager *scanManager, Schema *schema, char *data, int slot, Record *record) {
+    scanManager->scanCount++;
+
+    // A projecting scan decodes the attributes it returns straight into the record, a condition on other
+    // attributes first gets its own ones in the scratch record.
+    bool onScratch = scanManager->projectedSchema != NULL && scanManager->scratchCondition;
+    Record decoded = {
+        .id = *data == RELOCATED_MARKER ? getStoredRID(data) : (RID){ .page = scanManager->recordID.page, .slot = slot },
+        .data = onScratch ? scanManager->scratch : record->data
+    };
+    *decoded.data = '-';
+    if (scanManager->projectedSchema != NULL && !onScratch)
+        decodeProjectedRecord(schema, data, scanManager->columns, scanManager->projectedSchema->numAttr, decoded.data);
+    else
+        decodeRecord(schema, data, decoded.data, scanManager->wanted);
+
+    // Check record against scan condition
+    bool matches;
+    if (scanManager->compiledCondition != NULL) {
+        matches = evalCompiledExpr(scanManager->compiledCondition, decoded.data);
+    }
+    else {
+        Value *result;
+        evalExpr(&decoded, schema, scanManager->condition, &result);
+        matches = result->v.boolV == TRUE;
+        freeVal(result);
+    }
+    if (!matches)
+        return FALSE;
 
-        // Copy record data
-        record->id = scanManager->recordID;
+    record->id = decoded.id;
+    if (onScratch) {
         *record->data = '-';
-        memcpy(record->data + 1, data + 1, getRecordSize(schema) - 1);
+        decodeProjectedRecord(schema, data, scanManager->columns, scanManager->projectedSchema->numAttr, record->data);
+    }
+    return TRUE;
+}
 
-        // Check record against scan condition
-        evalExpr(record, schema, scanManager->condition, &result);
+// Helper function to find the next record of a scan that meets its condition and copy it into record. The scan is
+// left at the end of the table when there is none. A page is pinned once and stays pinned across calls until its
+// last slot has been visited.
+RC scanNextMatch(RM_ScanHandle *scan, Record *record) {
+    RecordManager *scanManager = scan->mgmtData;
+    RecordManager *tableManager = scan->rel->mgmtData;
+    RID *recordID = &scanManager->recordID;
+
+    RC status;
+    while ((status = pinScanPage(scanManager, tableManager)) == RC_OK) {
+        // Find the next record of the page in the bitmap, an empty page or the end of the page moves on
+        char *page = scanManager->pageHandle.data;
+        int slot = findUsedSlot(page, recordID->slot);
+        if (slot == -1) {
+            releaseScanPage(scanManager, tableManager);
+            moveScanToNextPage(scanManager);
+            continue;
+        }
+        recordID->slot = slot + 1;
 
-        // If record meets condition, unpin page and return
-        if(result->v.boolV == TRUE) {
-            status = unpinPage(&tableManager->bufferPool, &scanManager->pageHandle);
-            if (status != RC_OK) {
-                printf("Failed to unpin page.\n");
-                return status;
-            }
-            free(result);
+        // A stub is skipped since the record it points to is met where it is stored
+        char *data = getSlotPointer(page, slot);
+        if (*data != FORWARD_MARKER && matchScanRecord(scanManager, scan->rel->schema, data, slot, record)) {
             return RC_OK;
         }
     }
+    return status;
+}
+
+// Helper function to fill a batch from the pinned page of a scan, up to maxRows records. The used slots of the page
+// are taken word by word from its bitmap. The page is released once its last slot has been visited, otherwise the
+// scan stays at the slot after the last record taken.
+void scanPageIntoBatch(RM_ScanHandle *scan, RecordBatch *out, int maxRows) {
+    RecordManager *scanManager = scan->mgmtData;
+    RecordManager *tableManager = scan->rel->mgmtData;
+    RID *recordID = &scanManager->recordID;
+    char *page = scanManager->pageHandle.data;
+    PageHeader *header = (PageHeader *) page;
+    SlotWord *bitmap = getSlotBitmap(page);
+    int numWords = header->liveCount == 0 ? 0 : getSlotWords(header->numSlots);
+
+    for (int w = recordID->slot / SLOT_WORD_BITS; w < numWords; w++) {
+        // Bits below the slot of the scan in its first word were visited before
+        SlotWord word = bitmap[w];
+        if (w == recordID->slot / SLOT_WORD_BITS)
+            word &= ~(SlotWord) 0 << (recordID->slot % SLOT_WORD_BITS);
+
+        for (; word != 0; word &= word - 1) {
+            int slot = w * SLOT_WORD_BITS + __builtin_ctzll(word);
+            char *data = getSlotPointer(page, slot);
+            if (*data == FORWARD_MARKER ||
+                !matchScanRecord(scanManager, scan->rel->schema, data, slot, &out->records[out->numRecords]))
+                continue;
+
+            // A full batch leaves the rest of the page for the next call
+            if (++out->numRecords == maxRows) {
+                recordID->slot = slot + 1;
+                return;
+            }
+        }
+    }
+
+    releaseScanPage(scanManager, tableManager);
+    moveScanToNextPage(scanManager);
+}
 
-    // Reinitialize scan manager
+// Helper function to put a scan that reported its end back to the first page, the next call starts it over
+void rewindScan(RecordManager *scanManager) {
     scanManager->recordID = (RID){ .page = 1, .slot = 0 };
     scanManager->scanCount = 0;
+    scanManager->readaheadPage = 0;
+    skipFreePages(scanManager);
+}
+
+extern RC next (RM_ScanHandle *scan, Record *record) {
+    // Validate input parameters
+    if (scan == NULL || record == NULL) {
+        printf("Invalid parameters.\n");
+        return RC_RM_NULL_ARGUMENT;
+    }
+
+    // Early return if no scan condition
+    RecordManager *scanManager = scan->mgmtData;
+    if (scanManager->condition == NULL) return RC_SCAN_CONDITION_NOT_FOUND;
+
+    // Find the next record, reinitialize scan manager at the end of the table
+    RC status = scanNextMatch(scan, record);
+    if (status == RC_RM_NO_MORE_TUPLES) {
+        rewindScan(scanManager);
+    }
+    return status;
+}
+
+// This function returns up to maxRows records that meet the condition of a scan in a batch, with their RIDs. The
+// records are copies that stay valid until the batch is used again. RC_RM_NO_MORE_TUPLES is returned only by a call
+// that finds no record at all, the call after it starts the scan over like next().
+extern RC nextBatch (RM_ScanHandle *scan, RecordBatch *out, int maxRows) {
+    // Validate input parameters
+    if (scan == NULL || out == NULL || maxRows <= 0) {
+        printf("Invalid parameters.\n");
+        return RC_RM_NULL_ARGUMENT;
+    }
+
+    // Early return if no scan condition
+    RecordManager *scanManager = scan->mgmtData;
+    if (scanManager->condition == NULL) return RC_SCAN_CONDITION_NOT_FOUND;
+
+    // Fill the batch a page at a time, a page the batch ends in stays pinned for the next call
+    if (maxRows > out->capacity) {
+        maxRows = out->capacity;
+    }
+    RC status = RC_OK;
+    out->numRecords = 0;
+    while (out->numRecords < maxRows && (status = pinScanPage(scanManager, scan->rel->mgmtData)) == RC_OK) {
+        scanPageIntoBatch(scan, out, maxRows);
+    }
 
-    // No more tuples
-    return RC_RM_NO_MORE_TUPLES;
+    // The end of the table ends the batch, it is reported once the batch comes back empty
+    if (status == RC_RM_NO_MORE_TUPLES) {
+        if (out->numRecords > 0) {
+            return RC_OK;
+        }
+        rewindScan(scanManager);
+    }
+    return status;
+}
+
+// This function allocates a batch for capacity records of a schema, their data lies in one block
+extern RC createRecordBatch (RecordBatch **batch, Schema *schema, int capacity)
+{
+    if (batch == NULL || schema == NULL || capacity <= 0) {
+        return RC_RM_NULL_ARGUMENT;
+    }
+
+    int recordSize = getRecordSize(schema);
+    *batch = (RecordBatch *) malloc(sizeof(RecordBatch));
+    (*batch)->numRecords = 0;
+    (*batch)->capacity = capacity;
+    (*batch)->records = (Record *) malloc(sizeof(Record) * capacity);
+    (*batch)->data = (char *) calloc(capacity, recordSize);
+    if ((*batch)->records == NULL || (*batch)->data == NULL) {
+        freeRecordBatch(*batch);
+        *batch = NULL;
+        return RC_RM_NO_MORE_MEMORY;
+    }
+
+    for (int i = 0; i < capacity; i++) {
+        (*batch)->records[i].data = (*batch)->data + (size_t) i * recordSize;
+    }
+    return RC_OK;
+}
+
+// This function releases a batch and the data of its records
+extern RC freeRecordBatch (RecordBatch *batch)
+{
+    if (batch != NULL) {
+        free(batch->records);
+        free(batch->data);
+        free(batch);
+    }
+    return RC_OK;
 }
 
 
@@ -581,16 +1909,22 @@ extern RC closeScan (RM_ScanHandle *scan)
 
     // Retrieve the management data
     RecordManager *scanManager = scan->mgmtData;
-    RecordManager *recordManager = scan->rel->mgmtData;
+
+    // Unpin the page a scan that was not run to its end still holds
+    releaseScanPage(scanManager, scan->rel->mgmtData);
 
     // Reset the Scan Manager's state
     scanManager->scanCount = 0;
     scanManager->recordID = (RID){ .page = 1, .slot = 0 };
 
-    // Unpin the page
-    unpinPage(&recordManager->bufferPool, &scanManager->pageHandle);
+    // Close the page file opened for the free map
+    if (scanManager->fileHandle.mgmtInfo != NULL) {
+        closePageFile(&scanManager->fileHandle);
+    }
 
     // De-allocate all the memory space allocated to the scans's meta data
+    freeScanProjection(scanManager);
+    freeCompiledExpr(scanManager->compiledCondition);
     free(scanManager);
     scan->mgmtData = NULL;
 	
@@ -776,9 +2110,8 @@ extern RC getAttr(Record *record, Schema *schema, int attrNum, Value **value)
     // Get a pointer to the location of the attribute in the record's data
     char *dataPointer = record->data + offset;
     
-    // Adjust the dataType for attrNum == 1 and get the corresponding type
-    // If attrNum == 1, type is set to 1, else it is set to the corresponding type from schema
-    DataType type = (attrNum == 1) ? 1 : schema->dataTypes[attrNum];
+    // Get the type of the attribute from the schema
+    DataType type = schema->dataTypes[attrNum];
     
     // Retrieve the attribute value based on its type
     switch(type)
@@ -12,10 +12,21 @@ typedef struct RM_ScanHandle
 	void *mgmtData;
 } RM_ScanHandle;
 
+// Records returned by nextBatch, copies that stay valid until the batch is used again
+typedef struct RecordBatch
+{
+	int numRecords;   // records filled by the last call
+	int capacity;     // records the batch has room for
+	Record *records;  // RID and data of each record
+	char *data;       // one block holding the data of all records
+} RecordBatch;
+
 // table and manager
 extern RC initRecordManager (void *mgmtData);
 extern RC shutdownRecordManager ();
 extern RC createTable (char *name, Schema *schema);
+extern RC createTableWithPageSize (char *name, Schema *schema, int pageSize);
+extern RC createTableWithFlags (char *name, Schema *schema, int pageSize, int flags);
 extern RC openTable (RM_TableData *rel, char *name);
 extern RC closeTable (RM_TableData *rel);
 extern RC deleteTable (char *name);
@@ -23,14 +34,21 @@ extern int getNumTuples (RM_TableData *rel);
 
 // handling records in a table
 extern RC insertRecord (RM_TableData *rel, Record *record);
+extern RC insertRecords (RM_TableData *rel, Record **records, int numRecords);
+extern RC bulkLoadRecords (RM_TableData *rel, Record **records, int numRecords);
 extern RC deleteRecord (RM_TableData *rel, RID id);
 extern RC updateRecord (RM_TableData *rel, Record *record);
 extern RC getRecord (RM_TableData *rel, RID id, Record *record);
 
 // scans
 extern RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond);
+extern RC startScanWithProjection (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond, int *attrs, int numAttrs);
+extern Schema *getScanSchema (RM_ScanHandle *scan);
 extern RC next (RM_ScanHandle *scan, Record *record);
+extern RC nextBatch (RM_ScanHandle *scan, RecordBatch *out, int maxRows);
 extern RC closeScan (RM_ScanHandle *scan);
+extern RC createRecordBatch (RecordBatch **batch, Schema *schema, int capacity);
+extern RC freeRecordBatch (RecordBatch *batch);
 
 // dealing with schemas
 extern int getRecordSize (Schema *schema);
@@ -0,0 +1,253 @@
+#include<stdlib.h>
+#include<string.h>
+#include<unistd.h>
+#include<fcntl.h>
+#include<sys/stat.h>
+#include "storage_backend.h"
+
+/************************************************************
+ *                    file backend                          *
+ ************************************************************/
+
+// Device of the file backend
+typedef struct FileDevice {
+  int fd;
+} FileDevice;
+
+// Wraps an open file descriptor into a device
+static RC wrapDescriptor(int fd, void **device) {
+  if (fd < 0)
+    return RC_FILE_NOT_FOUND;
+
+  FileDevice *file = malloc(sizeof(FileDevice));
+  file->fd = fd;
+  *device = file;
+  return RC_OK;
+}
+
+static RC fileCreate(char *fileName, void **device) {
+  return wrapDescriptor(open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644), device);
+}
+
+static RC fileOpen(char *fileName, void **device) {
+  return wrapDescriptor(open(fileName, O_RDWR), device);
+}
+
+static bool fileExists(char *fileName) {
+  return access(fileName, F_OK) == 0;
+}
+
+// Reads length bytes, short reads are continued until the range is complete or the file ends
+static RC fileRead(void *device, long offset, void *data, long length) {
+  int fd = ((FileDevice *) device)->fd;
+  char *target = data;
+
+  while (length > 0) {
+    ssize_t done = pread(fd, target, length, offset);
+    if (done <= 0)
+      return RC_READ_ERROR;
+    target += done;
+    offset += done;
+    length -= done;
+  }
+  return RC_OK;
+}
+
+static RC fileWrite(void *device, long offset, const void *data, long length) {
+  int fd = ((FileDevice *) device)->fd;
+  const char *source = data;
+
+  while (length > 0) {
+    ssize_t done = pwrite(fd, source, length, offset);
+    if (done <= 0)
+      return RC_WRITE_FAILED;
+    source += done;
+    offset += done;
+    length -= done;
+  }
+  return RC_OK;
+}
+
+static RC fileResize(void *device, long size) {
+  return ftruncate(((FileDevice *) device)->fd, size) == 0 ? RC_OK : RC_WRITE_FAILED;
+}
+
+static long fileSize(void *device) {
+  struct stat status;
+  if (fstat(((FileDevice *) device)->fd, &status) != 0)
+    return -1;
+  return status.st_size;
+}
+
+static RC fileSync(void *device) {
+  return fsync(((FileDevice *) device)->fd) == 0 ? RC_OK : RC_WRITE_FAILED;
+}
+
+static RC fileClose(void *device) {
+  int result = close(((FileDevice *) device)->fd);
+  free(device);
+  return result == 0 ? RC_OK : RC_WRITE_FAILED;
+}
+
+static RC fileDestroy(char *fileName) {
+  return remove(fileName) == 0 ? RC_OK : RC_FILE_NOT_FOUND;
+}
+
+static int fileDescriptor(void *device) {
+  return ((FileDevice *) device)->fd;
+}
+
+const SM_Backend fileBackend = {
+  "file", fileCreate, fileOpen, fileExists, fileRead, fileWrite, fileResize,
+  fileSize, fileSync, fileClose, fileDestroy, fileDescriptor
+};
+
+/************************************************************
+ *                    memory backend                        *
+ ************************************************************/
+
+// Device of the memory backend, a growable byte array registered under the name of the file.
+// A destroyed file leaves the registry right away and its memory goes when the last handle closes it.
+typedef struct MemoryDevice {
+  char *name;
+  char *data;
+  long size;
+  long capacity;
+  int openCount;
+  bool removed;
+  struct MemoryDevice *next;
+} MemoryDevice;
+
+// Files of the memory backend
+static MemoryDevice *memoryFiles = NULL;
+
+// Returns the registered file of a name, NULL if there is none
+static MemoryDevice *findMemoryFile(char *fileName) {
+  for (MemoryDevice *file = memoryFiles; file != NULL; file = file->next) {
+    if (strcmp(file->name, fileName) == 0)
+      return file;
+  }
+  return NULL;
+}
+
+// Releases a file that is neither registered nor open
+static void releaseMemoryFile(MemoryDevice *file) {
+  if (file->removed && file->openCount == 0) {
+    free(file->name);
+    free(file->data);
+    free(file);
+  }
+}
+
+static RC memoryDestroy(char *fileName) {
+  MemoryDevice **link = &memoryFiles;
+  while (*link != NULL && strcmp((*link)->name, fileName) != 0)
+    link = &(*link)->next;
+  if (*link == NULL)
+    return RC_FILE_NOT_FOUND;
+
+  MemoryDevice *file = *link;
+  *link = file->next;
+  file->removed = TRUE;
+  releaseMemoryFile(file);
+  return RC_OK;
+}
+
+static RC memoryCreate(char *fileName, void **device) {
+  memoryDestroy(fileName);
+
+  MemoryDevice *file = calloc(1, sizeof(MemoryDevice));
+  file->name = strdup(fileName);
+  file->openCount = 1;
+  file->next = memoryFiles;
+  memoryFiles = file;
+
+  *device = file;
+  return RC_OK;
+}
+
+static RC memoryOpen(char *fileName, void **device) {
+  MemoryDevice *file = findMemoryFile(fileName);
+  if (file == NULL)
+    return RC_FILE_NOT_FOUND;
+
+  file->openCount++;
+  *device = file;
+  return RC_OK;
+}
+
+static bool memoryExists(char *fileName) {
+  return findMemoryFile(fileName) != NULL;
+}
+
+static RC memoryRead(void *device, long offset, void *data, long length) {
+  MemoryDevice *file = device;
+  if (offset < 0 || offset + length > file->size)
+    return RC_READ_ERROR;
+
+  memcpy(data, file->data + offset, length);
+  return RC_OK;
+}
+
+// Sets the size of a file, the capacity doubles so appending pages one by one stays cheap
+static RC memoryResize(void *device, long size) {
+  MemoryDevice *file = device;
+  if (size < 0)
+    return RC_WRITE_FAILED;
+
+  if (size > file->capacity) {
+    long capacity = file->capacity > 0 ? file->capacity : 4096;
+    while (capacity < size)
+      capacity *= 2;
+
+    char *data = realloc(file->data, capacity);
+    if (data == NULL)
+      return RC_WRITE_FAILED;
+    file->data = data;
+    file->capacity = capacity;
+  }
+
+  if (size > file->size)
+    memset(file->data + file->size, 0, size - file->size);
+  file->size = size;
+  return RC_OK;
+}
+
+static RC memoryWrite(void *device, long offset, const void *data, long length) {
+  MemoryDevice *file = device;
+  if (offset < 0)
+    return RC_WRITE_FAILED;
+
+  if (offset + length > file->size) {
+    RC result = memoryResize(file, offset + length);
+    if (result != RC_OK)
+      return result;
+  }
+
+  memcpy(file->data + offset, data, length);
+  return RC_OK;
+}
+
+static long memorySize(void *device) {
+  return ((MemoryDevice *) device)->size;
+}
+
+static RC memorySync(void *device) {
+  return RC_OK;
+}
+
+static RC memoryClose(void *device) {
+  MemoryDevice *file = device;
+  file->openCount--;
+  releaseMemoryFile(file);
+  return RC_OK;
+}
+
+static int memoryDescriptor(void *device) {
+  return -1;
+}
+
+const SM_Backend memoryBackend = {
+  "memory", memoryCreate, memoryOpen, memoryExists, memoryRead, memoryWrite, memoryResize,
+  memorySize, memorySync, memoryClose, memoryDestroy, memoryDescriptor
+};
@@ -0,0 +1,38 @@
+#ifndef STORAGE_BACKEND_H
+#define STORAGE_BACKEND_H
+
+#include "dberror.h"
+#include "dt.h"
+
+/************************************************************
+ *                    backend interface                     *
+ ************************************************************/
+/* A backend keeps the bytes of page files. The storage manager lays out
+ * header, free map and pages on top of it and only talks to the device of
+ * an open file through these functions. Offsets and lengths are in bytes,
+ * a read past the end of the device fails, a write past it grows the device. */
+typedef struct SM_Backend {
+	char *name;
+	RC (*create) (char *fileName, void **device);   /* new empty device, replaces one of the same name */
+	RC (*open) (char *fileName, void **device);
+	bool (*exists) (char *fileName);
+	RC (*read) (void *device, long offset, void *data, long length);
+	RC (*write) (void *device, long offset, const void *data, long length);
+	RC (*resize) (void *device, long size);         /* extends with zeros or cuts off the tail */
+	long (*size) (void *device);
+	RC (*sync) (void *device);
+	RC (*close) (void *device);
+	RC (*destroy) (char *fileName);
+	int (*descriptor) (void *device);               /* file descriptor for aio and posix_fadvise, -1 if none */
+} SM_Backend;
+
+/************************************************************
+ *                    built-in backends                     *
+ ************************************************************/
+/* files on disc, read and written with pread and pwrite */
+extern const SM_Backend fileBackend;
+
+/* files kept in the memory of the process, they are gone when it exits */
+extern const SM_Backend memoryBackend;
+
+#endif
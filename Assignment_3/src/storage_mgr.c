@@ -1,45 +1,599 @@
 #include<stdio.h>
 #include<stdlib.h>
 #include "storage_mgr.h"
+#include "lz_codec.h"
 #include<string.h>
+#include<errno.h>
+#include<aio.h>
+#include<unistd.h>
+#include<fcntl.h>
+#include<limits.h>
+
+// Page files start with a header region: one header page followed by the pages of the free-page map.
+// All pages of a file have the page size stored in its header, data page n lives at offset
+// (headerPages + n) * pageSize. Once the map pages of the header region are used up, plain files of
+// version 2 put a further map page in front of every 8 * pageSize data pages, which moves the later
+// data pages back by one page each time.
+// Compressed files also have a page-mapping table in the header region, one SM_PageExtent per data page.
+// Pages are compressed with the LZ codec into extents of whole SM_EXTENT_UNITs stored after the header region.
+// When a compressed file outgrows its table or its free map, the table or the map moves to a run of units
+// twice its size in the extent area.
+#define SM_FILE_MAGIC 0x46504D53
+#define SM_FILE_VERSION 2
+
+// Number of free-map pages of a new file, a map page holds one bit for each of 8 * pageSize data pages.
+#define SM_FREE_MAP_PAGES 1
+
+// Pages of the page-mapping table of a compressed file, enough for every page the free map covers.
+#define SM_TABLE_PAGES (SM_FREE_MAP_PAGES * 8 * (int) sizeof(SM_PageExtent))
+
+// Allocation unit of compressed extents in bytes
+#define SM_EXTENT_UNIT 256
+
+// Layout of the header page
+typedef struct SM_FileHeader {
+  int magic;
+  int version;
+  int headerPages;
+  int mapPages;
+  int pageSize;          // 0 in files written before the page size was stored, which use PAGE_SIZE
+  int flags;             // SM_COMPRESSED
+  int numPages;          // data pages of a compressed file, its size does not tell
+  int tablePages;        // pages of the page-mapping table, 0 for uncompressed files
+  int tableUnit;         // first unit of the table once it moved to the extent area
+  int tableUnits;        // units of the moved table, 0 while the table is in the header region
+  int mapUnit;           // first unit of the free map once it moved to the extent area
+  int mapUnits;          // units of the moved map, 0 while the map is in the header region
+} SM_FileHeader;
+
+// Entry of the page-mapping table: where the compressed page is stored
+typedef struct SM_PageExtent {
+  int unit;              // first SM_EXTENT_UNIT of the extent, counted from the end of the header region
+  int length;            // compressed bytes, 0 for a page of zeros, pageSize for a page stored uncompressed
+} SM_PageExtent;
+
+// Run of unused units between the extents of a compressed file
+typedef struct SM_ExtentHole {
+  int unit;
+  int units;
+} SM_ExtentHole;
+
+// State kept in mgmtInfo of an open page file
+typedef struct SM_FileInfo {
+  const SM_Backend *backend;
+  void *device;           // device of the open file in its backend
+  int version;
+  int headerPages;       // 0 for files written before the header existed
+  int mapPages;           // map pages in the header region
+  unsigned char *freeMap; // bit n is set while data page n is free, NULL until a map page is read
+  bool *mapLoaded;        // map pages read from the file, they are read the first time they are needed
+  int mapSlots;           // map pages allocated for freeMap and mapLoaded
+  bool compressed;
+  int tablePages;
+  int tableUnit;          // table and map moved to the extent area of a compressed file, units 0 if not
+  int tableUnits;
+  int mapUnit;
+  int mapUnits;
+  SM_PageExtent *extents; // page-mapping table of a compressed file
+  int extentSlots;        // entries allocated for extents
+  bool *tableLoaded;      // pages of the table read from the file, a page is read the first time an entry on it is needed
+  bool holesLoaded;       // FALSE until the first extent is reserved or given back, which needs the whole table
+  int extentEnd;          // first unit after the last extent
+  SM_ExtentHole *holes;   // unused runs before extentEnd, sorted by unit
+  int numHoles;
+  int holeSlots;
+  char *buffer;           // LZ_MAX_COMPRESSED_SIZE(pageSize) bytes for compressing and reading extents
+} SM_FileInfo;
+
+// Largest number of backends openPageFile looks a file up in
+#define SM_MAX_BACKENDS 8
+
+// Backends in lookup order, registered backends are put in front of the built-in ones
+static const SM_Backend *backends[SM_MAX_BACKENDS] = { &memoryBackend, &fileBackend };
+static int numBackends = 2;
+
+// Returns the first backend that holds a file of the name, NULL if none does
+static const SM_Backend *findBackend(char *fileName) {
+  for (int i = 0; i < numBackends; i++) {
+    if (backends[i]->exists(fileName))
+      return backends[i];
+  }
+  return NULL;
+}
+
+// Reads bytes of an open page file from its backend
+static RC readBytes(SM_FileHandle *fHandle, long offset, void *data, long length) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  return info->backend->read(info->device, offset, data, length);
+}
+
+// Writes bytes of an open page file to its backend
+static RC writeBytes(SM_FileHandle *fHandle, long offset, const void *data, long length) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  return info->backend->write(info->device, offset, data, length);
+}
+
+// Sets the size of an open page file in its backend
+static RC resizeFile(SM_FileHandle *fHandle, long size) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  return info->backend->resize(info->device, size);
+}
+
+// Returns the file offset of a unit of the extent area of a compressed file
+static long extentOffset(SM_FileHandle *fHandle, int unit) {
+  return (long) ((SM_FileInfo *) fHandle->mgmtInfo)->headerPages * fHandle->pageSize + (long) unit * SM_EXTENT_UNIT;
+}
+
+// Returns the number of data pages one page of the free map covers
+static int mapPageSpan(SM_FileHandle *fHandle) {
+  return fHandle->pageSize * 8;
+}
+
+// Returns TRUE if the free map of a file grows with the file by map pages chained between its data pages
+static bool isMapChained(SM_FileHandle *fHandle) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  return !info->compressed && info->version >= 2 && info->mapPages > 0;
+}
+
+// Returns the number of map pages chained between the header region and a data page
+static int chainedMapPages(SM_FileHandle *fHandle, int pageNum) {
+  int group = pageNum / mapPageSpan(fHandle);
+  int mapPages = ((SM_FileInfo *) fHandle->mgmtInfo)->mapPages;
+  return (!isMapChained(fHandle) || group < mapPages) ? 0 : group - mapPages + 1;
+}
+
+// Returns the file offset of a data page
+static long pageOffset(SM_FileHandle *fHandle, int pageNum) {
+  long page = (long) ((SM_FileInfo *) fHandle->mgmtInfo)->headerPages + pageNum + chainedMapPages(fHandle, pageNum);
+  return page * fHandle->pageSize;
+}
+
+// Returns the file offset of page m of the free map, a chained map page comes right before the first page it covers
+static long mapPageOffset(SM_FileHandle *fHandle, int m) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  if (info->mapUnits > 0)
+    return extentOffset(fHandle, info->mapUnit) + (long) m * fHandle->pageSize;
+  if (m < info->mapPages)
+    return (long) (1 + m) * fHandle->pageSize;
+  return pageOffset(fHandle, m * mapPageSpan(fHandle)) - fHandle->pageSize;
+}
+
+// Returns the number of pages of the free map of a file that are not chained between its data pages
+static int mapPageCount(SM_FileHandle *fHandle) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  if (info->mapUnits > 0)
+    return info->mapUnits * SM_EXTENT_UNIT / fHandle->pageSize;
+  return info->mapPages;
+}
+
+// Returns the number of data pages the free map of a file covers
+static int mapCapacity(SM_FileHandle *fHandle) {
+  if (isMapChained(fHandle))
+    return INT_MAX;
+  return mapPageCount(fHandle) * mapPageSpan(fHandle);
+}
+
+// Returns the number of data pages of a plain file of size bytes, chained map pages are not counted
+static int plainPageCount(SM_FileHandle *fHandle, long size) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  long pages = size / fHandle->pageSize - info->headerPages;
+  long span = mapPageSpan(fHandle);
+  long head = info->mapPages * span;
+  if (!isMapChained(fHandle) || pages <= head)
+    return (int) pages;
+
+  // Every further group is a map page followed by up to span data pages
+  long rest = pages - head;
+  long partial = rest % (span + 1);
+  return (int) (head + rest / (span + 1) * span + (partial > 0 ? partial - 1 : 0));
+}
+
+// Returns the number of pages of a run that lie next to each other in the file, a chained map page ends the run
+static int contiguousPages(SM_FileHandle *fHandle, int pageNum, int numPages) {
+  if (!isMapChained(fHandle))
+    return numPages;
+
+  int group = pageNum / mapPageSpan(fHandle) + 1;
+  int mapPages = ((SM_FileInfo *) fHandle->mgmtInfo)->mapPages;
+  int stop = (group > mapPages ? group : mapPages) * mapPageSpan(fHandle);
+  return pageNum + numPages <= stop ? numPages : stop - pageNum;
+}
+
+// Returns the file size of a plain file with numPages data pages
+static long plainFileSize(SM_FileHandle *fHandle, int numPages) {
+  if (numPages == 0)
+    return (long) ((SM_FileInfo *) fHandle->mgmtInfo)->headerPages * fHandle->pageSize;
+  return pageOffset(fHandle, numPages - 1) + fHandle->pageSize;
+}
+
+// Returns TRUE for the page sizes a page file may use: powers of two from PAGE_SIZE to SM_MAX_PAGE_SIZE
+bool isValidPageSize(int pageSize) {
+  return pageSize >= PAGE_SIZE && pageSize <= SM_MAX_PAGE_SIZE && (pageSize & (pageSize - 1)) == 0;
+}
+
+// Returns TRUE if the pages of an open file are stored compressed
+static bool isCompressed(SM_FileHandle *fHandle) {
+  return ((SM_FileInfo *) fHandle->mgmtInfo)->compressed;
+}
+
+// Returns the number of data pages the page-mapping table of a compressed file covers
+static int tableCapacity(SM_FileHandle *fHandle) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  if (info->tableUnits > 0)
+    return info->tableUnits * (SM_EXTENT_UNIT / (int) sizeof(SM_PageExtent));
+  return info->tablePages * (fHandle->pageSize / (int) sizeof(SM_PageExtent));
+}
+
+// Returns the file offset of the page-mapping table of a compressed file
+static long tableOffset(SM_FileHandle *fHandle) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  if (info->tableUnits > 0)
+    return extentOffset(fHandle, info->tableUnit);
+  return (long) (1 + info->mapPages) * fHandle->pageSize;
+}
+
+// Returns the number of units an extent of length bytes occupies
+static int extentUnits(int length) {
+  return (length + SM_EXTENT_UNIT - 1) / SM_EXTENT_UNIT;
+}
 
+// Returns TRUE if all bytes of a page are zero
+static bool isZeroPage(const char *data, int pageSize) {
+  return data[0] == 0 && memcmp(data, data + 1, pageSize - 1) == 0;
+}
+
+// Inserts a hole at position pos of the sorted hole list
+static void insertHole(SM_FileInfo *info, int pos, int unit, int units) {
+  if (info->numHoles == info->holeSlots) {
+    info->holeSlots = info->holeSlots == 0 ? 16 : 2 * info->holeSlots;
+    info->holes = realloc(info->holes, info->holeSlots * sizeof(SM_ExtentHole));
+  }
+  memmove(&info->holes[pos + 1], &info->holes[pos], (info->numHoles - pos) * sizeof(SM_ExtentHole));
+  info->holes[pos].unit = unit;
+  info->holes[pos].units = units;
+  info->numHoles++;
+}
+
+// Removes the hole at position pos
+static void removeHole(SM_FileInfo *info, int pos) {
+  memmove(&info->holes[pos], &info->holes[pos + 1], (info->numHoles - pos - 1) * sizeof(SM_ExtentHole));
+  info->numHoles--;
+}
+
+// Returns the table entry of a page of a compressed file. The table page it is on is read the first time
+// one of its entries is needed, so opening a file does not read the whole table. NULL if it cannot be read.
+static SM_PageExtent *pageExtent(SM_FileHandle *fHandle, int pageNum) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  int perPage = fHandle->pageSize / (int) sizeof(SM_PageExtent);
+  int tablePage = pageNum / perPage;
+
+  if (!info->tableLoaded[tablePage]) {
+    int first = tablePage * perPage;
+    int count = fHandle->totalNumPages - first < perPage ? fHandle->totalNumPages - first : perPage;
+    if (count > 0 && readBytes(fHandle, tableOffset(fHandle) + (long) first * sizeof(SM_PageExtent),
+                               &info->extents[first], (long) count * sizeof(SM_PageExtent)) != RC_OK)
+      return NULL;
+    info->tableLoaded[tablePage] = TRUE;
+  }
+  return &info->extents[pageNum];
+}
+
+// Orders extents by their position in the file
+static int compareExtents(const void *left, const void *right) {
+  return ((const SM_ExtentHole *) left)->unit - ((const SM_ExtentHole *) right)->unit;
+}
+
+// Reads the whole page-mapping table of a compressed file and rebuilds the holes between its extents.
+// Done the first time units are reserved or given back, reads and rewrites in place do not need the holes.
+static RC loadHoles(SM_FileHandle *fHandle) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  int numPages = fHandle->totalNumPages;
+  if (info->holesLoaded)
+    return RC_OK;
+
+  for (int i = 0; i < numPages; i += fHandle->pageSize / (int) sizeof(SM_PageExtent)) {
+    if (pageExtent(fHandle, i) == NULL)
+      return RC_READ_ERROR;
+  }
+
+  // Units not covered by any extent, the moved table or the moved map are holes
+  SM_ExtentHole *used = malloc((numPages + 2) * sizeof(SM_ExtentHole));
+  int numUsed = 0;
+  if (info->tableUnits > 0) {
+    used[numUsed].unit = info->tableUnit;
+    used[numUsed++].units = info->tableUnits;
+  }
+  if (info->mapUnits > 0) {
+    used[numUsed].unit = info->mapUnit;
+    used[numUsed++].units = info->mapUnits;
+  }
+  for (int i = 0; i < numPages; i++) {
+    if (info->extents[i].length > 0) {
+      used[numUsed].unit = info->extents[i].unit;
+      used[numUsed++].units = extentUnits(info->extents[i].length);
+    }
+  }
+  qsort(used, numUsed, sizeof(SM_ExtentHole), compareExtents);
+
+  int end = 0;
+  for (int i = 0; i < numUsed; i++) {
+    if (used[i].unit > end)
+      insertHole(info, info->numHoles, end, used[i].unit - end);
+    if (used[i].unit + used[i].units > end)
+      end = used[i].unit + used[i].units;
+  }
+  info->extentEnd = end;
+  info->holesLoaded = TRUE;
 
-FILE *page;
+  free(used);
+  return RC_OK;
+}
+
+// Gives units of a compressed file back, merging them with neighbouring holes.
+// Units at the end of the extent area are cut off the file.
+static RC releaseExtent(SM_FileHandle *fHandle, int unit, int units) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  if (units <= 0)
+    return RC_OK;
+  if (loadHoles(fHandle) != RC_OK)
+    return RC_READ_ERROR;
+
+  if (unit + units == info->extentEnd) {
+    info->extentEnd = unit;
+    if (info->numHoles > 0 && info->holes[info->numHoles - 1].unit + info->holes[info->numHoles - 1].units == unit) {
+      info->extentEnd = info->holes[info->numHoles - 1].unit;
+      removeHole(info, info->numHoles - 1);
+    }
+
+    return resizeFile(fHandle, extentOffset(fHandle, info->extentEnd));
+  }
+
+  int pos = 0;
+  while (pos < info->numHoles && info->holes[pos].unit < unit)
+    pos++;
+
+  bool joinsPrevious = pos > 0 && info->holes[pos - 1].unit + info->holes[pos - 1].units == unit;
+  bool joinsNext = pos < info->numHoles && unit + units == info->holes[pos].unit;
+
+  if (joinsPrevious && joinsNext) {
+    info->holes[pos - 1].units += units + info->holes[pos].units;
+    removeHole(info, pos);
+  }
+  else if (joinsPrevious) {
+    info->holes[pos - 1].units += units;
+  }
+  else if (joinsNext) {
+    info->holes[pos].unit = unit;
+    info->holes[pos].units += units;
+  }
+  else {
+    insertHole(info, pos, unit, units);
+  }
+  return RC_OK;
+}
+
+// Sets unit to the first unit of a run of units, taken from the first hole that is large enough or
+// from the end of the extent area
+static RC reserveExtent(SM_FileHandle *fHandle, int units, int *unit) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  if (loadHoles(fHandle) != RC_OK)
+    return RC_READ_ERROR;
+
+  for (int i = 0; i < info->numHoles; i++) {
+    if (info->holes[i].units >= units) {
+      *unit = info->holes[i].unit;
+      info->holes[i].unit += units;
+      info->holes[i].units -= units;
+      if (info->holes[i].units == 0)
+        removeHole(info, i);
+      return RC_OK;
+    }
+  }
+
+  *unit = info->extentEnd;
+  info->extentEnd += units;
+  return RC_OK;
+}
+
+// Writes the page-mapping table entry of a page
+static RC writeExtentEntry(SM_FileHandle *fHandle, int pageNum) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+
+  long offset = tableOffset(fHandle) + (long) pageNum * sizeof(SM_PageExtent);
+  return writeBytes(fHandle, offset, &info->extents[pageNum], sizeof(SM_PageExtent));
+}
+
+// Writes the header page of a compressed file, whose number of pages or table or map changed
+static RC writeFileHeader(SM_FileHandle *fHandle) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  SM_FileHeader header = { SM_FILE_MAGIC, info->version, info->headerPages, info->mapPages, fHandle->pageSize };
+  header.flags = info->compressed ? SM_COMPRESSED : 0;
+  header.numPages = fHandle->totalNumPages;
+  header.tablePages = info->tablePages;
+  header.tableUnit = info->tableUnit;
+  header.tableUnits = info->tableUnits;
+  header.mapUnit = info->mapUnit;
+  header.mapUnits = info->mapUnits;
+
+  return writeBytes(fHandle, 0L, &header, sizeof(SM_FileHeader));
+}
+
+// Makes room for numPages entries of the page-mapping table in memory
+static void growExtents(SM_FileHandle *fHandle, int numPages) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  int perPage = fHandle->pageSize / (int) sizeof(SM_PageExtent);
+  if (numPages <= info->extentSlots)
+    return;
+
+  int slots = info->extentSlots;
+  while (slots < numPages)
+    slots *= 2;
+
+  info->extents = realloc(info->extents, slots * sizeof(SM_PageExtent));
+  memset(&info->extents[info->extentSlots], 0, (slots - info->extentSlots) * sizeof(SM_PageExtent));
+  info->tableLoaded = realloc(info->tableLoaded, (slots / perPage + 1) * sizeof(bool));
+  memset(&info->tableLoaded[info->extentSlots / perPage + 1], 0, (slots / perPage - info->extentSlots / perPage) * sizeof(bool));
+  info->extentSlots = slots;
+}
+
+// Allocates the page-mapping table of a compressed file in memory, its entries are read when they are needed
+static void initExtents(SM_FileHandle *fHandle, int numPages) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  int perPage = fHandle->pageSize / (int) sizeof(SM_PageExtent);
+
+  info->extentSlots = numPages > perPage ? numPages : perPage;
+  info->extents = calloc(info->extentSlots, sizeof(SM_PageExtent));
+  info->tableLoaded = calloc(info->extentSlots / perPage + 1, sizeof(bool));
+  info->buffer = malloc(LZ_MAX_COMPRESSED_SIZE(fHandle->pageSize));
+}
+
+// Reads and decompresses a page of a compressed file
+static RC readCompressedBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  SM_PageExtent *extent = pageExtent(fHandle, pageNum);
+  if (extent == NULL)
+    return RC_READ_ERROR;
+
+  if (extent->length == 0) {
+    memset(memPage, 0, fHandle->pageSize);
+    return RC_OK;
+  }
+
+  // Pages that did not shrink are stored as they are
+  char *target = (extent->length == fHandle->pageSize) ? memPage : info->buffer;
+  if (readBytes(fHandle, extentOffset(fHandle, extent->unit), target, extent->length) != RC_OK)
+    return RC_READ_ERROR;
+
+  if (target == info->buffer && lzDecompress(info->buffer, extent->length, memPage, fHandle->pageSize) != fHandle->pageSize)
+    return RC_READ_ERROR;
+
+  return RC_OK;
+}
+
+// Compresses a page of a compressed file into its extent. An extent that is large enough is rewritten
+// in place and gives back its unused tail, otherwise the page moves to a new extent.
+static RC writeCompressedBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  SM_PageExtent *extent = pageExtent(fHandle, pageNum);
+  int pageSize = fHandle->pageSize;
+  if (extent == NULL)
+    return RC_READ_ERROR;
+
+  // Pages of zeros need no extent, pages that do not shrink are stored uncompressed
+  char *data = info->buffer;
+  int length = 0;
+  if (!isZeroPage(memPage, pageSize)) {
+    length = lzCompress(memPage, pageSize, info->buffer, LZ_MAX_COMPRESSED_SIZE(pageSize));
+    if (length < 0 || length >= pageSize) {
+      length = pageSize;
+      data = memPage;
+    }
+  }
+
+  int units = extentUnits(length);
+  int oldUnits = extentUnits(extent->length);
+  RC result;
+
+  if (units <= oldUnits) {
+    result = releaseExtent(fHandle, extent->unit + units, oldUnits - units);
+  }
+  else {
+    result = releaseExtent(fHandle, extent->unit, oldUnits);
+    if (result == RC_OK)
+      result = reserveExtent(fHandle, units, &extent->unit);
+  }
+  if (result != RC_OK)
+    return result;
+
+  if (units == 0)
+    extent->unit = 0;
+  extent->length = length;
+
+  if (length > 0 && (result = writeBytes(fHandle, extentOffset(fHandle, extent->unit), data, length)) != RC_OK)
+    return result;
+
+  return writeExtentEntry(fHandle, pageNum);
+}
 
 //initializing page handler 
 extern void initStorageManager (void){
-	page = NULL;
 }
 
 
 RC createPageFile(char *fileName) {
+    return createPageFileWithFlags(fileName, PAGE_SIZE, 0);
+}
+
+
+RC createPageFileWithSize(char *fileName, int pageSize) {
+    return createPageFileWithFlags(fileName, pageSize, 0);
+}
+
+
+RC createCompressedPageFile(char *fileName, int pageSize) {
+    return createPageFileWithFlags(fileName, pageSize, SM_COMPRESSED);
+}
+
+
+RC createPageFileWithFlags(char *fileName, int pageSize, int flags) {
+    return createPageFileOnBackend(fileName, pageSize, flags, (flags & SM_IN_MEMORY) ? &memoryBackend : &fileBackend);
+}
 
-	// opening the file in write binary mode
-    FILE *file = fopen(fileName, "wb");
-    if (file == NULL) {
+
+RC createPageFileOnBackend(char *fileName, int pageSize, int flags, const SM_Backend *backend) {
+
+    if (!isValidPageSize(pageSize) || (flags & ~(SM_COMPRESSED | SM_IN_MEMORY)) != 0 || backend == NULL) {
+        return RC_INVALID_PARAMETER;
+    }
+
+	// a file of the same name in another backend would hide the new one or be hidden by it, it has to be destroyed first
+    for (int i = 0; i < numBackends; i++) {
+        if (backends[i] != backend && backends[i]->exists(fileName)) {
+            return RC_FILE_ALREADY_EXISTS;
+        }
+    }
+
+	// creating the empty file in the backend
+    void *device;
+    if (backend->create(fileName, &device) != RC_OK) {
         return RC_FILE_NOT_FOUND;
     }
 	
 	// initialising buffer
-    size_t writeSize = 0;
-    char buffer[PAGE_SIZE];
-    memset(buffer, 0, PAGE_SIZE);
+    char *buffer = calloc(pageSize, sizeof(char));
+
+	// header page, empty free-map pages and the first data page
+    SM_FileHeader header = { SM_FILE_MAGIC, SM_FILE_VERSION, 1 + SM_FREE_MAP_PAGES, SM_FREE_MAP_PAGES, pageSize };
+    header.flags = flags & SM_COMPRESSED;
+    header.numPages = 1;
+    if (flags & SM_COMPRESSED) {
+        header.tablePages = SM_TABLE_PAGES;
+        header.headerPages += header.tablePages;
+    }
+    memcpy(buffer, &header, sizeof(SM_FileHeader));
+
+	// a compressed file only needs its header page, the empty table and the empty first page are a hole
+    if (flags & SM_COMPRESSED) {
+        RC result = backend->write(device, 0L, buffer, pageSize);
+        if (result == RC_OK)
+            result = backend->resize(device, (long) header.headerPages * pageSize);
+        free(buffer);
+        backend->close(device);
+        return result;
+    }
 
 	// writing data from buffer to file
-    while (writeSize < PAGE_SIZE) {
-        size_t bytesWritten = fwrite(buffer, sizeof(char), PAGE_SIZE - writeSize, file);
-        if (bytesWritten == 0) {
-            break;
+    for (int i = 0; i < header.headerPages + 1; i++) {
+        if (backend->write(device, (long) i * pageSize, buffer, pageSize) != RC_OK) {
+            free(buffer);
+            backend->close(device);
+            return RC_WRITE_FAILED;
         }
-        writeSize += bytesWritten;
-    }
-
-	// check if written bytes are less than page size
-    if (writeSize < PAGE_SIZE) {
-        return RC_WRITE_FAILED;
+        memset(buffer, 0, sizeof(SM_FileHeader));
     }
 
-    fclose(file);
+    free(buffer);
+    backend->close(device);
     return RC_OK;
 }
 
@@ -50,23 +604,61 @@ RC openPageFile(char *fileName, SM_FileHandle *fHandle) {
   fHandle->fileName = fileName;
   fHandle->totalNumPages = 0;
   fHandle->curPagePos = 0;
+  fHandle->pageSize = PAGE_SIZE;
   fHandle->mgmtInfo = NULL;
 
-  // Opening the file in read binary mode
-  FILE* file = fopen(fileName, "rb+");
-  if(!file) {
+  // Opening the file in the backend that holds it
+  const SM_Backend *backend = findBackend(fileName);
+  void *device;
+  if (backend == NULL || backend->open(fileName, &device) != RC_OK) {
     return RC_FILE_NOT_FOUND;
   }
 
-  // Storing the file in file handle
-  fHandle->mgmtInfo = file;
+  SM_FileInfo *info = calloc(1, sizeof(SM_FileInfo));
+  info->backend = backend;
+  info->device = device;
 
   // Getting the file size
-  fseek(file, 0L, SEEK_END);
-  long size = ftell(file);
+  long size = backend->size(device);
+
+  // Reading the header, files without one have no header region, no free map and pages of PAGE_SIZE
+  SM_FileHeader header;
+  bool hasHeader = backend->read(device, 0L, &header, sizeof(SM_FileHeader)) == RC_OK && header.magic == SM_FILE_MAGIC;
+  if (hasHeader && header.pageSize == 0)
+    header.pageSize = PAGE_SIZE;
+
+  if (hasHeader && isValidPageSize(header.pageSize) &&
+      header.mapPages >= 0 && header.tablePages >= 0 && header.headerPages == 1 + header.mapPages + header.tablePages &&
+      size >= (long) header.headerPages * header.pageSize) {
+    fHandle->pageSize = header.pageSize;
+    info->version = header.version;
+    info->headerPages = header.headerPages;
+    info->mapPages = header.mapPages;
+    info->compressed = (header.flags & SM_COMPRESSED) != 0;
+    info->tablePages = header.tablePages;
+    if (info->compressed && header.version >= 2) {
+      info->tableUnit = header.tableUnit;
+      info->tableUnits = header.tableUnits;
+      info->mapUnit = header.mapUnit;
+      info->mapUnits = header.mapUnits;
+    }
+  }
+
+  // Storing the file in file handle
+  fHandle->mgmtInfo = info;
 
-  // Calculating total no. of pages
-  fHandle->totalNumPages = size / PAGE_SIZE;
+  // Calculating total no. of pages, a compressed file keeps the number in its header
+  if (info->compressed) {
+    if (header.numPages < 0 || header.numPages > tableCapacity(fHandle)) {
+      closePageFile(fHandle);
+      return RC_READ_ERROR;
+    }
+    initExtents(fHandle, header.numPages);
+    fHandle->totalNumPages = header.numPages;
+  }
+  else {
+    fHandle->totalNumPages = plainPageCount(fHandle, size);
+  }
 
   return RC_OK;
 
@@ -79,8 +671,17 @@ RC closePageFile(SM_FileHandle *fHandle) {
     return RC_FILE_HANDLE_NOT_INIT;
 
   // Closing file
-  FILE* file = fHandle->mgmtInfo;
-  fclose(file);
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  if (info) {
+    info->backend->close(info->device);
+    free(info->freeMap);
+    free(info->mapLoaded);
+    free(info->extents);
+    free(info->tableLoaded);
+    free(info->holes);
+    free(info->buffer);
+    free(info);
+  }
 
   // Reset handle
   fHandle->mgmtInfo = NULL;
@@ -93,8 +694,9 @@ RC closePageFile(SM_FileHandle *fHandle) {
 
 RC destroyPageFile(char *fileName) {
 
-	// Removing file, returns error if file not found
-    if (remove(fileName) != 0) {
+	// Removing file from its backend, returns error if file not found
+    const SM_Backend *backend = findBackend(fileName);
+    if (backend == NULL || backend->destroy(fileName) != RC_OK) {
         return RC_FILE_NOT_FOUND;
     }
 
@@ -102,6 +704,40 @@ RC destroyPageFile(char *fileName) {
 }
 
 
+RC syncPageFile(SM_FileHandle *fHandle) {
+
+  // Validate file handle
+  if (!fHandle || !fHandle->mgmtInfo)
+    return RC_FILE_HANDLE_NOT_INIT;
+
+  // Asking the backend to make the written pages durable
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  return info->backend->sync(info->device);
+}
+
+
+RC registerBackend(const SM_Backend *backend) {
+
+  if (backend == NULL)
+    return RC_INVALID_PARAMETER;
+
+  // Registering a backend twice changes nothing
+  for (int i = 0; i < numBackends; i++) {
+    if (backends[i] == backend)
+      return RC_OK;
+  }
+  if (numBackends == SM_MAX_BACKENDS)
+    return RC_ERROR;
+
+  // Registered backends are looked at before the built-in ones
+  memmove(&backends[1], &backends[0], numBackends * sizeof(SM_Backend *));
+  backends[0] = backend;
+  numBackends++;
+
+  return RC_OK;
+}
+
+
 RC readBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
 
   // Validate file handle and return error code if not found
@@ -112,14 +748,19 @@ RC readBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
   if (pageNum < 0 || pageNum >= fHandle->totalNumPages)
     return RC_READ_NON_EXISTING_PAGE;
 
+  // Pages of a compressed file are decompressed from their extent
+  if (isCompressed(fHandle)) {
+    RC result = readCompressedBlock(pageNum, fHandle, memPage);
+    if (result == RC_OK)
+      fHandle->curPagePos = pageNum;
+    return result;
+  }
+
   // Calculating offset with page number and page size
-  long offset = pageNum * PAGE_SIZE;
+  long offset = pageOffset(fHandle, pageNum);
 
-  // Seek to offset and read page data
-  FILE* file = fHandle->mgmtInfo; 
-  fseek(file, offset, SEEK_SET);
-  size_t read = fread(memPage, PAGE_SIZE, 1, file);
-  if (read != 1)
+  // Read page data at the offset
+  if (readBytes(fHandle, offset, memPage, fHandle->pageSize) != RC_OK)
     return RC_READ_ERROR;
 
   // Updating current page position
@@ -128,6 +769,42 @@ RC readBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
   return RC_OK;
 }
 
+RC readBlocks(int pageNum, int numPages, SM_FileHandle *fHandle, SM_PageHandle memPage) {
+
+  // Validate file handle and return error code if not found
+  if (!fHandle || !fHandle->mgmtInfo)
+    return RC_FILE_HANDLE_NOT_INIT;
+
+  // Validating the range of pages
+  if (numPages <= 0 || pageNum < 0 || pageNum + numPages > fHandle->totalNumPages)
+    return RC_READ_NON_EXISTING_PAGE;
+
+  // Pages of a compressed file are decompressed one by one
+  if (isCompressed(fHandle)) {
+    for (int i = 0; i < numPages; i++) {
+      RC result = readCompressedBlock(pageNum + i, fHandle, memPage + (size_t) i * fHandle->pageSize);
+      if (result != RC_OK)
+        return result;
+    }
+    fHandle->curPagePos = pageNum + numPages - 1;
+    return RC_OK;
+  }
+
+  // Read the pages of the run with one request for each stretch of pages next to each other in the file
+  for (int done = 0; done < numPages; ) {
+    int count = contiguousPages(fHandle, pageNum + done, numPages - done);
+    if (readBytes(fHandle, pageOffset(fHandle, pageNum + done), memPage + (size_t) done * fHandle->pageSize,
+                  (long) count * fHandle->pageSize) != RC_OK)
+      return RC_READ_ERROR;
+    done += count;
+  }
+
+  // Updating current page position to the last page read
+  fHandle->curPagePos = pageNum + numPages - 1;
+
+  return RC_OK;
+}
+
 int getBlockPos(SM_FileHandle *fHandle) {
     if (fHandle == NULL || fHandle->mgmtInfo == NULL) {
         // Check if fHandle is null and return error code
@@ -193,6 +870,139 @@ RC readNextBlock(SM_FileHandle *fHandle, SM_PageHandle memPage) {
 
 
 
+// State of an asynchronous read kept in mgmtInfo of the request
+typedef struct SM_AsyncInfo {
+  struct aiocb control;
+  bool issued;           // FALSE if the page needed no read (a page of zeros in a compressed file, a backend without descriptor)
+  char *compressed;      // extent read for a compressed page, decompressed into memPage when the read completes
+  int length;
+  int pageSize;
+} SM_AsyncInfo;
+
+RC readBlockAsync(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage, SM_AsyncRead *request) {
+
+  // Validate file handle and request
+  if (!fHandle || !fHandle->mgmtInfo || !request)
+    return RC_FILE_HANDLE_NOT_INIT;
+
+  // Validating page number
+  if (pageNum < 0 || pageNum >= fHandle->totalNumPages)
+    return RC_READ_NON_EXISTING_PAGE;
+
+  // Backends without a file descriptor are read right away, the request is complete when it is issued
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  int fd = info->backend->descriptor(info->device);
+  if (fd == -1) {
+    RC result = isCompressed(fHandle) ? readCompressedBlock(pageNum, fHandle, memPage)
+                                      : readBytes(fHandle, pageOffset(fHandle, pageNum), memPage, fHandle->pageSize);
+    if (result != RC_OK)
+      return RC_READ_ERROR;
+
+    request->pageNum = pageNum;
+    request->memPage = memPage;
+    request->mgmtInfo = calloc(1, sizeof(SM_AsyncInfo));
+    return RC_OK;
+  }
+
+  // Describe the read for the kernel
+  SM_AsyncInfo *async = calloc(1, sizeof(SM_AsyncInfo));
+  struct aiocb *control = &async->control;
+  control->aio_fildes = fd;
+  control->aio_offset = (off_t)pageOffset(fHandle, pageNum);
+  control->aio_buf = memPage;
+  control->aio_nbytes = fHandle->pageSize;
+  async->issued = TRUE;
+
+  // A compressed page is read from its extent, pages of zeros need no read at all
+  if (isCompressed(fHandle)) {
+    SM_PageExtent *extent = pageExtent(fHandle, pageNum);
+    if (extent == NULL) {
+      free(async);
+      return RC_READ_ERROR;
+    }
+    control->aio_offset = (off_t)extentOffset(fHandle, extent->unit);
+    control->aio_nbytes = extent->length;
+    if (extent->length == 0) {
+      memset(memPage, 0, fHandle->pageSize);
+      async->issued = FALSE;
+    }
+    else if (extent->length < fHandle->pageSize) {
+      async->compressed = malloc(extent->length);
+      async->length = extent->length;
+      async->pageSize = fHandle->pageSize;
+      control->aio_buf = async->compressed;
+    }
+  }
+
+  // Issue the read, it completes in the background
+  if (async->issued && aio_read(control) != 0) {
+    free(async->compressed);
+    free(async);
+    return RC_READ_ERROR;
+  }
+
+  request->pageNum = pageNum;
+  request->memPage = memPage;
+  request->mgmtInfo = async;
+
+  return RC_OK;
+}
+
+// Finishes a completed asynchronous read and releases its control block
+static RC finishBlockAsync(SM_AsyncRead *request) {
+  SM_AsyncInfo *async = request->mgmtInfo;
+  RC result = RC_OK;
+
+  if (async->issued) {
+    ssize_t read = aio_return(&async->control);
+    if (read < 0 || (size_t) read != async->control.aio_nbytes)
+      result = RC_READ_ERROR;
+  }
+
+  if (result == RC_OK && async->compressed != NULL &&
+      lzDecompress(async->compressed, async->length, request->memPage, async->pageSize) != async->pageSize)
+    result = RC_READ_ERROR;
+
+  free(async->compressed);
+  free(async);
+  request->mgmtInfo = NULL;
+
+  return result;
+}
+
+// Returns TRUE while the read of a request is running
+static bool isReadRunning(SM_AsyncRead *request) {
+  SM_AsyncInfo *async = request->mgmtInfo;
+  return async->issued && aio_error(&async->control) == EINPROGRESS;
+}
+
+RC pollBlockAsync(SM_AsyncRead *request) {
+
+  // Validate request
+  if (!request || !request->mgmtInfo)
+    return RC_FILE_HANDLE_NOT_INIT;
+
+  // Return without blocking if the read is still running
+  if (isReadRunning(request))
+    return RC_IO_IN_PROGRESS;
+
+  return finishBlockAsync(request);
+}
+
+RC waitBlockAsync(SM_AsyncRead *request) {
+
+  // Validate request
+  if (!request || !request->mgmtInfo)
+    return RC_FILE_HANDLE_NOT_INIT;
+
+  // Block until the read has completed
+  const struct aiocb *list[1] = { &((SM_AsyncInfo *) request->mgmtInfo)->control };
+  while (isReadRunning(request))
+    aio_suspend(list, 1, NULL);
+
+  return finishBlockAsync(request);
+}
+
 RC writeBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
 
   // Check for valid file handle
@@ -203,14 +1013,19 @@ RC writeBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
   if (pageNum < 0 || pageNum >= fHandle->totalNumPages)
     return RC_WRITE_NON_EXISTING_PAGE;
 
+  // Pages of a compressed file are compressed into their extent
+  if (isCompressed(fHandle)) {
+    RC result = writeCompressedBlock(pageNum, fHandle, memPage);
+    if (result == RC_OK)
+      fHandle->curPagePos = pageNum;
+    return result;
+  }
+
   // Calculate file offset
-  long offset = pageNum * PAGE_SIZE;
+  long offset = pageOffset(fHandle, pageNum);
 
-  // Seek to offset and write page data
-  FILE* file = fHandle->mgmtInfo;
-  fseek(file, offset, SEEK_SET);
-  size_t written = fwrite(memPage, PAGE_SIZE, 1, file);
-  if (written != 1) 
+  // Write page data at the offset
+  if (writeBytes(fHandle, offset, memPage, fHandle->pageSize) != RC_OK)
     return RC_WRITE_FAILED;
 
   // Update current page and total no. of pages if extended
@@ -222,6 +1037,43 @@ RC writeBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
 }
 
 
+RC writeBlocks(int pageNum, int numPages, SM_FileHandle *fHandle, SM_PageHandle memPage) {
+
+  // Check for valid file handle
+  if (!fHandle || !fHandle->mgmtInfo)
+    return RC_FILE_HANDLE_NOT_INIT;
+
+  // The run starts at an existing page or right at the end of the file, pages past the end are appended
+  if (numPages <= 0 || pageNum < 0 || pageNum > fHandle->totalNumPages)
+    return RC_WRITE_NON_EXISTING_PAGE;
+
+  // Pages of a compressed file are compressed one by one into their extents
+  if (isCompressed(fHandle)) {
+    RC result = ensureCapacity(pageNum + numPages, fHandle);
+    for (int i = 0; i < numPages && result == RC_OK; i++)
+      result = writeCompressedBlock(pageNum + i, fHandle, memPage + (size_t) i * fHandle->pageSize);
+    if (result == RC_OK)
+      fHandle->curPagePos = pageNum + numPages - 1;
+    return result;
+  }
+
+  // Write the pages of the run with one request for each stretch of pages next to each other in the file
+  for (int done = 0; done < numPages; ) {
+    int count = contiguousPages(fHandle, pageNum + done, numPages - done);
+    if (writeBytes(fHandle, pageOffset(fHandle, pageNum + done), memPage + (size_t) done * fHandle->pageSize,
+                   (long) count * fHandle->pageSize) != RC_OK)
+      return RC_WRITE_FAILED;
+    done += count;
+  }
+
+  // Updating current page position to the last page written and the page count if the file grew
+  fHandle->curPagePos = pageNum + numPages - 1;
+  if (pageNum + numPages > fHandle->totalNumPages)
+    fHandle->totalNumPages = pageNum + numPages;
+
+  return RC_OK;
+}
+
 RC writeCurrentBlock(SM_FileHandle *fHandle, SM_PageHandle memPage) {
 
   // Validate file handle
@@ -232,37 +1084,165 @@ RC writeCurrentBlock(SM_FileHandle *fHandle, SM_PageHandle memPage) {
   if (fHandle->curPagePos < 0 || fHandle->curPagePos >= fHandle->totalNumPages) 
     return RC_WRITE_NON_EXISTING_PAGE;
 
+  // Pages of a compressed file are compressed into their extent
+  if (isCompressed(fHandle))
+    return writeCompressedBlock(fHandle->curPagePos, fHandle, memPage);
+
   // Calculate offset
-  long offset = fHandle->curPagePos * PAGE_SIZE;
+  long offset = pageOffset(fHandle, fHandle->curPagePos);
 
-  // Seek to offset and write page data
-  FILE* file = fHandle->mgmtInfo;
-  fseek(file, offset, SEEK_SET);
-  size_t written = fwrite(memPage, PAGE_SIZE, 1, file);
-  if (written != 1)
+  // Write page data at the offset
+  if (writeBytes(fHandle, offset, memPage, fHandle->pageSize) != RC_OK)
     return RC_WRITE_FAILED;
 
   return RC_OK;
 }
 
+// Returns page m of the free map, read from the file the first time it is needed. NULL if it cannot be read.
+static unsigned char *loadMapPage(SM_FileHandle *fHandle, int m) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  int pageSize = fHandle->pageSize;
+
+  if (m >= info->mapSlots) {
+    int slots = info->mapSlots > 0 ? info->mapSlots : 1;
+    while (slots <= m)
+      slots *= 2;
+    info->freeMap = realloc(info->freeMap, (size_t) slots * pageSize);
+    info->mapLoaded = realloc(info->mapLoaded, slots * sizeof(bool));
+    memset(&info->mapLoaded[info->mapSlots], 0, (slots - info->mapSlots) * sizeof(bool));
+    info->mapSlots = slots;
+  }
+
+  unsigned char *mapPage = info->freeMap + (size_t) m * pageSize;
+  if (!info->mapLoaded[m]) {
+    if (readBytes(fHandle, mapPageOffset(fHandle, m), mapPage, pageSize) != RC_OK)
+      return NULL;
+    info->mapLoaded[m] = TRUE;
+  }
+  return mapPage;
+}
+
+// Writes page m of the free map back to the file
+static RC writeMapPage(SM_FileHandle *fHandle, int m) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  return writeBytes(fHandle, mapPageOffset(fHandle, m), info->freeMap + (size_t) m * fHandle->pageSize, fHandle->pageSize);
+}
+
+// Sets or clears the bit of a page in the free map in memory
+static RC markPageFree(SM_FileHandle *fHandle, int pageNum, bool free) {
+  unsigned char *mapPage = loadMapPage(fHandle, pageNum / mapPageSpan(fHandle));
+  if (mapPage == NULL)
+    return RC_READ_ERROR;
+
+  int bit = pageNum % mapPageSpan(fHandle);
+  if (free)
+    mapPage[bit / 8] |= 1 << (bit % 8);
+  else
+    mapPage[bit / 8] &= ~(1 << (bit % 8));
+  return RC_OK;
+}
+
+// Writes a run of units of a compressed file that takes the moved table or map, zeros after the first length bytes
+static RC writeMovedRun(SM_FileHandle *fHandle, int unit, int units, const void *data, long length) {
+  char *run = calloc((size_t) units, SM_EXTENT_UNIT);
+  memcpy(run, data, length);
+  RC result = writeBytes(fHandle, extentOffset(fHandle, unit), run, (long) units * SM_EXTENT_UNIT);
+  free(run);
+  return result;
+}
+
+// Moves the page-mapping table of a compressed file to a run of units twice its size in the extent area.
+// The header points to the new table before the units of an old one are given back.
+static RC growTable(SM_FileHandle *fHandle) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  int oldUnit = info->tableUnit;
+  int oldUnits = info->tableUnits;
+  int units = extentUnits(2 * tableCapacity(fHandle) * (int) sizeof(SM_PageExtent));
+
+  // Reserving the run reads the whole table into memory
+  int unit;
+  RC result = reserveExtent(fHandle, units, &unit);
+  if (result == RC_OK)
+    result = writeMovedRun(fHandle, unit, units, info->extents, (long) fHandle->totalNumPages * sizeof(SM_PageExtent));
+  if (result != RC_OK)
+    return result;
+
+  info->tableUnit = unit;
+  info->tableUnits = units;
+  info->version = SM_FILE_VERSION;
+  if ((result = writeFileHeader(fHandle)) != RC_OK)
+    return result;
+
+  return releaseExtent(fHandle, oldUnit, oldUnits);
+}
+
+// Moves the free map of a compressed file to a run of units twice its size in the extent area
+static RC growMap(SM_FileHandle *fHandle) {
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  int oldUnit = info->mapUnit;
+  int oldUnits = info->mapUnits;
+  int mapPages = mapPageCount(fHandle);
+  int units = 2 * mapPages * (fHandle->pageSize / SM_EXTENT_UNIT);
+
+  // All pages of the old map are needed in memory, those of the new map past them are empty
+  for (int m = 0; m < mapPages; m++) {
+    if (loadMapPage(fHandle, m) == NULL)
+      return RC_READ_ERROR;
+  }
+
+  int unit;
+  RC result = reserveExtent(fHandle, units, &unit);
+  if (result == RC_OK)
+    result = writeMovedRun(fHandle, unit, units, info->freeMap, (long) mapPages * fHandle->pageSize);
+  if (result != RC_OK)
+    return result;
+
+  info->mapUnit = unit;
+  info->mapUnits = units;
+  info->version = SM_FILE_VERSION;
+  if ((result = writeFileHeader(fHandle)) != RC_OK)
+    return result;
+
+  return releaseExtent(fHandle, oldUnit, oldUnits);
+}
+
 RC appendEmptyBlock(SM_FileHandle *fHandle) {
 
   // Validate file handle
   if (!fHandle || !fHandle->mgmtInfo)
     return RC_FILE_HANDLE_NOT_INIT;
 
-  // Compute offset of new last page 
-  long offset = fHandle->totalNumPages * PAGE_SIZE;
+  // A new page of a compressed file is a page of zeros without an extent, only the table and the header change
+  if (isCompressed(fHandle)) {
+    SM_FileInfo *info = fHandle->mgmtInfo;
+    RC result = RC_OK;
+    if (fHandle->totalNumPages >= tableCapacity(fHandle))
+      result = growTable(fHandle);
+    if (result == RC_OK && fHandle->totalNumPages >= mapCapacity(fHandle))
+      result = growMap(fHandle);
+    if (result != RC_OK)
+      return result;
+
+    growExtents(fHandle, fHandle->totalNumPages + 1);
+    info->extents[fHandle->totalNumPages].unit = 0;
+    info->extents[fHandle->totalNumPages].length = 0;
+
+    result = writeExtentEntry(fHandle, fHandle->totalNumPages);
+    if (result != RC_OK)
+      return result;
+
+    fHandle->totalNumPages++;
+    return writeFileHeader(fHandle);
+  }
 
-  // Seek to offset and write empty page
-  FILE* file = fHandle->mgmtInfo;
-  fseek(file, offset, SEEK_SET);
+  // Compute offset of new last page 
+  long offset = pageOffset(fHandle, fHandle->totalNumPages);
 
-  char empty[PAGE_SIZE];
-  memset(empty, 0, PAGE_SIZE);
-  
-  size_t written = fwrite(empty, PAGE_SIZE, 1, file);
-  if(written != 1)
+  // Write an empty page at the offset
+  char *empty = calloc(fHandle->pageSize, sizeof(char));
+  RC written = writeBytes(fHandle, offset, empty, fHandle->pageSize);
+  free(empty);
+  if(written != RC_OK)
     return RC_WRITE_FAILED;
 
   // Increment total pages
@@ -277,27 +1257,186 @@ RC ensureCapacity(int numPages, SM_FileHandle *fHandle) {
   if(!fHandle || !fHandle->mgmtInfo) 
     return RC_FILE_HANDLE_NOT_INIT;
 
-  // Calculate required capacity in bytes
-  int requiredSize = numPages * PAGE_SIZE;
+  // If the file has fewer pages, append empty pages
+  while(fHandle->totalNumPages < numPages) {
+    RC result = appendEmptyBlock(fHandle);
+    if(result != RC_OK)
+      return result; 
+  }
+  return RC_OK;
+
+}
 
-  // Get current file size
-  FILE* file = fHandle->mgmtInfo;
-  fseek(file, 0, SEEK_END);
-  int currentSize = ftell(file);
+// Returns TRUE if the page is covered by the free map and marked free
+bool isPageFree(int pageNum, SM_FileHandle *fHandle) {
+  if (!fHandle || !fHandle->mgmtInfo || pageNum < 0 || pageNum >= fHandle->totalNumPages)
+    return FALSE;
 
-  // If current size is less, append empty pages
-  if(currentSize < requiredSize) {
-    
-    // Calculate number of pages to append
-    int pagesToAppend = (requiredSize - currentSize) / PAGE_SIZE;
+  if (pageNum >= mapCapacity(fHandle))
+    return FALSE;
+
+  unsigned char *mapPage = loadMapPage(fHandle, pageNum / mapPageSpan(fHandle));
+  int bit = pageNum % mapPageSpan(fHandle);
+  return mapPage != NULL && ((mapPage[bit / 8] >> (bit % 8)) & 1);
+}
+
+RC allocatePage(SM_FileHandle *fHandle, int *pageNum) {
 
-    for(int i = 0; i < pagesToAppend; i++) {
-      RC result = appendEmptyBlock(fHandle);
-      if(result != RC_OK)
-        return result; 
+  // Validate file handle
+  if (!fHandle || !fHandle->mgmtInfo || !pageNum)
+    return RC_FILE_HANDLE_NOT_INIT;
+
+  // Look for the lowest free page map page by map page, whole bytes without a free page are skipped
+  int limit = fHandle->totalNumPages;
+  if (limit > mapCapacity(fHandle))
+    limit = mapCapacity(fHandle);
+
+  int span = mapPageSpan(fHandle);
+  for (int m = 0; m * span < limit; m++) {
+    unsigned char *mapPage = loadMapPage(fHandle, m);
+    if (mapPage == NULL)
+      return RC_READ_ERROR;
+
+    for (int byte = 0; byte < fHandle->pageSize && m * span + byte * 8 < limit; byte++) {
+      if (mapPage[byte] == 0)
+        continue;
+
+      for (int bit = 0; bit < 8 && m * span + byte * 8 + bit < limit; bit++) {
+        if (!((mapPage[byte] >> bit) & 1))
+          continue;
+
+        // Reuse the page, it is handed out zeroed like an appended one
+        int reused = m * span + byte * 8 + bit;
+        char *empty = calloc(fHandle->pageSize, sizeof(char));
+        RC result = writeBlock(reused, fHandle, empty);
+        free(empty);
+        if (result != RC_OK)
+          return result;
+
+        mapPage[byte] &= ~(1 << bit);
+        result = writeMapPage(fHandle, m);
+        if (result != RC_OK)
+          return result;
+
+        *pageNum = reused;
+        return RC_OK;
+      }
     }
+  }
+
+  // No free page, grow the file
+  RC result = appendEmptyBlock(fHandle);
+  if (result != RC_OK)
+    return result;
+
+  *pageNum = fHandle->totalNumPages - 1;
+  fHandle->curPagePos = *pageNum;
+
+  return RC_OK;
+}
+
+RC freePage(int pageNum, SM_FileHandle *fHandle) {
+
+  // Validate file handle
+  if (!fHandle || !fHandle->mgmtInfo)
+    return RC_FILE_HANDLE_NOT_INIT;
+
+  // Only existing pages covered by the free map can be freed, the map of a plain file grows with the file
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  if (pageNum < 0 || pageNum >= fHandle->totalNumPages || pageNum >= mapCapacity(fHandle))
+    return RC_WRITE_NON_EXISTING_PAGE;
+
+  RC result = markPageFree(fHandle, pageNum, TRUE);
+  if (result != RC_OK)
+    return result;
+
+  // The extent of a page of a compressed file is given back right away, the page reads as zeros
+  if (info->compressed) {
+    SM_PageExtent *extent = pageExtent(fHandle, pageNum);
+    if (extent == NULL)
+      return RC_READ_ERROR;
+    result = releaseExtent(fHandle, extent->unit, extentUnits(extent->length));
+    extent->unit = 0;
+    extent->length = 0;
+    if (result != RC_OK || (result = writeExtentEntry(fHandle, pageNum)) != RC_OK)
+      return result;
+  }
+
+  // Free pages at the end of the file are cut off, so the file size follows the live pages
+  int numPages = fHandle->totalNumPages;
+  while (numPages > 0 && isPageFree(numPages - 1, fHandle)) {
+    numPages--;
+    markPageFree(fHandle, numPages, FALSE);
+  }
 
+  // Writing back the map page of the freed page and those of the pages cut off
+  int span = mapPageSpan(fHandle);
+  if ((result = writeMapPage(fHandle, pageNum / span)) != RC_OK)
+    return result;
+  for (int m = numPages / span; numPages < fHandle->totalNumPages && m <= (fHandle->totalNumPages - 1) / span; m++) {
+    if (m != pageNum / span && (result = writeMapPage(fHandle, m)) != RC_OK)
+      return result;
   }
+
+  if (numPages < fHandle->totalNumPages) {
+    if (!info->compressed && resizeFile(fHandle, plainFileSize(fHandle, numPages)) != RC_OK)
+      return RC_WRITE_FAILED;
+
+    fHandle->totalNumPages = numPages;
+    if (fHandle->curPagePos >= numPages)
+      fHandle->curPagePos = numPages > 0 ? numPages - 1 : 0;
+
+    if (info->compressed)
+      return writeFileHeader(fHandle);
+  }
+
   return RC_OK;
+}
+
+RC adviseBlocks(int pageNum, int numPages, SM_FileHandle *fHandle, SM_AccessAdvice advice) {
+
+  // Validate file handle
+  if (!fHandle || !fHandle->mgmtInfo)
+    return RC_FILE_HANDLE_NOT_INIT;
+
+  int flags[] = { POSIX_FADV_NORMAL, POSIX_FADV_SEQUENTIAL, POSIX_FADV_RANDOM, POSIX_FADV_WILLNEED, POSIX_FADV_DONTNEED };
+  if (advice < SM_ADVICE_NORMAL || advice > SM_ADVICE_DONTNEED || pageNum < 0 || numPages < 0)
+    return RC_INVALID_PARAMETER;
+
+  // The range is cut at the end of the file, pages past it need no advice
+  if (numPages == 0 || pageNum + numPages > fHandle->totalNumPages)
+    numPages = fHandle->totalNumPages - pageNum;
+  if (numPages <= 0)
+    return RC_OK;
+
+  // Byte range of the pages, for a compressed file the range of their extents
+  SM_FileInfo *info = fHandle->mgmtInfo;
+  off_t offset = pageOffset(fHandle, pageNum);
+  off_t length = pageOffset(fHandle, pageNum + numPages - 1) + fHandle->pageSize - offset;
+  if (info->compressed) {
+    long first = -1;
+    long last = -1;
+    for (int i = pageNum; i < pageNum + numPages; i++) {
+      SM_PageExtent *extent = pageExtent(fHandle, i);
+      if (extent == NULL)
+        return RC_READ_ERROR;
+      if (extent->length == 0)
+        continue;
+      if (first == -1 || extentOffset(fHandle, extent->unit) < first)
+        first = extentOffset(fHandle, extent->unit);
+      if (extentOffset(fHandle, extent->unit) + extent->length > last)
+        last = extentOffset(fHandle, extent->unit) + extent->length;
+    }
+    if (first == -1)
+      return RC_OK;
+    offset = first;
+    length = last - first;
+  }
+
+  // Only backends on a file descriptor have a page cache to advise
+  int fd = info->backend->descriptor(info->device);
+  if (fd != -1 && posix_fadvise(fd, offset, length, flags[advice]) != 0)
+    return RC_ERROR;
 
-}
\ No newline at end of file
+  return RC_OK;
+}
@@ -2,6 +2,15 @@
 #define STORAGE_MGR_H
 
 #include "dberror.h"
+#include "dt.h"
+#include "storage_backend.h"
+
+/* largest page size of a page file, the smallest is PAGE_SIZE */
+#define SM_MAX_PAGE_SIZE 65536
+
+/* flags of a page file: pages are stored compressed, the file lives in the memory backend */
+#define SM_COMPRESSED 1
+#define SM_IN_MEMORY 2
 
 /************************************************************
  *                    handle data structures                *
@@ -10,23 +19,49 @@ typedef struct SM_FileHandle {
 	char *fileName;
 	int totalNumPages;
 	int curPagePos;
+	int pageSize;
 	void *mgmtInfo;
 } SM_FileHandle;
 
 typedef char* SM_PageHandle;
 
+/* access pattern of a range of pages, passed to posix_fadvise */
+typedef enum SM_AccessAdvice {
+	SM_ADVICE_NORMAL = 0,
+	SM_ADVICE_SEQUENTIAL = 1,
+	SM_ADVICE_RANDOM = 2,
+	SM_ADVICE_WILLNEED = 3,
+	SM_ADVICE_DONTNEED = 4
+} SM_AccessAdvice;
+
+typedef struct SM_AsyncRead {
+	int pageNum;
+	SM_PageHandle memPage;
+	void *mgmtInfo;
+} SM_AsyncRead;
+
 /************************************************************
  *                    interface                             *
  ************************************************************/
 /* manipulating page files */
 extern void initStorageManager (void);
 extern RC createPageFile (char *fileName);
+extern RC createPageFileWithSize (char *fileName, int pageSize);
+extern RC createCompressedPageFile (char *fileName, int pageSize);
+extern RC createPageFileWithFlags (char *fileName, int pageSize, int flags);
+extern RC createPageFileOnBackend (char *fileName, int pageSize, int flags, const SM_Backend *backend);
+extern bool isValidPageSize (int pageSize);
 extern RC openPageFile (char *fileName, SM_FileHandle *fHandle);
 extern RC closePageFile (SM_FileHandle *fHandle);
 extern RC destroyPageFile (char *fileName);
+extern RC syncPageFile (SM_FileHandle *fHandle);
+
+/* backends looked up by openPageFile and destroyPageFile, registered ones come first */
+extern RC registerBackend (const SM_Backend *backend);
 
 /* reading blocks from disc */
 extern RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC readBlocks (int pageNum, int numPages, SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern int getBlockPos (SM_FileHandle *fHandle);
 extern RC readFirstBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readPreviousBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
@@ -34,10 +69,24 @@ extern RC readCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readNextBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 
+/* asynchronous reads */
+extern RC readBlockAsync (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage, SM_AsyncRead *request);
+extern RC pollBlockAsync (SM_AsyncRead *request);
+extern RC waitBlockAsync (SM_AsyncRead *request);
+
 /* writing blocks to a page file */
 extern RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC writeBlocks (int pageNum, int numPages, SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC appendEmptyBlock (SM_FileHandle *fHandle);
 extern RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle);
 
+/* free-page map kept in the header region of the file */
+extern RC allocatePage (SM_FileHandle *fHandle, int *pageNum);
+extern RC freePage (int pageNum, SM_FileHandle *fHandle);
+extern bool isPageFree (int pageNum, SM_FileHandle *fHandle);
+
+/* access pattern hints, numPages 0 means up to the end of the file */
+extern RC adviseBlocks (int pageNum, int numPages, SM_FileHandle *fHandle, SM_AccessAdvice advice);
+
 #endif
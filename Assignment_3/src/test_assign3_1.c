@@ -4,6 +4,7 @@
 #include "record_mgr.h"
 #include "tables.h"
 #include "test_helper.h"
+#include "storage_mgr.h"
 
 
 #define ASSERT_EQUALS_RECORDS(_l,_r, schema, message)			\
@@ -55,6 +56,18 @@ static void testScans (void);
 static void testScansTwo (void);
 static void testInsertManyRecords(void);
 static void testMultipleScans(void);
+static void testFreeSpaceMap(void);
+static void testRecordPageBitmap(void);
+static void testVarcharRecords(void);
+static void testMultipleOpenTables(void);
+static void testInsertRecords(void);
+static void testBulkLoad(void);
+static void testScanPagePin(void);
+static void testNextBatch(void);
+static void testScanProjection(void);
+static void testFreedPages(void);
+static void testStaleFreeSpaceMap(void);
+static void testFailedMove(void);
 
 // struct for test records
 typedef struct TestRecord {
@@ -84,6 +97,18 @@ main (void)
 	testScans();
 	testScansTwo();
 	testMultipleScans();
+	testFreeSpaceMap();
+	testRecordPageBitmap();
+	testVarcharRecords();
+	testMultipleOpenTables();
+	testInsertRecords();
+	testBulkLoad();
+	testScanPagePin();
+	testNextBatch();
+	testScanProjection();
+	testFreedPages();
+	testStaleFreeSpaceMap();
+	testFailedMove();
 
 	return 0;
 }
@@ -656,6 +681,1075 @@ void testScansTwo (void)
 }
 
 
+// ************************************************************
+void
+testFreeSpaceMap(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	TestRecord insert = {1, "aaaa", 3};
+	int numInserts = 1000, i, slotsPerPage = 0;
+	Record *r;
+	RID *rids;
+	Schema *schema;
+	SM_FileHandle fh;
+	char *page = (char *) calloc(PAGE_SIZE, sizeof(char));
+	testName = "test inserts going to the pages the free-space map knows to have room";
+	schema = testSchema();
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_f",schema));
+	TEST_CHECK(openTable(table, "test_table_f"));
+
+	// fill a few pages
+	for(i = 0; i < numInserts; i++)
+	{
+		insert.a = i;
+		r = fromTestRecord(schema, insert);
+		TEST_CHECK(insertRecord(table,r));
+		rids[i] = r->id;
+		freeRecord(r);
+	}
+	while (rids[slotsPerPage].page == 1)
+		slotsPerPage++;
+	ASSERT_EQUALS_INT(1 + (numInserts - 1) / slotsPerPage, rids[numInserts - 1].page, "records packed into the pages");
+
+	// inserts reuse the freed slots, lowest page first, then go on at the end
+	TEST_CHECK(deleteRecord(table, rids[2 * slotsPerPage + 7]));
+	TEST_CHECK(deleteRecord(table, rids[5]));
+	r = fromTestRecord(schema, insert);
+	TEST_CHECK(insertRecord(table,r));
+	ASSERT_EQUALS_INT(1, r->id.page, "freed slot of the first page");
+	ASSERT_EQUALS_INT(5, r->id.slot, "slot of the first deleted record");
+	TEST_CHECK(insertRecord(table,r));
+	ASSERT_EQUALS_INT(3, r->id.page, "freed slot of the third page");
+	ASSERT_EQUALS_INT(rids[2 * slotsPerPage + 7].slot, r->id.slot, "slot of the second deleted record");
+	TEST_CHECK(insertRecord(table,r));
+	ASSERT_EQUALS_INT(rids[numInserts - 1].page, r->id.page, "no room left before the last page");
+	ASSERT_EQUALS_INT(rids[numInserts - 1].slot + 1, r->id.slot, "next slot of the last page");
+	freeRecord(r);
+
+	// the map is saved next to the table when it is closed and loaded when it is opened
+	TEST_CHECK(deleteRecord(table, rids[slotsPerPage + 3]));
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openPageFile("test_table_f.fsm", &fh));
+	TEST_CHECK(readBlock(0, &fh, page));
+	// the stored record is the record with a length byte before its string of four characters
+	ASSERT_EQUALS_INT(getRecordSize(schema) + 1, ((int *) page)[1 + 2], "free bytes of the second page saved");
+	ASSERT_EQUALS_INT(0, ((int *) page)[1 + 1], "first page saved as full");
+	TEST_CHECK(closePageFile(&fh));
+
+	TEST_CHECK(openTable(table, "test_table_f"));
+	r = fromTestRecord(schema, insert);
+	TEST_CHECK(insertRecord(table,r));
+	ASSERT_EQUALS_INT(2, r->id.page, "freed slot found after reopening");
+	ASSERT_EQUALS_INT(rids[slotsPerPage + 3].slot, r->id.slot, "slot of the record deleted before closing");
+	freeRecord(r);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_f"));
+	ASSERT_TRUE(openPageFile("test_table_f.fsm", &fh) == RC_FILE_NOT_FOUND, "map deleted with the table");
+	TEST_CHECK(shutdownRecordManager());
+
+	free(table);
+	free(rids);
+	free(page);
+	freeSchema(schema);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testRecordPageBitmap(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	TestRecord insert = {1, "aaaa", 3};
+	int numInserts = 1000, i, found = 0, onEmptyPage = 0, deleted = 0;
+	Record *r;
+	RID *rids;
+	Schema *schema;
+	Expr *sel, *left, *right;
+	RC rc;
+	testName = "test scans over the slot bitmaps of the pages";
+	schema = testSchema();
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_b",schema));
+	TEST_CHECK(openTable(table, "test_table_b"));
+
+	for(i = 0; i < numInserts; i++)
+	{
+		insert.a = i;
+		r = fromTestRecord(schema, insert);
+		TEST_CHECK(insertRecord(table,r));
+		rids[i] = r->id;
+		freeRecord(r);
+	}
+
+	// empty the second page
+	for(i = 0; i < numInserts; i++)
+	{
+		if (rids[i].page == 2)
+		{
+			TEST_CHECK(deleteRecord(table, rids[i]));
+			deleted++;
+		}
+	}
+	ASSERT_TRUE(deleted > 0, "records deleted from the second page");
+
+	// deleted records are gone for getRecord and updateRecord
+	r = fromTestRecord(schema, insert);
+	for(i = 0; rids[i].page != 2; i++)
+		;
+	ASSERT_TRUE(getRecord(table, rids[i], r) == RC_RM_NO_TUPLE_WITH_GIVEN_RID, "deleted record not found");
+	r->id = rids[i];
+	ASSERT_TRUE(updateRecord(table, r) == RC_RM_NO_TUPLE_WITH_GIVEN_RID, "deleted record not updated");
+
+	// a scan returns every remaining record, none of the empty page
+	MAKE_CONS(left, stringToValue("i3"));
+	MAKE_ATTRREF(right, 2);
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+	TEST_CHECK(startScan(table, sc, sel));
+	while((rc = next(sc, r)) == RC_OK)
+	{
+		found++;
+		if (r->id.page == 2)
+			onEmptyPage++;
+	}
+	ASSERT_TRUE(rc == RC_RM_NO_MORE_TUPLES, "scan ended");
+	ASSERT_EQUALS_INT(numInserts - deleted, found, "all remaining records scanned");
+	ASSERT_EQUALS_INT(0, onEmptyPage, "empty page skipped");
+	TEST_CHECK(closeScan(sc));
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_b"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeRecord(r);
+	free(table);
+	free(sc);
+	free(rids);
+	freeSchema(schema);
+	freeExpr(sel);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testVarcharRecords(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	char *names[] = { "a", "b", "c" };
+	DataType dt[] = { DT_INT, DT_STRING, DT_INT };
+	int sizes[] = { 0, 200, 0 };
+	char **cpNames = (char **) malloc(sizeof(char*) * 3);
+	DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 3);
+	int *cpSizes = (int *) malloc(sizeof(int) * 3);
+	int *cpKeys = (int *) calloc(1, sizeof(int));
+	char longString[200];
+	int numInserts = 500, i, onFirstPage = 0, found = 0, foundUpdated = 0;
+	Record *r, *expected;
+	RID *rids;
+	Schema *schema;
+	Expr *sel, *left, *right;
+	RC rc;
+	testName = "test strings stored with their length and records moved when they grow";
+
+	for(i = 0; i < 3; i++)
+	{
+		cpNames[i] = (char *) malloc(2);
+		strcpy(cpNames[i], names[i]);
+	}
+	memcpy(cpDt, dt, sizeof(DataType) * 3);
+	memcpy(cpSizes, sizes, sizeof(int) * 3);
+	schema = createSchema(3, cpNames, cpDt, cpSizes, 1, cpKeys);
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+	memset(longString, 'x', sizeof(longString) - 1);
+	longString[sizeof(longString) - 1] = '\0';
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_v",schema));
+	TEST_CHECK(openTable(table, "test_table_v"));
+
+	// short strings take only their own bytes, so many more records fit a page than at the declared length
+	for(i = 0; i < numInserts; i++)
+	{
+		r = testRecord(schema, i, "ab", 3);
+		TEST_CHECK(insertRecord(table,r));
+		rids[i] = r->id;
+		if (r->id.page == 1)
+			onFirstPage++;
+		freeRecord(r);
+	}
+	ASSERT_TRUE(onFirstPage > 5 * (PAGE_SIZE / getRecordSize(schema)), "short records packed into the first page");
+
+	// a record that outgrows its full page is moved and keeps its RID
+	r = testRecord(schema, 0, "ab", 3);
+	expected = testRecord(schema, 0, longString, 3);
+	expected->id = rids[0];
+	TEST_CHECK(updateRecord(table, expected));
+	TEST_CHECK(getRecord(table, rids[0], r));
+	ASSERT_EQUALS_RECORDS(expected, r, schema, "grown record read through its old RID");
+	ASSERT_TRUE(r->id.page == rids[0].page && r->id.slot == rids[0].slot, "RID kept");
+	freeRecord(expected);
+
+	// updates of a moved record go to where it is, shrinking it works as well
+	longString[0] = 'y';
+	expected = testRecord(schema, 0, longString, 3);
+	expected->id = rids[0];
+	TEST_CHECK(updateRecord(table, expected));
+	TEST_CHECK(getRecord(table, rids[0], r));
+	ASSERT_EQUALS_RECORDS(expected, r, schema, "moved record updated");
+	freeRecord(expected);
+	expected = testRecord(schema, 0, "cd", 3);
+	expected->id = rids[0];
+	TEST_CHECK(updateRecord(table, expected));
+	TEST_CHECK(getRecord(table, rids[0], r));
+	ASSERT_EQUALS_RECORDS(expected, r, schema, "moved record shrunk");
+
+	// a scan returns the moved record once, under its RID
+	MAKE_CONS(left, stringToValue("i3"));
+	MAKE_ATTRREF(right, 2);
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+	TEST_CHECK(startScan(table, sc, sel));
+	while((rc = next(sc, r)) == RC_OK)
+	{
+		found++;
+		if (r->id.page == rids[0].page && r->id.slot == rids[0].slot)
+		{
+			foundUpdated++;
+			ASSERT_EQUALS_RECORDS(expected, r, schema, "moved record scanned");
+		}
+	}
+	ASSERT_TRUE(rc == RC_RM_NO_MORE_TUPLES, "scan ended");
+	ASSERT_EQUALS_INT(numInserts, found, "all records scanned");
+	ASSERT_EQUALS_INT(1, foundUpdated, "moved record scanned once");
+	TEST_CHECK(closeScan(sc));
+
+	// deleting it removes the record and the stub at its RID
+	TEST_CHECK(deleteRecord(table, rids[0]));
+	ASSERT_TRUE(getRecord(table, rids[0], r) == RC_RM_NO_TUPLE_WITH_GIVEN_RID, "moved record deleted");
+	found = 0;
+	TEST_CHECK(startScan(table, sc, sel));
+	while((rc = next(sc, r)) == RC_OK)
+		found++;
+	ASSERT_EQUALS_INT(numInserts - 1, found, "moved record gone from scans");
+	TEST_CHECK(closeScan(sc));
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_v"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeRecord(r);
+	freeRecord(expected);
+	free(table);
+	free(sc);
+	free(rids);
+	freeSchema(schema);
+	freeExpr(sel);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testMultipleOpenTables(void)
+{
+	RM_TableData *first = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_TableData *second = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	int numInserts = 300, i, found = 0;
+	Record *r, *expected;
+	RID *firstRids, *secondRids;
+	Schema *schema;
+	Expr *sel, *left, *right;
+	RC rc;
+	testName = "test tables open at the same time";
+	schema = testSchema();
+	firstRids = (RID *) malloc(sizeof(RID) * numInserts);
+	secondRids = (RID *) malloc(sizeof(RID) * numInserts);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_m1",schema));
+	TEST_CHECK(openTable(first, "test_table_m1"));
+
+	// creating and opening a second table leaves the first one alone
+	TEST_CHECK(createTable("test_table_m2",schema));
+	TEST_CHECK(openTable(second, "test_table_m2"));
+	for(i = 0; i < numInserts; i++)
+	{
+		r = testRecord(schema, i, "aaaa", 1);
+		TEST_CHECK(insertRecord(first,r));
+		firstRids[i] = r->id;
+		freeRecord(r);
+		r = testRecord(schema, i, "bbbb", 2);
+		TEST_CHECK(insertRecord(second,r));
+		secondRids[i] = r->id;
+		freeRecord(r);
+	}
+	ASSERT_EQUALS_INT(numInserts, getNumTuples(first), "tuples of the first table");
+	ASSERT_EQUALS_INT(numInserts, getNumTuples(second), "tuples of the second table");
+
+	// the same RID reads the record of each table
+	r = testRecord(schema, 0, "aaaa", 1);
+	expected = testRecord(schema, 7, "aaaa", 1);
+	TEST_CHECK(getRecord(first, firstRids[7], r));
+	ASSERT_EQUALS_RECORDS(expected, r, schema, "record of the first table");
+	freeRecord(expected);
+	expected = testRecord(schema, 7, "bbbb", 2);
+	TEST_CHECK(getRecord(second, secondRids[7], r));
+	ASSERT_EQUALS_RECORDS(expected, r, schema, "record of the second table");
+	freeRecord(expected);
+
+	// a scan of one table while the other one changes
+	MAKE_CONS(left, stringToValue("i1"));
+	MAKE_ATTRREF(right, 2);
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+	TEST_CHECK(startScan(first, sc, sel));
+	while((rc = next(sc, r)) == RC_OK)
+	{
+		found++;
+		if (found % 10 == 0)
+			TEST_CHECK(deleteRecord(second, secondRids[found - 1]));
+	}
+	ASSERT_TRUE(rc == RC_RM_NO_MORE_TUPLES, "scan ended");
+	ASSERT_EQUALS_INT(numInserts, found, "all records of the first table scanned");
+	TEST_CHECK(closeScan(sc));
+
+	// closing one table keeps the other one usable, the tuple counts are kept in the tables
+	TEST_CHECK(closeTable(first));
+	TEST_CHECK(getRecord(second, secondRids[numInserts - 2], r));
+	TEST_CHECK(closeTable(second));
+	TEST_CHECK(openTable(first, "test_table_m1"));
+	TEST_CHECK(openTable(second, "test_table_m2"));
+	ASSERT_EQUALS_INT(numInserts, getNumTuples(first), "tuples of the first table after reopening");
+	ASSERT_EQUALS_INT(numInserts - numInserts / 10, getNumTuples(second), "tuples of the second table after reopening");
+
+	TEST_CHECK(closeTable(first));
+	TEST_CHECK(closeTable(second));
+	TEST_CHECK(deleteTable("test_table_m1"));
+	TEST_CHECK(deleteTable("test_table_m2"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeRecord(r);
+	free(first);
+	free(second);
+	free(sc);
+	free(firstRids);
+	free(secondRids);
+	freeSchema(schema);
+	freeExpr(sel);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testInsertRecords(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numInserts = 1000, numRefill = 3, i, slotsPerPage = 0;
+	Record **records, *r;
+	Schema *schema;
+	testName = "test inserting a batch of records";
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numInserts);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_i",schema));
+	TEST_CHECK(openTable(table, "test_table_i"));
+
+	for(i = 0; i < numInserts; i++)
+		records[i] = testRecord(schema, i, "aaaa", 3);
+	TEST_CHECK(insertRecords(table, records, numInserts));
+	ASSERT_EQUALS_INT(numInserts, getNumTuples(table), "tuple count of the batch");
+
+	// the records fill the pages one after the other
+	while (records[slotsPerPage]->id.page == 1)
+		slotsPerPage++;
+	for(i = 0; i < numInserts; i++)
+	{
+		ASSERT_TRUE(records[i]->id.page == 1 + i / slotsPerPage && records[i]->id.slot == i % slotsPerPage, "RID of a batch record");
+	}
+
+	// every record reads back under its RID
+	r = testRecord(schema, 0, "", 0);
+	for(i = 0; i < numInserts; i += 97)
+	{
+		TEST_CHECK(getRecord(table, records[i]->id, r));
+		ASSERT_EQUALS_RECORDS(records[i], r, schema, "batch record read back");
+	}
+
+	// a later batch first fills the freed slots, then goes on at the end
+	TEST_CHECK(deleteRecord(table, records[5]->id));
+	TEST_CHECK(deleteRecord(table, records[slotsPerPage + 2]->id));
+	TEST_CHECK(insertRecords(table, records, numRefill));
+	ASSERT_TRUE(records[0]->id.page == 1 && records[0]->id.slot == 5, "first freed slot reused");
+	ASSERT_TRUE(records[1]->id.page == 2 && records[1]->id.slot == 2, "second freed slot reused");
+	ASSERT_TRUE(records[2]->id.page == 1 + (numInserts - 1) / slotsPerPage, "last record at the end");
+	ASSERT_EQUALS_INT(numInserts - 2 + numRefill, getNumTuples(table), "tuple count after the second batch");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_i"));
+	TEST_CHECK(shutdownRecordManager());
+
+	for(i = 0; i < numInserts; i++)
+		freeRecord(records[i]);
+	freeRecord(r);
+	free(records);
+	free(table);
+	freeSchema(schema);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testBulkLoad(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	int numLoads = 5000, numInserts = 10, i, found = 0, slotsPerPage = 0;
+	Record **records, *r;
+	Schema *schema;
+	Expr *sel, *left, *right;
+	RC rc;
+	testName = "test loading records without the buffer pool";
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numLoads);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_l",schema));
+	TEST_CHECK(openTable(table, "test_table_l"));
+
+	// a few records through the pool, then the load goes on after the last page
+	for(i = 0; i < numLoads; i++)
+		records[i] = testRecord(schema, i, "aaaa", 3);
+	TEST_CHECK(insertRecords(table, records, numInserts));
+	TEST_CHECK(bulkLoadRecords(table, records + numInserts, numLoads - numInserts));
+	ASSERT_EQUALS_INT(numLoads, getNumTuples(table), "tuple count after the load");
+	while (records[numInserts + slotsPerPage]->id.page == 2)
+		slotsPerPage++;
+	for(i = numInserts; i < numLoads; i++)
+	{
+		ASSERT_TRUE(records[i]->id.page == 2 + (i - numInserts) / slotsPerPage
+				&& records[i]->id.slot == (i - numInserts) % slotsPerPage, "RID of a loaded record");
+	}
+
+	// loaded records are read through the pool and found by scans
+	r = testRecord(schema, 0, "", 0);
+	for(i = 0; i < numLoads; i += 331)
+	{
+		TEST_CHECK(getRecord(table, records[i]->id, r));
+		ASSERT_EQUALS_RECORDS(records[i], r, schema, "loaded record read back");
+	}
+	MAKE_CONS(left, stringToValue("i3"));
+	MAKE_ATTRREF(right, 2);
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+	TEST_CHECK(startScan(table, sc, sel));
+	while((rc = next(sc, r)) == RC_OK)
+		found++;
+	ASSERT_TRUE(rc == RC_RM_NO_MORE_TUPLES, "scan ended");
+	ASSERT_EQUALS_INT(numLoads, found, "all loaded records scanned");
+	TEST_CHECK(closeScan(sc));
+
+	// the free-space map knows the loaded pages, inserts fill the first page and then the last loaded one
+	TEST_CHECK(insertRecord(table, r));
+	ASSERT_EQUALS_INT(1, r->id.page, "insert into the first page");
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_l"));
+	ASSERT_EQUALS_INT(numLoads + 1, getNumTuples(table), "tuple count kept in the table header");
+	TEST_CHECK(getRecord(table, records[numLoads - 1]->id, r));
+	ASSERT_EQUALS_RECORDS(records[numLoads - 1], r, schema, "last loaded record after reopening");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_l"));
+	TEST_CHECK(shutdownRecordManager());
+
+	for(i = 0; i < numLoads; i++)
+		freeRecord(records[i]);
+	freeRecord(r);
+	free(records);
+	free(table);
+	free(sc);
+	freeSchema(schema);
+	freeExpr(sel);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testScanPagePin(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	int numInserts = 1000, i, found = 0;
+	Record **records, *r;
+	Schema *schema;
+	Expr *sel, *left, *right;
+	RC rc;
+	testName = "test scans keeping the current page pinned";
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numInserts);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_p",schema));
+	TEST_CHECK(openTable(table, "test_table_p"));
+	for(i = 0; i < numInserts; i++)
+		records[i] = testRecord(schema, i, "aaaa", i % 2);
+	TEST_CHECK(insertRecords(table, records, numInserts));
+
+	MAKE_CONS(left, stringToValue("i1"));
+	MAKE_ATTRREF(right, 2);
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+	r = testRecord(schema, 0, "", 0);
+
+	// the page of the last record returned stays pinned, records of it can still be changed
+	TEST_CHECK(startScan(table, sc, sel));
+	TEST_CHECK(next(sc, r));
+	ASSERT_EQUALS_INT(1, r->id.slot, "first match");
+	ASSERT_TRUE(closeTable(table) == RC_PINNED_PAGES_IN_BUFFER, "page pinned between calls");
+	TEST_CHECK(deleteRecord(table, records[3]->id));
+	TEST_CHECK(next(sc, r));
+	ASSERT_EQUALS_INT(5, r->id.slot, "deleted record skipped");
+
+	// closing the scan before its end unpins the page
+	TEST_CHECK(closeScan(sc));
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_p"));
+
+	// a scan run to its end holds no page, however few records match
+	TEST_CHECK(startScan(table, sc, sel));
+	while((rc = next(sc, r)) == RC_OK)
+		found++;
+	ASSERT_TRUE(rc == RC_RM_NO_MORE_TUPLES, "scan ended");
+	ASSERT_EQUALS_INT(numInserts / 2 - 1, found, "matches of all pages");
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(closeScan(sc));
+	TEST_CHECK(deleteTable("test_table_p"));
+	TEST_CHECK(shutdownRecordManager());
+
+	for(i = 0; i < numInserts; i++)
+		freeRecord(records[i]);
+	freeRecord(r);
+	free(records);
+	free(table);
+	free(sc);
+	freeSchema(schema);
+	freeExpr(sel);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testNextBatch(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	int numInserts = 1000, i, found = 0, batches = 0;
+	Record **records, *r;
+	RecordBatch *batch;
+	RID *rids;
+	Schema *schema;
+	Expr *sel, *left, *right;
+	RC rc;
+	testName = "test scans returning batches of records";
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numInserts);
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_n",schema));
+	TEST_CHECK(openTable(table, "test_table_n"));
+	for(i = 0; i < numInserts; i++)
+		records[i] = testRecord(schema, i, "aaaa", i % 3);
+	TEST_CHECK(insertRecords(table, records, numInserts));
+
+	MAKE_CONS(left, stringToValue("i0"));
+	MAKE_ATTRREF(right, 2);
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+	r = testRecord(schema, 0, "", 0);
+
+	// the records next() returns, in order
+	TEST_CHECK(startScan(table, sc, sel));
+	while((rc = next(sc, r)) == RC_OK)
+		rids[found++] = r->id;
+	ASSERT_TRUE(rc == RC_RM_NO_MORE_TUPLES, "scan ended");
+	TEST_CHECK(closeScan(sc));
+
+	// batches return the same records, each with its RID and data
+	TEST_CHECK(createRecordBatch(&batch, schema, 64));
+	TEST_CHECK(startScan(table, sc, sel));
+	i = 0;
+	while((rc = nextBatch(sc, batch, 50)) == RC_OK)
+	{
+		ASSERT_TRUE(batch->numRecords > 0 && batch->numRecords <= 50, "rows of a batch");
+		for(int j = 0; j < batch->numRecords; j++, i++)
+		{
+			Record *expected = records[3 * i];
+			ASSERT_TRUE(batch->records[j].id.page == rids[i].page && batch->records[j].id.slot == rids[i].slot, "RID of a batch row");
+			ASSERT_EQUALS_RECORDS(expected, &batch->records[j], schema, "data of a batch row");
+		}
+		batches++;
+	}
+	ASSERT_TRUE(rc == RC_RM_NO_MORE_TUPLES, "batches ended");
+	ASSERT_EQUALS_INT(found, i, "all records in batches");
+	ASSERT_EQUALS_INT((found + 49) / 50, batches, "full batches");
+
+	// after the end the scan starts over
+	TEST_CHECK(nextBatch(sc, batch, 1000));
+	ASSERT_EQUALS_INT(64, batch->numRecords, "batch limited by its capacity");
+	ASSERT_TRUE(batch->records[0].id.page == rids[0].page && batch->records[0].id.slot == rids[0].slot, "scan started over");
+
+	// next() goes on after the last record of the batch
+	TEST_CHECK(next(sc, r));
+	ASSERT_TRUE(r->id.page == rids[64].page && r->id.slot == rids[64].slot, "next() after a batch");
+	TEST_CHECK(closeScan(sc));
+	TEST_CHECK(freeRecordBatch(batch));
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_n"));
+	TEST_CHECK(shutdownRecordManager());
+
+	for(i = 0; i < numInserts; i++)
+		freeRecord(records[i]);
+	freeRecord(r);
+	free(records);
+	free(rids);
+	free(table);
+	free(sc);
+	freeSchema(schema);
+	freeExpr(sel);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testFreedPages(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	TestRecord insert = {1, "aaaa", 3};
+	int numInserts = 1000, i, found, lastPage, slotsPerPage = 0;
+	Record *r;
+	RID *rids;
+	Schema *schema;
+	SM_FileHandle fh;
+	Expr *sel;
+	testName = "test pages without records given back to the page file";
+	schema = testSchema();
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_g",schema));
+	TEST_CHECK(openTable(table, "test_table_g"));
+	for(i = 0; i < numInserts; i++)
+	{
+		insert.a = i;
+		r = fromTestRecord(schema, insert);
+		TEST_CHECK(insertRecord(table,r));
+		rids[i] = r->id;
+		freeRecord(r);
+	}
+	while (rids[slotsPerPage].page == 1)
+		slotsPerPage++;
+	lastPage = rids[numInserts - 1].page;
+	TEST_CHECK(openPageFile("test_table_g", &fh));
+	ASSERT_EQUALS_INT(lastPage + 1, fh.totalNumPages, "pages of the table");
+	TEST_CHECK(closePageFile(&fh));
+
+	// deleting every record of the last page cuts it off the file, an emptied page in the middle is marked free
+	for(i = 0; i < numInserts; i++)
+		if (rids[i].page == lastPage || rids[i].page == 2)
+			TEST_CHECK(deleteRecord(table, rids[i]));
+	TEST_CHECK(openPageFile("test_table_g", &fh));
+	ASSERT_EQUALS_INT(lastPage, fh.totalNumPages, "trailing empty page cut off");
+	ASSERT_TRUE(isPageFree(2, &fh), "emptied page in the middle freed");
+	TEST_CHECK(closePageFile(&fh));
+
+	// scans pass the freed page by and see every remaining record
+	MAKE_CONS(sel, stringToValue("bt"));
+	r = fromTestRecord(schema, insert);
+	found = 0;
+	TEST_CHECK(startScan(table, sc, sel));
+	while(next(sc, r) == RC_OK)
+		if (r->id.page != 2 && r->id.page != lastPage)
+			found++;
+	TEST_CHECK(closeScan(sc));
+	ASSERT_EQUALS_INT(numInserts - slotsPerPage - (numInserts - 1) % slotsPerPage - 1, getNumTuples(table), "records of the freed pages deleted");
+	ASSERT_EQUALS_INT(getNumTuples(table), found, "all remaining records scanned on live pages");
+
+	// with the other pages full the freed page is allocated again, also after reopening
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_g"));
+	TEST_CHECK(insertRecord(table,r));
+	ASSERT_EQUALS_INT(2, r->id.page, "freed page reused");
+	ASSERT_EQUALS_INT(0, r->id.slot, "first slot of the reused page");
+	TEST_CHECK(openPageFile("test_table_g", &fh));
+	ASSERT_TRUE(!isPageFree(2, &fh), "reused page in use");
+	TEST_CHECK(closePageFile(&fh));
+	freeRecord(r);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_g"));
+	TEST_CHECK(shutdownRecordManager());
+
+	free(table);
+	free(sc);
+	free(rids);
+	freeSchema(schema);
+	freeExpr(sel);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testStaleFreeSpaceMap(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	int numInserts = 1000, i, found, numPages, empty, one, two;
+	Record **records, *r;
+	Schema *schema;
+	SM_FileHandle fh;
+	Expr *sel;
+	char *page = (char *) calloc(PAGE_SIZE, sizeof(char));
+	testName = "test free-space map left behind by a table that was not closed";
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numInserts);
+	for(i = 0; i < numInserts; i++)
+		records[i] = testRecord(schema, i, "aaaa", 3);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_c",schema));
+
+	// the map file is marked open while the table is open
+	TEST_CHECK(openTable(table, "test_table_c"));
+	TEST_CHECK(openPageFile("test_table_c.fsm", &fh));
+	TEST_CHECK(readBlock(0, &fh, page));
+	ASSERT_EQUALS_INT(-1, ((int *) page)[0], "map marked open");
+	TEST_CHECK(closePageFile(&fh));
+
+	// the entry of an empty page, from the entries of a page with one and with two records
+	for (i = 0; i < 2; i++)
+	{
+		TEST_CHECK(insertRecords(table, records + i, 1));
+		TEST_CHECK(closeTable(table));
+		TEST_CHECK(openPageFile("test_table_c.fsm", &fh));
+		TEST_CHECK(readBlock(0, &fh, page));
+		if (i == 0)
+			one = ((int *) page)[1 + 1];
+		else
+			two = ((int *) page)[1 + 1];
+		TEST_CHECK(closePageFile(&fh));
+		TEST_CHECK(openTable(table, "test_table_c"));
+	}
+	empty = 2 * one - two;
+	TEST_CHECK(insertRecords(table, records + 2, numInserts - 2));
+	TEST_CHECK(closeTable(table));
+
+	// a map saved by closeTable is trusted, pages it claims to be empty are not read
+	MAKE_CONS(sel, stringToValue("bt"));
+	r = testRecord(schema, 0, "", 0);
+	for (int crashed = 0; crashed < 2; crashed++)
+	{
+		TEST_CHECK(openPageFile("test_table_c.fsm", &fh));
+		TEST_CHECK(readBlock(0, &fh, page));
+		ASSERT_TRUE(((int *) page)[0] > 0, "map closed with the table");
+		numPages = ((int *) page)[0];
+		for(i = 1; i < numPages; i++)
+			((int *) page)[1 + i] = empty;
+		if (crashed)
+			((int *) page)[0] = -1;
+		TEST_CHECK(writeBlock(0, &fh, page));
+		TEST_CHECK(closePageFile(&fh));
+
+		TEST_CHECK(openTable(table, "test_table_c"));
+		found = 0;
+		TEST_CHECK(startScan(table, sc, sel));
+		while(next(sc, r) == RC_OK)
+			found++;
+		TEST_CHECK(closeScan(sc));
+		if (crashed)
+			ASSERT_EQUALS_INT(numInserts, found, "map left open by a crash not trusted");
+		else
+			ASSERT_EQUALS_INT(0, found, "pages claimed empty by a closed map skipped");
+		TEST_CHECK(closeTable(table));
+	}
+
+	TEST_CHECK(deleteTable("test_table_c"));
+	TEST_CHECK(shutdownRecordManager());
+
+	for(i = 0; i < numInserts; i++)
+		freeRecord(records[i]);
+	freeRecord(r);
+	free(records);
+	free(page);
+	free(table);
+	free(sc);
+	freeSchema(schema);
+	freeExpr(sel);
+	TEST_DONE();
+}
+
+// ************************************************************
+void
+testScanProjection(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	int numInserts = 300, i, found = 0, evens = 0;
+	int attrs[] = { 2, 0 };
+	int returnedAttrs[] = { 1, 2 };
+	int badAttrs[] = { 3 };
+	Record **records, *r;
+	RecordBatch *batch;
+	Schema *schema, *projected;
+	Expr *sel, *returnedSel, *left, *right;
+	Value *value;
+	RC rc;
+	testName = "test scans returning only some attributes";
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numInserts);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_o",schema));
+	TEST_CHECK(openTable(table, "test_table_o"));
+	for(i = 0; i < numInserts; i++)
+		records[i] = testRecord(schema, i, i % 2 == 0 ? "even" : "odd", i % 7);
+	TEST_CHECK(insertRecords(table, records, numInserts));
+
+	// the condition reads attribute b, which is not returned
+	MAKE_CONS(left, stringToValue("seven"));
+	MAKE_ATTRREF(right, 1);
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+
+	ASSERT_TRUE(startScanWithProjection(table, sc, sel, badAttrs, 1) == RC_INVALID_PARAMETER, "attribute out of range");
+
+	// the projected schema has c and a in the order asked for
+	TEST_CHECK(startScanWithProjection(table, sc, sel, attrs, 2));
+	projected = getScanSchema(sc);
+	ASSERT_EQUALS_INT(2, projected->numAttr, "attributes of the projected schema");
+	ASSERT_TRUE(strcmp(projected->attrNames[0], "c") == 0 && strcmp(projected->attrNames[1], "a") == 0, "names of the projected schema");
+	ASSERT_EQUALS_INT((int) (1 + 2 * sizeof(int)), getRecordSize(projected), "size of a projected record");
+
+	TEST_CHECK(createRecord(&r, projected));
+	while((rc = next(sc, r)) == RC_OK)
+	{
+		int a, c;
+		TEST_CHECK(getAttr(r, projected, 0, &value));
+		c = value->v.intV;
+		freeVal(value);
+		TEST_CHECK(getAttr(r, projected, 1, &value));
+		a = value->v.intV;
+		freeVal(value);
+		ASSERT_TRUE(a == 2 * found && c == a % 7, "values of a projected record");
+		ASSERT_TRUE(r->id.page == records[a]->id.page && r->id.slot == records[a]->id.slot, "RID of a projected record");
+		found++;
+	}
+	ASSERT_TRUE(rc == RC_RM_NO_MORE_TUPLES, "scan ended");
+	ASSERT_EQUALS_INT(numInserts / 2, found, "all matching records");
+
+	// batches of the projected schema hold the same records
+	TEST_CHECK(createRecordBatch(&batch, projected, 32));
+	i = 0;
+	while((rc = nextBatch(sc, batch, 32)) == RC_OK)
+	{
+		for(int j = 0; j < batch->numRecords; j++, i++)
+		{
+			TEST_CHECK(getAttr(&batch->records[j], projected, 1, &value));
+			ASSERT_EQUALS_INT(2 * i, value->v.intV, "attribute of a batch row");
+			freeVal(value);
+		}
+	}
+	ASSERT_TRUE(rc == RC_RM_NO_MORE_TUPLES, "batches ended");
+	ASSERT_EQUALS_INT(found, i, "all records in batches");
+	TEST_CHECK(freeRecordBatch(batch));
+	TEST_CHECK(closeScan(sc));
+
+	// a condition on a returned attribute reads the returned record, strings come back padded
+	MAKE_CONS(left, stringToValue("i3"));
+	MAKE_ATTRREF(right, 2);
+	MAKE_BINOP_EXPR(returnedSel, left, right, OP_COMP_EQUAL);
+	TEST_CHECK(startScanWithProjection(table, sc, returnedSel, returnedAttrs, 2));
+	projected = getScanSchema(sc);
+	freeRecord(r);
+	TEST_CHECK(createRecord(&r, projected));
+	memset(r->data, 'x', getRecordSize(projected));
+	found = 0;
+	while((rc = next(sc, r)) == RC_OK)
+	{
+		TEST_CHECK(getAttr(r, projected, 1, &value));
+		ASSERT_EQUALS_INT(3, value->v.intV, "returned attribute of the condition");
+		freeVal(value);
+		ASSERT_TRUE(memcmp(r->data + 1, "even", 4) == 0 || memcmp(r->data + 1, "odd\0", 4) == 0, "string padded with zeros");
+		if (memcmp(r->data + 1, "even", 4) == 0)
+			evens++;
+		found++;
+	}
+	ASSERT_EQUALS_INT(43, found, "records matching a returned attribute");
+	ASSERT_EQUALS_INT(21, evens, "strings of the matching records");
+	TEST_CHECK(closeScan(sc));
+
+	// a scan without projection returns whole records
+	TEST_CHECK(startScan(table, sc, sel));
+	ASSERT_TRUE(getScanSchema(sc) == table->schema, "schema of a scan without projection");
+	TEST_CHECK(closeScan(sc));
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_o"));
+	TEST_CHECK(shutdownRecordManager());
+
+	for(i = 0; i < numInserts; i++)
+		freeRecord(records[i]);
+	freeRecord(r);
+	free(records);
+	free(table);
+	free(sc);
+	freeSchema(schema);
+	freeExpr(sel);
+	freeExpr(returnedSel);
+	TEST_DONE();
+}
+
+// ************************************************************
+// memory files that cannot grow while fullDevice is set, looked up before the memory backend
+static bool fullDevice = false;
+static SM_Backend fullBackend;
+
+static bool
+fullExists (char *fileName)
+{
+	return fullDevice && memoryBackend.exists(fileName);
+}
+
+static RC
+fullWrite (void *device, long offset, const void *data, long length)
+{
+	if (offset + length > memoryBackend.size(device))
+		return RC_WRITE_FAILED;
+	return memoryBackend.write(device, offset, data, length);
+}
+
+static RC
+fullResize (void *device, long size)
+{
+	if (size > memoryBackend.size(device))
+		return RC_WRITE_FAILED;
+	return memoryBackend.resize(device, size);
+}
+
+void
+testFailedMove(void)
+{
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+	char *names[] = { "a", "b", "c" };
+	DataType dt[] = { DT_INT, DT_STRING, DT_INT };
+	int sizes[] = { 0, 200, 0 };
+	char **cpNames = (char **) malloc(sizeof(char*) * 3);
+	DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 3);
+	int *cpSizes = (int *) malloc(sizeof(int) * 3);
+	int *cpKeys = (int *) calloc(1, sizeof(int));
+	char midString[100], longString[200];
+	int numInserts = 500, i, filled = 0, found = 0;
+	Record *r, *moved, *grown, *kept;
+	RID *rids;
+	Schema *schema;
+	Expr *sel;
+	RC rc;
+	testName = "test a record that cannot be moved keeps its old value";
+
+	for(i = 0; i < 3; i++)
+	{
+		cpNames[i] = (char *) malloc(2);
+		strcpy(cpNames[i], names[i]);
+	}
+	memcpy(cpDt, dt, sizeof(DataType) * 3);
+	memcpy(cpSizes, sizes, sizeof(int) * 3);
+	schema = createSchema(3, cpNames, cpDt, cpSizes, 1, cpKeys);
+	rids = (RID *) malloc(sizeof(RID) * numInserts);
+	memset(midString, 'x', sizeof(midString) - 1);
+	midString[sizeof(midString) - 1] = '\0';
+	memset(longString, 'y', sizeof(longString) - 1);
+	longString[sizeof(longString) - 1] = '\0';
+	fullBackend = memoryBackend;
+	fullBackend.name = "full";
+	fullBackend.exists = fullExists;
+	fullBackend.write = fullWrite;
+	fullBackend.resize = fullResize;
+	TEST_CHECK(registerBackend(&fullBackend));
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTableWithFlags("test_table_f", schema, PAGE_SIZE, SM_IN_MEMORY));
+	TEST_CHECK(openTable(table, "test_table_f"));
+	for(i = 0; i < numInserts; i++)
+	{
+		r = testRecord(schema, i, "ab", 3);
+		TEST_CHECK(insertRecord(table,r));
+		rids[i] = r->id;
+		freeRecord(r);
+	}
+
+	// move the first record off its full page
+	moved = testRecord(schema, 0, midString, 3);
+	moved->id = rids[0];
+	TEST_CHECK(updateRecord(table, moved));
+
+	// once the file cannot grow, inserts fill the room left on the pages and then fail
+	fullDevice = true;
+	r = testRecord(schema, numInserts, "ab", 3);
+	while((rc = insertRecord(table, r)) == RC_OK)
+		filled++;
+	ASSERT_TRUE(rc != RC_OK, "table cannot grow");
+
+	// neither the moved record nor a record at home can move again, both keep their old value
+	grown = testRecord(schema, 0, longString, 3);
+	grown->id = rids[0];
+	ASSERT_TRUE(updateRecord(table, grown) != RC_OK, "moved record cannot move again");
+	TEST_CHECK(getRecord(table, rids[0], r));
+	ASSERT_EQUALS_RECORDS(moved, r, schema, "moved record kept");
+	kept = testRecord(schema, 1, "ab", 3);
+	grown->id = kept->id = rids[1];
+	ASSERT_TRUE(updateRecord(table, grown) != RC_OK, "record at home cannot move");
+	TEST_CHECK(getRecord(table, rids[1], r));
+	ASSERT_EQUALS_RECORDS(kept, r, schema, "record at home kept");
+	MAKE_CONS(sel, stringToValue("bt"));
+	TEST_CHECK(startScan(table, sc, sel));
+	while(next(sc, r) == RC_OK)
+		found++;
+	TEST_CHECK(closeScan(sc));
+	ASSERT_EQUALS_INT(numInserts + filled, found, "every record scanned after the failed moves");
+
+	// with room again the move goes through, a scan returns every record once
+	fullDevice = false;
+	grown->id = rids[0];
+	TEST_CHECK(updateRecord(table, grown));
+	TEST_CHECK(getRecord(table, rids[0], r));
+	ASSERT_EQUALS_RECORDS(grown, r, schema, "moved record moved again");
+	found = 0;
+	TEST_CHECK(startScan(table, sc, sel));
+	while(next(sc, r) == RC_OK)
+		found++;
+	TEST_CHECK(closeScan(sc));
+	ASSERT_EQUALS_INT(numInserts + filled, found, "every record scanned once");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_f"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeRecord(r);
+	freeRecord(moved);
+	freeRecord(grown);
+	freeRecord(kept);
+	free(table);
+	free(sc);
+	free(rids);
+	freeSchema(schema);
+	freeExpr(sel);
+	TEST_DONE();
+}
+
 Schema *
 testSchema (void)
 {
@@ -711,4 +1805,4 @@ testRecord(Schema *schema, int a, char *b, int c)
 	freeVal(value);
 
 	return result;
-}
\ No newline at end of file
+}
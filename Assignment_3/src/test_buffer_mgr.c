@@ -0,0 +1,1345 @@
+#include "storage_mgr.h"
+#include "buffer_mgr_stat.h"
+#include "buffer_mgr.h"
+#include "dberror.h"
+#include "test_helper.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+// var to store the current test's name
+char *testName;
+
+// check whether two the content of a buffer pool is the same as an expected content
+// (given in the format produced by sprintPoolContent)
+#define ASSERT_EQUALS_POOL(expected,bm,message)			        \
+  do {									\
+    char *real;								\
+    char *_exp = (char *) (expected);                                   \
+    real = sprintPoolContent(bm);					\
+    if (strcmp((_exp),real) != 0)					\
+      {									\
+	printf("[%s-%s-L%i-%s] FAILED: expected <%s> but was <%s>: %s\n",TEST_INFO, _exp, real, message); \
+	free(real);							\
+	exit(1);							\
+      }									\
+    printf("[%s-%s-L%i-%s] OK: expected <%s> and was <%s>: %s\n",TEST_INFO, _exp, real, message); \
+    free(real);								\
+  } while(0)
+
+// test and helper methods
+static void createDummyFile (char *fileName, int num);
+
+static void testWarmup (void);
+static void testPinPages (void);
+static void testPinPageAsync (void);
+static void testPinPageAsyncStale (void);
+static void testEvictionHints (void);
+static void testPoolStats (void);
+static void testPoolTrace (void);
+static void testAdaptiveStrategy (void);
+static void testVictimCache (void);
+static void testSharedPool (void);
+static void testPageMemory (void);
+static void testFreePageMap (void);
+static void testFreeMapGrowth (void);
+static void testPageSize (void);
+static void testCompressedPageFile (void);
+static void testCompressedFileGrowth (void);
+static void testAccessAdvice (void);
+static void testMemoryBackend (void);
+static void testWriteBlocks (void);
+static void testClockAllPinned (void);
+static void testPoolsSideBySide (void);
+
+// main method
+int
+main (void)
+{
+  initStorageManager();
+  testName = "";
+
+  testWarmup();
+  testPinPages();
+  testPinPageAsync();
+  testPinPageAsyncStale();
+  testEvictionHints();
+  testPoolStats();
+  testPoolTrace();
+  testAdaptiveStrategy();
+  testVictimCache();
+  testSharedPool();
+  testPageMemory();
+  testFreePageMap();
+  testFreeMapGrowth();
+  testPageSize();
+  testCompressedPageFile();
+  testCompressedFileGrowth();
+  testAccessAdvice();
+  testMemoryBackend();
+  testWriteBlocks();
+  testClockAllPinned();
+  testPoolsSideBySide();
+
+  return 0;
+}
+
+// create a page file with n pages with content "Page X"
+void
+createDummyFile (char *fileName, int num)
+{
+  SM_FileHandle fh;
+  char *page = calloc(PAGE_SIZE, sizeof(char));
+  int i;
+
+  CHECK(createPageFile(fileName));
+  CHECK(openPageFile(fileName, &fh));
+  CHECK(ensureCapacity(num, &fh));
+
+  for (i = 0; i < num; i++)
+    {
+      sprintf(page, "%s-%i", "Page", i);
+      CHECK(writeBlock(i, &fh, page));
+    }
+
+  CHECK(closePageFile(&fh));
+  free(page);
+}
+
+// check that a pool shut down with warm-up enabled comes back with the same pages resident
+void
+testWarmup (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  FILE *sidecar;
+  int i;
+  testName = "Warming up the buffer pool from the previous shutdown";
+
+  createDummyFile("testbuffer.bin", 6);
+
+  // touch pages 0 to 5, pages 3, 4 and 5 stay resident
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+  for (i = 0; i < 6; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      CHECK(unpinPage(bm, h));
+    }
+  ASSERT_EQUALS_POOL("[3 0],[4 0],[5 0]", bm, "check pool content before shutdown");
+  CHECK(setBufferPoolWarmup(bm, TRUE));
+  CHECK(shutdownBufferPool(bm));
+
+  sidecar = fopen("testbuffer.bin.warm", "rb");
+  ASSERT_TRUE(sidecar != NULL, "warm-up file written on shutdown");
+  fclose(sidecar);
+
+  // the restarted pool holds the pages before the first pin
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+  ASSERT_EQUALS_POOL("[3 0],[4 0],[5 0]", bm, "check pool content after warm-up");
+  ASSERT_TRUE(fopen("testbuffer.bin.warm", "rb") == NULL, "warm-up file consumed");
+
+  CHECK(pinPage(bm, h, 4));
+  ASSERT_EQUALS_STRING("Page-4", h->data, "prefetched page content");
+  CHECK(unpinPage(bm, h));
+
+  // the least recently used page before the restart is evicted first
+  CHECK(pinPage(bm, h, 0));
+  CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_POOL("[0 0],[4 0],[5 0]", bm, "check recency order survived the restart");
+  CHECK(shutdownBufferPool(bm));
+
+  // a FIFO pool gets its frames back in the order the pages came in, not in page order
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+  for (i = 5; i >= 3; i--)
+    {
+      CHECK(pinPage(bm, h, i));
+      CHECK(unpinPage(bm, h));
+    }
+  CHECK(setBufferPoolWarmup(bm, TRUE));
+  CHECK(shutdownBufferPool(bm));
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+  ASSERT_EQUALS_POOL("[5 0],[4 0],[3 0]", bm, "check FIFO order after warm-up");
+  CHECK(pinPage(bm, h, 0));
+  CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_POOL("[0 0],[4 0],[3 0]", bm, "first page in before the restart is evicted first");
+
+  // without warm-up enabled no file is written
+  CHECK(shutdownBufferPool(bm));
+  ASSERT_TRUE(fopen("testbuffer.bin.warm", "rb") == NULL, "no warm-up file without warm-up enabled");
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// pin a batch of hits and misses with one call and check every handle
+void
+testPinPages (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageHandle handles[4];
+  PageNumber pageNums[] = { 2, 5, 3, 7 };
+  char expected[32], shmName[64];
+  int i, pins, shared, *fixCounts;
+  testName = "Pinning several pages with one call";
+
+  createDummyFile("testbuffer.bin", 8);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 4, RS_LRU, NULL));
+
+  // page 5 is a hit, pages 2, 3 and 7 are misses
+  CHECK(pinPage(bm, h, 5));
+  CHECK(unpinPage(bm, h));
+
+  CHECK(pinPages(bm, handles, pageNums, 4));
+  ASSERT_EQUALS_POOL("[5 1],[2 1],[3 1],[7 1]", bm, "check pool content after batch pin");
+
+  for (i = 0; i < 4; i++)
+    {
+      sprintf(expected, "%s-%i", "Page", pageNums[i]);
+      ASSERT_EQUALS_INT(pageNums[i], handles[i].pageNum, "page number of handle");
+      ASSERT_EQUALS_STRING(expected, handles[i].data, "page content of handle");
+      CHECK(unpinPage(bm, &handles[i]));
+    }
+
+  // a batch larger than the pool is rejected
+  ASSERT_ERROR(pinPages(bm, handles, pageNums, 5), "batch larger than the pool");
+
+  // a batch that does not fit next to a pinned page fails and keeps none of its pins
+  for (shared = 0; shared < 2; shared++)
+    {
+      CHECK(pinPage(bm, h, 0));
+      ASSERT_ERROR(pinPages(bm, handles, pageNums, 4), "batch does not fit");
+      fixCounts = getFixCounts(bm);
+      for (i = 0, pins = 0; i < 4; i++)
+        pins += fixCounts[i];
+      free(fixCounts);
+      ASSERT_EQUALS_INT(1, pins, "only the page pinned before the batch stays pinned");
+      CHECK(unpinPage(bm, h));
+      CHECK(shutdownBufferPool(bm));
+
+      // the same holds for a shared pool
+      if (shared == 0)
+        {
+          sprintf(shmName, "/testbuffer-%i", (int) getpid());
+          CHECK(initSharedBufferPool(bm, "testbuffer.bin", 4, RS_LRU, shmName));
+        }
+    }
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// issue several pins without waiting, then await them
+void
+testPinPageAsync (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PinRequest requests[3];
+  PageNumber pageNums[] = { 4, 1, 6 };
+  char expected[32];
+  int i;
+  testName = "Pinning pages asynchronously";
+
+  createDummyFile("testbuffer.bin", 8);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+
+  // page 1 is a hit and completes right away
+  CHECK(pinPage(bm, h, 1));
+  CHECK(unpinPage(bm, h));
+
+  for (i = 0; i < 3; i++)
+    CHECK(pinPageAsync(bm, &requests[i], pageNums[i]));
+  ASSERT_TRUE(pollPinRequest(bm, &requests[1]), "hit is complete when issued");
+
+  for (i = 0; i < 3; i++)
+    {
+      CHECK(awaitPinRequest(bm, &requests[i], h));
+      ASSERT_TRUE(pollPinRequest(bm, &requests[i]), "request is complete after await");
+      sprintf(expected, "%s-%i", "Page", pageNums[i]);
+      ASSERT_EQUALS_INT(pageNums[i], h->pageNum, "page number of handle");
+      ASSERT_EQUALS_STRING(expected, h->data, "page content of handle");
+    }
+  ASSERT_EQUALS_POOL("[1 1],[4 1],[6 1]", bm, "check pool content after awaiting");
+
+  for (i = 0; i < 3; i++)
+    {
+      h->pageNum = pageNums[i];
+      CHECK(unpinPage(bm, h));
+    }
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// a page written back while its asynchronous read is in flight is not installed with the old content
+void
+testPinPageAsyncStale (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PinRequest request;
+  char shmName[64];
+  int i;
+  testName = "Awaiting a pin whose page was written while in flight";
+
+  createDummyFile("testbuffer.bin", 6);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+
+  // the read completes with the old content, then page 3 is changed, evicted and written back
+  CHECK(pinPageAsync(bm, &request, 3));
+  while (!pollPinRequest(bm, &request))
+    ;
+  CHECK(pinPage(bm, h, 3));
+  sprintf(h->data, "%s", "Changed-3");
+  CHECK(markDirty(bm, h));
+  CHECK(unpinPage(bm, h));
+  for (i = 0; i < 3; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      CHECK(unpinPage(bm, h));
+    }
+  ASSERT_EQUALS_POOL("[2 0],[0 0],[1 0]", bm, "page 3 evicted");
+
+  CHECK(awaitPinRequest(bm, &request, h));
+  ASSERT_EQUALS_STRING("Changed-3", h->data, "awaited page has the written content");
+  CHECK(unpinPage(bm, h));
+  CHECK(shutdownBufferPool(bm));
+
+  // a shared pool compares its write-back counter under the latch
+  sprintf(shmName, "/testbuffer-%i", (int) getpid());
+  CHECK(initSharedBufferPool(bm, "testbuffer.bin", 3, RS_LRU, shmName));
+  CHECK(pinPageAsync(bm, &request, 4));
+  while (!pollPinRequest(bm, &request))
+    ;
+  CHECK(pinPage(bm, h, 4));
+  sprintf(h->data, "%s", "Changed-4");
+  CHECK(markDirty(bm, h));
+  CHECK(forcePage(bm, h));
+  CHECK(unpinPage(bm, h));
+  for (i = 0; i < 3; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      CHECK(unpinPage(bm, h));
+    }
+
+  CHECK(awaitPinRequest(bm, &request, h));
+  ASSERT_EQUALS_STRING("Changed-4", h->data, "awaited page of the shared pool has the written content");
+  CHECK(unpinPage(bm, h));
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// check that cold pages are reclaimed first and hot pages last
+void
+testEvictionHints (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  int i;
+  testName = "Eviction hints on unpinPage";
+
+  createDummyFile("testbuffer.bin", 8);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+
+  // page 0 is hot, page 2 is cold
+  CHECK(pinPage(bm, h, 0));
+  CHECK(unpinPageWithHint(bm, h, EH_KEEP_HOT));
+  CHECK(pinPage(bm, h, 1));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 2));
+  CHECK(unpinPageWithHint(bm, h, EH_EVICT_SOON));
+
+  // the cold page goes first although it is the most recently used one
+  CHECK(pinPage(bm, h, 3));
+  ASSERT_EQUALS_POOL("[0 0],[1 0],[3 1]", bm, "cold page reclaimed first");
+  CHECK(unpinPage(bm, h));
+
+  // the hot page stays although it is the least recently used one
+  for (i = 4; i < 6; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      CHECK(unpinPage(bm, h));
+    }
+  ASSERT_EQUALS_POOL("[0 0],[4 0],[5 0]", bm, "hot page kept");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// check the counters reported by getPoolStats
+void
+testPoolStats (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_Stats stats;
+  long reads = 0;
+  int i;
+  testName = "Buffer pool statistics";
+
+  createDummyFile("testbuffer.bin", 8);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+
+  // 4 misses, the last one evicts dirty page 0, then 1 hit
+  for (i = 0; i < 4; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      if (i == 0)
+        CHECK(markDirty(bm, h));
+      CHECK(unpinPage(bm, h));
+    }
+  CHECK(pinPage(bm, h, 2));
+  CHECK(unpinPage(bm, h));
+
+  CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(5, (int) stats.numPins, "number of pins");
+  ASSERT_EQUALS_INT(1, (int) stats.hits, "number of hits");
+  ASSERT_EQUALS_INT(4, (int) stats.misses, "number of misses");
+  ASSERT_EQUALS_INT(1, (int) stats.evictions, "number of evictions");
+  ASSERT_EQUALS_INT(1, (int) stats.dirtyEvictions, "number of dirty evictions");
+  ASSERT_EQUALS_INT(4, getNumReadIO(bm), "number of reads");
+  ASSERT_EQUALS_INT(1, getNumWriteIO(bm), "number of writes");
+
+  for (i = 0; i < BM_LATENCY_BUCKETS; i++)
+    reads += stats.readLatency[i];
+  ASSERT_EQUALS_INT(4, (int) reads, "reads in latency histogram");
+
+  CHECK(resetPoolStats(bm));
+  CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(0, (int) stats.numPins, "counters reset");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// check that every pin, unpin and markDirty is written to the trace file
+void
+testPoolTrace (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  unsigned int words[8];
+  FILE *trace;
+  int i;
+  testName = "Recording a buffer pool trace";
+
+  createDummyFile("testbuffer.bin", 4);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+  CHECK(startPoolTrace(bm, "testbuffer.trace"));
+
+  // 7 events: pin 1, mark dirty 1, unpin 1, pin 3, unpin 3, pin 1, unpin 1
+  CHECK(pinPage(bm, h, 1));
+  CHECK(markDirty(bm, h));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 3));
+  CHECK(unpinPage(bm, h));
+  CHECK(pinPage(bm, h, 1));
+  CHECK(unpinPage(bm, h));
+  CHECK(stopPoolTrace(bm));
+
+  // events after the trace was stopped are not recorded
+  CHECK(pinPage(bm, h, 2));
+  CHECK(unpinPage(bm, h));
+
+  trace = fopen("testbuffer.trace", "rb");
+  ASSERT_TRUE(trace != NULL, "trace file written");
+  ASSERT_EQUALS_INT(8, (int) fread(words, sizeof(unsigned int), 8, trace), "magic and 7 events");
+  fclose(trace);
+
+  ASSERT_TRUE(words[0] == BM_TRACE_MAGIC, "trace starts with the magic number");
+  ASSERT_EQUALS_INT(TRACE_PIN, BM_TRACE_OP(words[1]), "first event is a pin");
+  ASSERT_EQUALS_INT(1, BM_TRACE_PAGE(words[1]), "first event is on page 1");
+  ASSERT_EQUALS_INT(TRACE_MARK_DIRTY, BM_TRACE_OP(words[2]), "second event marks dirty");
+  ASSERT_EQUALS_INT(TRACE_UNPIN, BM_TRACE_OP(words[3]), "third event is an unpin");
+  for (i = 4; i < 8; i++)
+    ASSERT_EQUALS_INT((i == 4 || i == 5) ? 3 : 1, BM_TRACE_PAGE(words[i]), "page of event");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+  remove("testbuffer.trace");
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// run a pattern that LRU handles badly and check that the adaptive pool leaves LRU
+void
+testAdaptiveStrategy (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  PageNumber pattern[] = { 0, 1, 2, 3, 1, 0, 2, 3 };
+  BM_Stats stats;
+  char expected[32];
+  int i, round;
+  testName = "Adaptive replacement strategy";
+
+  createDummyFile("testbuffer.bin", 4);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_ADAPTIVE, NULL));
+  ASSERT_EQUALS_INT(RS_LRU, bm->strategy, "adaptive pool starts with LRU");
+
+  // on this pattern CLOCK misses least, then FIFO, then LRU
+  for (round = 0; round < 20; round++)
+    for (i = 0; i < 8; i++)
+      {
+        CHECK(pinPage(bm, h, pattern[i]));
+        sprintf(expected, "%s-%i", "Page", pattern[i]);
+        ASSERT_EQUALS_STRING(expected, h->data, "page content after switching");
+        CHECK(unpinPage(bm, h));
+      }
+
+  ASSERT_EQUALS_INT(RS_CLOCK, bm->strategy, "adaptive pool switched to CLOCK");
+  CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(1, (int) stats.strategySwitches, "number of strategy switches");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// evicted pages come back from the compressed victim cache without reading the page file
+void
+testVictimCache (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_Stats stats;
+  char expected[32];
+  int i;
+  testName = "Compressed victim cache";
+
+  createDummyFile("testbuffer.bin", 6);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+  CHECK(setBufferPoolVictimCache(bm, 4 * PAGE_SIZE));
+
+  // page 0 is modified before it is evicted
+  CHECK(pinPage(bm, h, 0));
+  sprintf(h->data, "%s", "Changed-0");
+  CHECK(markDirty(bm, h));
+  CHECK(unpinPage(bm, h));
+  for (i = 1; i < 6; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      CHECK(unpinPage(bm, h));
+    }
+  ASSERT_EQUALS_POOL("[3 0],[4 0],[5 0]", bm, "pages 0 to 2 evicted");
+  ASSERT_EQUALS_INT(6, getNumReadIO(bm), "every page read once");
+
+  // pages 0 to 2 are served from the victim cache
+  for (i = 0; i < 3; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      if (i == 0)
+        sprintf(expected, "%s", "Changed-0");
+      else
+        sprintf(expected, "%s-%i", "Page", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "page content restored from the victim cache");
+      CHECK(unpinPage(bm, h));
+    }
+  ASSERT_EQUALS_INT(6, getNumReadIO(bm), "no read for pages in the victim cache");
+
+  CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(6, (int) stats.victimStores, "number of pages stored in the victim cache");
+  ASSERT_EQUALS_INT(3, (int) stats.victimHits, "number of victim cache hits");
+
+  // without a budget the cache is emptied and pages are read again
+  CHECK(setBufferPoolVictimCache(bm, 0));
+  CHECK(pinPage(bm, h, 3));
+  CHECK(unpinPage(bm, h));
+  ASSERT_EQUALS_INT(7, getNumReadIO(bm), "page read after disabling the victim cache");
+
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// a child process modifies a page through the shared pool, the parent sees the change without reading the file
+void
+testSharedPool (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  char shmName[64];
+  int *fixCounts;
+  int status;
+  pid_t child;
+  testName = "Buffer pool shared between processes";
+
+  createDummyFile("testbuffer.bin", 6);
+  sprintf(shmName, "/testbuffer-%i", (int) getpid());
+
+  CHECK(initSharedBufferPool(bm, "testbuffer.bin", 3, RS_LRU, shmName));
+  CHECK(pinPage(bm, h, 1));
+
+  // a segment of another size cannot be attached
+  {
+    BM_BufferPool other;
+    ASSERT_TRUE(initSharedBufferPool(&other, "testbuffer.bin", 4, RS_LRU, shmName) == RC_INVALID_PARAMETER,
+        "segment with a different number of frames rejected");
+  }
+
+  fflush(stdout);
+  child = fork();
+  if (child == 0)
+    {
+      BM_BufferPool *childPool = MAKE_POOL();
+      BM_PageHandle *childPage = MAKE_PAGE_HANDLE();
+
+      if (initSharedBufferPool(childPool, "testbuffer.bin", 3, RS_LRU, shmName) != RC_OK
+          || pinPage(childPool, childPage, 2) != RC_OK)
+        _exit(1);
+      sprintf(childPage->data, "%s", "Changed-2");
+      markDirty(childPool, childPage);
+      unpinPage(childPool, childPage);
+
+      // the child sees the page pinned by the parent without reading it
+      if (pinPage(childPool, childPage, 1) != RC_OK || getNumReadIO(childPool) != 1)
+        _exit(1);
+      unpinPage(childPool, childPage);
+      _exit(shutdownBufferPool(childPool) == RC_OK ? 0 : 1);
+    }
+
+  waitpid(child, &status, 0);
+  ASSERT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0, "child process used the shared pool");
+
+  // page 2 was loaded and changed by the child, which flushed it when it left the pool
+  ASSERT_EQUALS_POOL("[1 1],[2 0],[-1 0]", bm, "frames shared with the child");
+  CHECK(pinPage(bm, h, 2));
+  ASSERT_EQUALS_STRING("Changed-2", h->data, "page changed by the child");
+  ASSERT_EQUALS_INT(1, getNumReadIO(bm), "page of the child not read again");
+
+  fixCounts = getFixCounts(bm);
+  ASSERT_EQUALS_INT(1, fixCounts[1], "fix count of page 2");
+  free(fixCounts);
+
+  // pins of this process must be released before leaving the pool
+  ASSERT_TRUE(shutdownBufferPool(bm) == RC_PINNED_PAGES_IN_BUFFER, "shutdown with pinned pages");
+  CHECK(unpinPage(bm, h));
+  h->pageNum = 1;
+  CHECK(unpinPage(bm, h));
+  CHECK(shutdownBufferPool(bm));
+
+  // the segment is gone with the last process, the change is in the page file
+  ASSERT_TRUE(shm_open(shmName, O_RDONLY, 0) == -1, "segment removed by the last process");
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+  CHECK(pinPage(bm, h, 2));
+  ASSERT_EQUALS_STRING("Changed-2", h->data, "dirty page written back by the last process");
+  CHECK(unpinPage(bm, h));
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// small pools use regular pages, pools of at least one huge page ask for huge pages
+void
+testPageMemory (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PageMemory memory;
+  char expected[32];
+  int i;
+  testName = "Huge page backed frame arena";
+
+  createDummyFile("testbuffer.bin", 4);
+
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+  ASSERT_EQUALS_INT(PM_REGULAR, getPoolPageMemory(bm), "small pool uses regular pages");
+  CHECK(shutdownBufferPool(bm));
+
+  // 1024 frames make a 4 MB arena, which huge pages are requested for
+  CHECK(initBufferPool(bm, "testbuffer.bin", 1024, RS_LRU, NULL));
+  memory = getPoolPageMemory(bm);
+  printf("frame arena of 1024 frames: %s\n", memory == PM_HUGETLB ? "MAP_HUGETLB"
+      : (memory == PM_TRANSPARENT_HUGE ? "MADV_HUGEPAGE" : "regular pages"));
+
+  for (i = 0; i < 4; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      sprintf(expected, "%s-%i", "Page", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "page content in the arena");
+      CHECK(unpinPage(bm, h));
+    }
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// freed pages are reused by allocatePage and free pages at the end of the file are cut off
+void
+testFreePageMap (void)
+{
+  SM_FileHandle fh;
+  char *page = calloc(PAGE_SIZE, sizeof(char));
+  FILE *file;
+  long size;
+  int pageNum;
+  testName = "Free page map of the page file";
+
+  createDummyFile("testbuffer.bin", 6);
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  ASSERT_EQUALS_INT(6, fh.totalNumPages, "data pages of the file");
+  ASSERT_TRUE(!isPageFree(2, &fh), "written page is in use");
+
+  // a freed page in the middle stays in the file and is handed out again, zeroed
+  CHECK(freePage(2, &fh));
+  CHECK(freePage(3, &fh));
+  ASSERT_TRUE(isPageFree(2, &fh) && isPageFree(3, &fh), "pages 2 and 3 are free");
+  ASSERT_EQUALS_INT(6, fh.totalNumPages, "free pages in the middle are kept");
+  CHECK(allocatePage(&fh, &pageNum));
+  ASSERT_EQUALS_INT(2, pageNum, "lowest free page reused");
+  ASSERT_TRUE(!isPageFree(2, &fh), "reused page is in use");
+  CHECK(readBlock(2, &fh, page));
+  ASSERT_EQUALS_STRING("", page, "reused page is empty");
+  CHECK(closePageFile(&fh));
+
+  // the map is persistent, freeing the last page also cuts off page 3
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  ASSERT_TRUE(isPageFree(3, &fh), "free page survives reopening");
+  CHECK(freePage(5, &fh));
+  CHECK(freePage(4, &fh));
+  ASSERT_EQUALS_INT(3, fh.totalNumPages, "trailing free pages cut off");
+  ASSERT_TRUE(!isPageFree(3, &fh), "page past the end is not free");
+  CHECK(readBlock(1, &fh, page));
+  ASSERT_EQUALS_STRING("Page-1", page, "live page unchanged");
+
+  // without free pages the file grows
+  CHECK(allocatePage(&fh, &pageNum));
+  ASSERT_EQUALS_INT(3, pageNum, "page appended");
+  CHECK(closePageFile(&fh));
+
+  // header page, one map page and four data pages
+  file = fopen("testbuffer.bin", "rb");
+  fseek(file, 0L, SEEK_END);
+  size = ftell(file);
+  fclose(file);
+  ASSERT_EQUALS_INT(6 * PAGE_SIZE, (int) size, "file size follows the live pages");
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(page);
+  TEST_DONE();
+}
+
+// the free map of a file larger than its map pages in the header region grows by map pages between the data pages
+void
+testFreeMapGrowth (void)
+{
+  SM_FileHandle fh;
+  struct stat status;
+  int span = 8 * PAGE_SIZE;
+  char *pages = calloc(4 * PAGE_SIZE, sizeof(char));
+  char expected[64];
+  int i, pageNum;
+  testName = "Free page map growing with the file";
+
+  // header page, map page, span data pages, a chained map page and 5 more data pages
+  createDummyFile("testbuffer.bin", 2);
+  CHECK(truncate("testbuffer.bin", (long) (2 + span + 1 + 5) * PAGE_SIZE));
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  ASSERT_EQUALS_INT(span + 5, fh.totalNumPages, "chained map page not counted");
+
+  // a run across the chained map page is split around it
+  for (i = 0; i < 4; i++)
+    sprintf(pages + i * PAGE_SIZE, "Page-%i", span - 2 + i);
+  CHECK(writeBlocks(span - 2, 4, &fh, pages));
+  memset(pages, 0, 4 * PAGE_SIZE);
+  CHECK(readBlocks(span - 2, 4, &fh, pages));
+  for (i = 0; i < 4; i++)
+    {
+      sprintf(expected, "Page-%i", span - 2 + i);
+      ASSERT_EQUALS_STRING(expected, pages + i * PAGE_SIZE, "page of a run across the map page");
+    }
+  CHECK(readBlock(span + 1, &fh, pages));
+  sprintf(expected, "Page-%i", span + 1);
+  ASSERT_EQUALS_STRING(expected, pages, "page after the map page read alone");
+
+  // pages past the map of the header region are freed and handed out again
+  CHECK(freePage(span + 2, &fh));
+  CHECK(freePage(1, &fh));
+  CHECK(closePageFile(&fh));
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  ASSERT_TRUE(isPageFree(span + 2, &fh) && isPageFree(1, &fh), "both free pages survive reopening");
+  ASSERT_TRUE(!isPageFree(span + 1, &fh), "neighbour still in use");
+  CHECK(allocatePage(&fh, &pageNum));
+  ASSERT_EQUALS_INT(1, pageNum, "free page of the first map page reused first");
+  CHECK(allocatePage(&fh, &pageNum));
+  ASSERT_EQUALS_INT(span + 2, pageNum, "free page of the chained map page reused");
+
+  // cutting off every page behind the chained map page drops the map page too
+  for (i = span + 4; i >= span; i--)
+    CHECK(freePage(i, &fh));
+  ASSERT_EQUALS_INT(span, fh.totalNumPages, "trailing free pages cut off");
+  stat("testbuffer.bin", &status);
+  ASSERT_TRUE(status.st_size == (long) (2 + span) * PAGE_SIZE, "chained map page cut off");
+  CHECK(appendEmptyBlock(&fh));
+  stat("testbuffer.bin", &status);
+  ASSERT_TRUE(status.st_size == (long) (2 + span + 2) * PAGE_SIZE, "map page back in front of the appended page");
+  CHECK(readBlock(span, &fh, pages));
+  ASSERT_EQUALS_STRING("", pages, "appended page is empty");
+  ASSERT_TRUE(!isPageFree(span, &fh), "appended page in use");
+  CHECK(closePageFile(&fh));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(pages);
+  TEST_DONE();
+}
+
+// a file created with 32 KB pages is read and cached in pages of that size
+void
+testPageSize (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  SM_FileHandle fh;
+  int pageSize = 8 * PAGE_SIZE;
+  char *page = calloc(pageSize, sizeof(char));
+  int i;
+  testName = "Page size stored in the page file";
+
+  ASSERT_TRUE(createPageFileWithSize("testbuffer.bin", 3000) == RC_INVALID_PARAMETER, "page size must be a power of two");
+  ASSERT_TRUE(createPageFileWithSize("testbuffer.bin", 2 * SM_MAX_PAGE_SIZE) == RC_INVALID_PARAMETER, "page size too large");
+
+  // every page is filled up to its last byte
+  CHECK(createPageFileWithSize("testbuffer.bin", pageSize));
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  ASSERT_EQUALS_INT(pageSize, fh.pageSize, "page size read from the header");
+  CHECK(ensureCapacity(5, &fh));
+  for (i = 0; i < 5; i++)
+    {
+      memset(page, 'a' + i, pageSize);
+      sprintf(page, "%s-%i", "Page", i);
+      CHECK(writeBlock(i, &fh, page));
+    }
+  CHECK(closePageFile(&fh));
+
+  // a pool of 3 frames evicts pages of the large size through the victim cache
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+  ASSERT_EQUALS_INT(pageSize, bm->pageSize, "frames take the page size of the file");
+  CHECK(setBufferPoolVictimCache(bm, 4 * pageSize));
+  for (i = 0; i < 10; i++)
+    {
+      CHECK(pinPage(bm, h, i % 5));
+      ASSERT_TRUE(h->data[pageSize - 1] == 'a' + i % 5, "last byte of the page");
+      CHECK(unpinPage(bm, h));
+    }
+  ASSERT_EQUALS_INT(5, getNumReadIO(bm), "second round served by the victim cache");
+
+  CHECK(pinPage(bm, h, 6));
+  h->data[pageSize - 1] = 'z';
+  CHECK(markDirty(bm, h));
+  CHECK(unpinPage(bm, h));
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  ASSERT_EQUALS_INT(7, fh.totalNumPages, "file extended by pages of the large size");
+  CHECK(readBlock(6, &fh, page));
+  ASSERT_TRUE(page[pageSize - 1] == 'z', "page written back completely");
+  CHECK(closePageFile(&fh));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(page);
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// pages of a compressed file take less disk space and read back unchanged, also through a buffer pool
+void
+testCompressedPageFile (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PinRequest request;
+  SM_FileHandle fh;
+  struct stat status;
+  char *page = calloc(PAGE_SIZE, sizeof(char));
+  char expected[64];
+  int i, j;
+  testName = "Compressed page file";
+
+  // 64 pages of repetitive text
+  CHECK(createCompressedPageFile("testbuffer.bin", PAGE_SIZE));
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  CHECK(ensureCapacity(64, &fh));
+  for (i = 0; i < 64; i++)
+    {
+      for (j = 0; j + 32 < PAGE_SIZE; j += 32)
+        sprintf(page + j, "Page-%04i customer record %03i ", i, j / 32);
+      CHECK(writeBlock(i, &fh, page));
+    }
+
+  // a page that does not shrink is stored as it is
+  srand(7);
+  for (j = 0; j < PAGE_SIZE; j++)
+    page[j] = (char) rand();
+  CHECK(writeBlock(10, &fh, page));
+  memset(page, 0, PAGE_SIZE);
+  CHECK(readBlock(10, &fh, page));
+  srand(7);
+  for (j = 0; j < PAGE_SIZE && page[j] == (char) rand(); j++)
+    ;
+  ASSERT_EQUALS_INT(PAGE_SIZE, j, "incompressible page read back");
+  CHECK(closePageFile(&fh));
+
+  stat("testbuffer.bin", &status);
+  printf("64 pages of %i bytes take %li bytes on disk\n", PAGE_SIZE, (long) status.st_blocks * 512);
+  ASSERT_TRUE((long) status.st_blocks * 512 < 64 * PAGE_SIZE / 2, "less than half of the disk space");
+
+  // reads through a buffer pool, synchronous, batched and asynchronous
+  CHECK(initBufferPool(bm, "testbuffer.bin", 8, RS_LRU, NULL));
+  CHECK(pinPage(bm, h, 5));
+  sprintf(expected, "Page-%04i customer record %03i ", 5, 0);
+  ASSERT_TRUE(strncmp(expected, h->data, strlen(expected)) == 0, "page decompressed by pinPage");
+  sprintf(expected, "Page-%04i customer record %03i ", 5, 126);
+  ASSERT_TRUE(strncmp(expected, h->data + 126 * 32, strlen(expected)) == 0, "end of the page decompressed");
+  strcpy(h->data, "Changed");
+  CHECK(markDirty(bm, h));
+  CHECK(unpinPage(bm, h));
+
+  CHECK(pinPageAsync(bm, &request, 20));
+  CHECK(awaitPinRequest(bm, &request, h));
+  sprintf(expected, "Page-%04i customer record %03i ", 20, 0);
+  ASSERT_TRUE(strncmp(expected, h->data, strlen(expected)) == 0, "page decompressed by an asynchronous read");
+  CHECK(unpinPage(bm, h));
+  CHECK(shutdownBufferPool(bm));
+
+  // the changed page was written back, freed pages give their extents back
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  CHECK(readBlock(5, &fh, page));
+  ASSERT_EQUALS_STRING("Changed", page, "page rewritten through the pool");
+  CHECK(readBlock(6, &fh, page));
+  sprintf(expected, "Page-%04i customer record %03i ", 6, 0);
+  ASSERT_TRUE(strncmp(expected, page, strlen(expected)) == 0, "neighbour of the rewritten page");
+  for (i = 63; i >= 32; i--)
+    CHECK(freePage(i, &fh));
+  ASSERT_EQUALS_INT(32, fh.totalNumPages, "pages after freeing the second half");
+  CHECK(closePageFile(&fh));
+
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  ASSERT_EQUALS_INT(32, fh.totalNumPages, "page count kept in the header");
+  CHECK(readBlock(31, &fh, page));
+  sprintf(expected, "Page-%04i customer record %03i ", 31, 0);
+  ASSERT_TRUE(strncmp(expected, page, strlen(expected)) == 0, "last page after freeing");
+  CHECK(closePageFile(&fh));
+
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(page);
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// a compressed file grows past the pages its page-mapping table and free map in the header region cover
+void
+testCompressedFileGrowth (void)
+{
+  SM_FileHandle fh;
+  char *page = calloc(PAGE_SIZE, sizeof(char));
+  int capacity = 8 * PAGE_SIZE;
+  int pageNum;
+  testName = "Compressed file growing past its table";
+
+  CHECK(createPageFileWithFlags("testmemory.bin", PAGE_SIZE, SM_IN_MEMORY | SM_COMPRESSED));
+  CHECK(openPageFile("testmemory.bin", &fh));
+  CHECK(ensureCapacity(10, &fh));
+  strcpy(page, "Before");
+  CHECK(writeBlock(5, &fh, page));
+
+  // the table and the map move to the extent area, the pages written before keep their extents
+  CHECK(ensureCapacity(capacity + 10, &fh));
+  ASSERT_EQUALS_INT(capacity + 10, fh.totalNumPages, "pages past the table in the header region");
+  strcpy(page, "After");
+  CHECK(writeBlock(capacity + 1, &fh, page));
+  CHECK(freePage(capacity + 3, &fh));
+  CHECK(readBlock(5, &fh, page));
+  ASSERT_EQUALS_STRING("Before", page, "page written before the table moved");
+  CHECK(closePageFile(&fh));
+
+  CHECK(openPageFile("testmemory.bin", &fh));
+  ASSERT_EQUALS_INT(capacity + 10, fh.totalNumPages, "page count after reopening");
+  CHECK(readBlock(capacity + 1, &fh, page));
+  ASSERT_EQUALS_STRING("After", page, "page past the old table read back");
+  CHECK(readBlock(5, &fh, page));
+  ASSERT_EQUALS_STRING("Before", page, "page before the old table read back");
+  ASSERT_TRUE(isPageFree(capacity + 3, &fh), "page past the old map is free");
+  CHECK(allocatePage(&fh, &pageNum));
+  ASSERT_EQUALS_INT(capacity + 3, pageNum, "free page past the old map reused");
+
+  // a page written to the extent area after the move does not overwrite the table
+  strcpy(page, "Later");
+  CHECK(writeBlock(capacity + 3, &fh, page));
+  CHECK(closePageFile(&fh));
+  CHECK(openPageFile("testmemory.bin", &fh));
+  CHECK(readBlock(capacity + 3, &fh, page));
+  ASSERT_EQUALS_STRING("Later", page, "page written after the move");
+  CHECK(readBlock(capacity + 1, &fh, page));
+  ASSERT_EQUALS_STRING("After", page, "other pages unchanged");
+  CHECK(closePageFile(&fh));
+
+  CHECK(destroyPageFile("testmemory.bin"));
+
+  free(page);
+  TEST_DONE();
+}
+
+// access pattern hints are accepted for plain and compressed files, cold pages are dropped from the page cache
+void
+testAccessAdvice (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  SM_FileHandle fh;
+  char *page = calloc(PAGE_SIZE, sizeof(char));
+  int advice, i;
+  testName = "Access pattern hints";
+
+  createDummyFile("testbuffer.bin", 8);
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  for (advice = SM_ADVICE_NORMAL; advice <= SM_ADVICE_DONTNEED; advice++)
+    CHECK(adviseBlocks(2, 4, &fh, (SM_AccessAdvice) advice));
+  CHECK(adviseBlocks(0, 0, &fh, SM_ADVICE_SEQUENTIAL));
+  CHECK(adviseBlocks(6, 100, &fh, SM_ADVICE_WILLNEED));
+  ASSERT_TRUE(adviseBlocks(0, 1, &fh, (SM_AccessAdvice) 9) == RC_INVALID_PARAMETER, "unknown advice rejected");
+  CHECK(readBlock(3, &fh, page));
+  ASSERT_EQUALS_STRING("Page-3", page, "page readable after DONTNEED");
+  CHECK(closePageFile(&fh));
+
+  // a cold page evicted by the pool is written back before the page cache drops it
+  CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+  for (i = 0; i < 3; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      if (i == 0)
+        {
+          strcpy(h->data, "Cold-0");
+          CHECK(markDirty(bm, h));
+        }
+      CHECK(unpinPageWithHint(bm, h, i == 0 ? EH_EVICT_SOON : EH_NONE));
+    }
+  CHECK(pinPage(bm, h, 5));
+  ASSERT_EQUALS_POOL("[5 1],[1 0],[2 0]", bm, "cold frame reclaimed first");
+  CHECK(unpinPage(bm, h));
+  CHECK(shutdownBufferPool(bm));
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  CHECK(readBlock(0, &fh, page));
+  ASSERT_EQUALS_STRING("Cold-0", page, "cold page written back");
+  CHECK(closePageFile(&fh));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  // the range of a compressed file is the range of its extents
+  CHECK(createCompressedPageFile("testbuffer.bin", PAGE_SIZE));
+  CHECK(openPageFile("testbuffer.bin", &fh));
+  CHECK(ensureCapacity(4, &fh));
+  CHECK(adviseBlocks(0, 0, &fh, SM_ADVICE_WILLNEED));
+  strcpy(page, "Compressed");
+  CHECK(writeBlock(2, &fh, page));
+  CHECK(adviseBlocks(1, 2, &fh, SM_ADVICE_DONTNEED));
+  CHECK(readBlock(2, &fh, page));
+  ASSERT_EQUALS_STRING("Compressed", page, "compressed page readable after DONTNEED");
+  CHECK(closePageFile(&fh));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(page);
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// page files of the memory backend work through the storage manager and the buffer pool without touching disk
+void
+testMemoryBackend (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  BM_PinRequest request;
+  SM_FileHandle fh;
+  struct stat status;
+  SM_FileHandle other;
+  char *page = calloc(PAGE_SIZE, sizeof(char));
+  char expected[64];
+  int i, pageNum;
+  testName = "In-memory storage backend";
+
+  CHECK(createPageFileWithFlags("testmemory.bin", PAGE_SIZE, SM_IN_MEMORY));
+  ASSERT_TRUE(stat("testmemory.bin", &status) != 0, "no file on disk");
+  CHECK(openPageFile("testmemory.bin", &fh));
+  ASSERT_EQUALS_INT(1, fh.totalNumPages, "new file has one page");
+  CHECK(ensureCapacity(10, &fh));
+  for (i = 0; i < 10; i++)
+    {
+      sprintf(page, "Memory-%i", i);
+      CHECK(writeBlock(i, &fh, page));
+    }
+  CHECK(freePage(9, &fh));
+  ASSERT_EQUALS_INT(9, fh.totalNumPages, "free page at the end cut off");
+  CHECK(allocatePage(&fh, &pageNum));
+  ASSERT_EQUALS_INT(9, pageNum, "page appended again");
+  CHECK(adviseBlocks(0, 0, &fh, SM_ADVICE_SEQUENTIAL));
+  CHECK(syncPageFile(&fh));
+  CHECK(closePageFile(&fh));
+
+  // pages are read and written back through a buffer pool, asynchronous reads complete at once
+  CHECK(initBufferPool(bm, "testmemory.bin", 3, RS_LRU, NULL));
+  for (i = 0; i < 9; i++)
+    {
+      CHECK(pinPage(bm, h, i));
+      sprintf(expected, "Memory-%i", i);
+      ASSERT_EQUALS_STRING(expected, h->data, "page read from memory");
+      sprintf(h->data, "Pool-%i", i);
+      CHECK(markDirty(bm, h));
+      CHECK(unpinPage(bm, h));
+    }
+  CHECK(pinPageAsync(bm, &request, 0));
+  CHECK(awaitPinRequest(bm, &request, h));
+  ASSERT_EQUALS_STRING("Pool-0", h->data, "asynchronous read from memory");
+  CHECK(unpinPage(bm, h));
+  CHECK(shutdownBufferPool(bm));
+
+  CHECK(openPageFile("testmemory.bin", &fh));
+  for (i = 0; i < 9; i++)
+    {
+      CHECK(readBlock(i, &fh, page));
+      sprintf(expected, "Pool-%i", i);
+      ASSERT_EQUALS_STRING(expected, page, "page written back to memory");
+    }
+
+  // a destroyed file stays readable through handles that are still open
+  CHECK(destroyPageFile("testmemory.bin"));
+  ASSERT_TRUE(openPageFile("testmemory.bin", &other) == RC_FILE_NOT_FOUND, "destroyed file not found");
+  CHECK(readBlock(4, &fh, page));
+  ASSERT_EQUALS_STRING("Pool-4", page, "open handle still reads");
+  CHECK(closePageFile(&fh));
+  ASSERT_TRUE(destroyPageFile("testmemory.bin") == RC_FILE_NOT_FOUND, "file destroyed once");
+
+  // compressed files and pages larger than PAGE_SIZE work in memory too
+  CHECK(createPageFileWithFlags("testmemory.bin", 2 * PAGE_SIZE, SM_IN_MEMORY | SM_COMPRESSED));
+  CHECK(openPageFile("testmemory.bin", &fh));
+  ASSERT_EQUALS_INT(2 * PAGE_SIZE, fh.pageSize, "page size of the memory file");
+  CHECK(ensureCapacity(4, &fh));
+  free(page);
+  page = calloc(2 * PAGE_SIZE, sizeof(char));
+  strcpy(page + PAGE_SIZE, "Compressed");
+  CHECK(writeBlock(3, &fh, page));
+  CHECK(closePageFile(&fh));
+  CHECK(openPageFile("testmemory.bin", &fh));
+  memset(page, 1, 2 * PAGE_SIZE);
+  CHECK(readBlock(3, &fh, page));
+  ASSERT_EQUALS_STRING("Compressed", page + PAGE_SIZE, "compressed page in memory");
+  CHECK(closePageFile(&fh));
+
+  // a file on disk cannot be created while a memory file has the same name, nor the other way round
+  ASSERT_TRUE(createPageFile("testmemory.bin") == RC_FILE_ALREADY_EXISTS, "disk file of a memory file name refused");
+  ASSERT_TRUE(stat("testmemory.bin", &status) != 0, "no file on disk");
+  CHECK(openPageFile("testmemory.bin", &fh));
+  ASSERT_EQUALS_INT(2 * PAGE_SIZE, fh.pageSize, "memory file kept");
+  CHECK(closePageFile(&fh));
+  CHECK(destroyPageFile("testmemory.bin"));
+  CHECK(createPageFile("testmemory.bin"));
+  ASSERT_TRUE(stat("testmemory.bin", &status) == 0, "file on disk");
+  ASSERT_TRUE(createPageFileWithFlags("testmemory.bin", PAGE_SIZE, SM_IN_MEMORY) == RC_FILE_ALREADY_EXISTS,
+      "memory file of a disk file name refused");
+  CHECK(openPageFile("testmemory.bin", &fh));
+  ASSERT_EQUALS_INT(PAGE_SIZE, fh.pageSize, "disk file opened");
+  CHECK(closePageFile(&fh));
+  CHECK(destroyPageFile("testmemory.bin"));
+  ASSERT_TRUE(openPageFile("testmemory.bin", &fh) == RC_FILE_NOT_FOUND, "no file left");
+
+  free(page);
+  free(bm);
+  free(h);
+  TEST_DONE();
+}
+
+// a run of pages written with one request, appended at the end of plain and compressed files
+void
+testWriteBlocks (void)
+{
+  SM_FileHandle fh;
+  char *pages = calloc(8 * PAGE_SIZE, sizeof(char));
+  char *page = calloc(PAGE_SIZE, sizeof(char));
+  char expected[64];
+  int flags[] = { 0, SM_COMPRESSED };
+  int i, f;
+  testName = "Writing runs of pages";
+
+  for (f = 0; f < 2; f++)
+    {
+      CHECK(createPageFileWithFlags("testbuffer.bin", PAGE_SIZE, flags[f]));
+      CHECK(openPageFile("testbuffer.bin", &fh));
+      for (i = 0; i < 8; i++)
+        sprintf(pages + i * PAGE_SIZE, "Run-%i", i);
+
+      // the run may start at the last page and grow the file, but not start past its end
+      ASSERT_TRUE(writeBlocks(2, 8, &fh, pages) == RC_WRITE_NON_EXISTING_PAGE, "run past the end rejected");
+      CHECK(writeBlocks(0, 8, &fh, pages));
+      ASSERT_EQUALS_INT(8, fh.totalNumPages, "file grown by the run");
+      ASSERT_EQUALS_INT(7, fh.curPagePos, "position at the last page of the run");
+      CHECK(writeBlocks(8, 2, &fh, pages));
+      ASSERT_EQUALS_INT(10, fh.totalNumPages, "run appended at the end");
+      CHECK(closePageFile(&fh));
+
+      CHECK(openPageFile("testbuffer.bin", &fh));
+      ASSERT_EQUALS_INT(10, fh.totalNumPages, "pages of the runs kept");
+      for (i = 0; i < 10; i++)
+        {
+          CHECK(readBlock(i, &fh, page));
+          sprintf(expected, "Run-%i", i % 8);
+          ASSERT_EQUALS_STRING(expected, page, "page of a run read back");
+        }
+      CHECK(closePageFile(&fh));
+      CHECK(destroyPageFile("testbuffer.bin"));
+    }
+
+  free(pages);
+  free(page);
+  TEST_DONE();
+}
+
+// a CLOCK pool whose frames are all pinned has no victim for another page
+void
+testClockAllPinned (void)
+{
+  BM_BufferPool *bm = MAKE_POOL();
+  BM_PageHandle *h0 = MAKE_PAGE_HANDLE();
+  BM_PageHandle *h1 = MAKE_PAGE_HANDLE();
+  BM_PageHandle *h2 = MAKE_PAGE_HANDLE();
+  BM_Stats stats;
+  testName = "CLOCK pool with every frame pinned";
+
+  createDummyFile("testbuffer.bin", 4);
+  CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_CLOCK, NULL));
+
+  CHECK(pinPage(bm, h0, 0));
+  CHECK(pinPage(bm, h1, 1));
+  CHECK(resetPoolStats(bm));
+  ASSERT_EQUALS_INT(RC_PINNED_PAGES_IN_BUFFER, pinPage(bm, h2, 2), "no victim while every frame is pinned");
+  CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(0, (int) stats.misses, "failed pin is not a miss");
+  ASSERT_EQUALS_INT(0, (int) stats.evictions, "failed pin evicts nothing");
+  ASSERT_EQUALS_POOL("[0 1],[1 1]", bm, "pool unchanged");
+  ASSERT_EQUALS_STRING("Page-0", h0->data, "pinned page keeps its content");
+  ASSERT_EQUALS_STRING("Page-1", h1->data, "pinned page keeps its content");
+
+  // once a frame is unpinned it is the victim
+  CHECK(unpinPage(bm, h0));
+  CHECK(pinPage(bm, h2, 2));
+  ASSERT_EQUALS_POOL("[2 1],[1 1]", bm, "unpinned frame replaced");
+  CHECK(getPoolStats(bm, &stats));
+  ASSERT_EQUALS_INT(1, (int) stats.misses, "miss counted once a frame is found");
+  ASSERT_EQUALS_STRING("Page-2", h2->data, "new page read");
+  ASSERT_EQUALS_STRING("Page-1", h1->data, "pinned page keeps its content");
+
+  CHECK(unpinPage(bm, h1));
+  CHECK(unpinPage(bm, h2));
+  CHECK(shutdownBufferPool(bm));
+  CHECK(destroyPageFile("testbuffer.bin"));
+
+  free(bm);
+  free(h0);
+  free(h1);
+  free(h2);
+  TEST_DONE();
+}
+
+// two pools of different sizes keep their own replacement state
+void
+testPoolsSideBySide (void)
+{
+  BM_BufferPool *small = MAKE_POOL();
+  BM_BufferPool *large = MAKE_POOL();
+  BM_PageHandle *h = MAKE_PAGE_HANDLE();
+  int i;
+  testName = "Pools of different sizes side by side";
+
+  createDummyFile("testbuffer.bin", 12);
+  createDummyFile("testbuffer2.bin", 12);
+  CHECK(initBufferPool(small, "testbuffer.bin", 3, RS_FIFO, NULL));
+  CHECK(initBufferPool(large, "testbuffer2.bin", 10, RS_LRU, NULL));
+
+  // fill both pools, page 0 of the large pool is used again in between
+  for (i = 0; i < 10; i++)
+    {
+      CHECK(pinPage(large, h, i));
+      CHECK(unpinPage(large, h));
+    }
+  for (i = 0; i < 3; i++)
+    {
+      CHECK(pinPage(small, h, i));
+      CHECK(unpinPage(small, h));
+    }
+  CHECK(pinPage(large, h, 0));
+  CHECK(unpinPage(large, h));
+
+  // the small pool replaces its oldest pages
+  for (i = 3; i < 5; i++)
+    {
+      CHECK(pinPage(small, h, i));
+      CHECK(unpinPage(small, h));
+    }
+  ASSERT_EQUALS_POOL("[3 0],[4 0],[2 0]", small, "FIFO order of the small pool");
+  ASSERT_EQUALS_STRING("Page-4", h->data, "page of the small pool");
+
+  // the large pool replaces its least recently used page
+  CHECK(pinPage(large, h, 10));
+  ASSERT_EQUALS_POOL("[0 0],[10 1],[2 0],[3 0],[4 0],[5 0],[6 0],[7 0],[8 0],[9 0]", large, "LRU order of the large pool");
+  ASSERT_EQUALS_STRING("Page-10", h->data, "page of the large pool");
+  CHECK(unpinPage(large, h));
+
+  CHECK(shutdownBufferPool(small));
+  CHECK(shutdownBufferPool(large));
+  CHECK(destroyPageFile("testbuffer.bin"));
+  CHECK(destroyPageFile("testbuffer2.bin"));
+
+  free(small);
+  free(large);
+  free(h);
+  TEST_DONE();
+}
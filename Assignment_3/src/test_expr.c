@@ -29,6 +29,7 @@
 static void testValueSerialize (void);
 static void testOperators (void);
 static void testExpressions (void);
+static void testCompiledExpressions (void);
 
 char *testName;
 
@@ -41,6 +42,7 @@ main (void)
 	testValueSerialize();
 	testOperators();
 	testExpressions();
+	testCompiledExpressions();
 
 	return 0;
 }
@@ -123,3 +125,108 @@ testExpressions (void)
 
 	TEST_DONE();
 }
+
+// ************************************************************
+void
+testCompiledExpressions (void)
+{
+	Expr *exprs[6], *l, *r, *lt, *eq;
+	CompiledExpr *compiled;
+	Record *record;
+	Value *value, *res;
+	Schema *schema;
+	char *names[] = { "a", "b", "c" };
+	DataType types[] = { DT_INT, DT_STRING, DT_FLOAT };
+	int lengths[] = { 0, 4, 0 };
+	char *strings[] = { "", "ab", "abc", "abcd" };
+	int i, j;
+	testName = "test compiled expressions";
+
+	schema = createSchema(3, names, types, lengths, 0, NULL);
+	TEST_CHECK(createRecord(&record, schema));
+
+	// a < 5
+	MAKE_ATTRREF(l, 0);
+	MAKE_CONS(r, stringToValue("i5"));
+	MAKE_BINOP_EXPR(exprs[0], l, r, OP_COMP_SMALLER);
+
+	// b = "abc", the string fills the attribute up to its length
+	MAKE_ATTRREF(l, 1);
+	MAKE_CONS(r, stringToValue("sabc"));
+	MAKE_BINOP_EXPR(exprs[1], r, l, OP_COMP_EQUAL);
+
+	// "ab" < b
+	MAKE_CONS(l, stringToValue("sab"));
+	MAKE_ATTRREF(r, 1);
+	MAKE_BINOP_EXPR(exprs[2], l, r, OP_COMP_SMALLER);
+
+	// NOT (c < 1.5) OR a = 2
+	MAKE_ATTRREF(l, 2);
+	MAKE_CONS(r, stringToValue("f1.5"));
+	MAKE_BINOP_EXPR(lt, l, r, OP_COMP_SMALLER);
+	MAKE_UNOP_EXPR(l, lt, OP_BOOL_NOT);
+	MAKE_ATTRREF(lt, 0);
+	MAKE_CONS(r, stringToValue("i2"));
+	MAKE_BINOP_EXPR(eq, lt, r, OP_COMP_EQUAL);
+	MAKE_BINOP_EXPR(exprs[3], l, eq, OP_BOOL_OR);
+
+	// (a < 3 AND b = "abcd") OR false
+	MAKE_ATTRREF(l, 0);
+	MAKE_CONS(r, stringToValue("i3"));
+	MAKE_BINOP_EXPR(lt, l, r, OP_COMP_SMALLER);
+	MAKE_ATTRREF(l, 1);
+	MAKE_CONS(r, stringToValue("sabcd"));
+	MAKE_BINOP_EXPR(eq, l, r, OP_COMP_EQUAL);
+	MAKE_BINOP_EXPR(l, lt, eq, OP_BOOL_AND);
+	MAKE_CONS(r, stringToValue("bf"));
+	MAKE_BINOP_EXPR(exprs[4], l, r, OP_BOOL_OR);
+
+	// NOT b = b
+	MAKE_ATTRREF(l, 1);
+	MAKE_ATTRREF(r, 1);
+	MAKE_BINOP_EXPR(eq, l, r, OP_COMP_EQUAL);
+	MAKE_UNOP_EXPR(exprs[5], eq, OP_BOOL_NOT);
+
+	// the compiled expressions agree with evalExpr on every record
+	for (j = 0; j < 6; j++)
+	{
+		TEST_CHECK(compileExpr(exprs[j], schema, &compiled));
+		for (i = 0; i < 8; i++)
+		{
+			value = stringToValue(i % 2 == 0 ? "i2" : "i7");
+			TEST_CHECK(setAttr(record, schema, 0, value));
+			freeVal(value);
+			MAKE_STRING_VALUE(value, strings[i % 4]);
+			TEST_CHECK(setAttr(record, schema, 1, value));
+			freeVal(value);
+			value = stringToValue(i < 4 ? "f1.0" : "f2.5");
+			TEST_CHECK(setAttr(record, schema, 2, value));
+			freeVal(value);
+
+			TEST_CHECK(evalExpr(record, schema, exprs[j], &res));
+			ASSERT_EQUALS_INT(res->v.boolV, evalCompiledExpr(compiled, record->data), "compiled expression agrees with evalExpr");
+			freeVal(res);
+		}
+		freeCompiledExpr(compiled);
+	}
+
+	// conditions that are not boolean or compare different types are rejected
+	MAKE_ATTRREF(l, 0);
+	ASSERT_TRUE(compileExpr(l, schema, &compiled) == RC_RM_EXPR_RESULT_IS_NOT_BOOLEAN, "attribute is not a condition");
+	MAKE_CONS(r, stringToValue("sabc"));
+	MAKE_BINOP_EXPR(eq, l, r, OP_COMP_EQUAL);
+	ASSERT_TRUE(compileExpr(eq, schema, &compiled) == RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "int compared with string");
+	freeExpr(eq);
+	MAKE_ATTRREF(l, 3);
+	MAKE_CONS(r, stringToValue("i1"));
+	MAKE_BINOP_EXPR(eq, l, r, OP_COMP_EQUAL);
+	ASSERT_TRUE(compileExpr(eq, schema, &compiled) == RC_INVALID_ATTRIBUTE_NUM, "attribute out of range");
+	freeExpr(eq);
+
+	for (j = 0; j < 6; j++)
+		freeExpr(exprs[j]);
+	freeRecord(record);
+	free(schema);
+
+	TEST_DONE();
+}